@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <span>
+
+#include "app/engine/sample_codec.h"
+
+namespace recorder
+{
+
+// Stores recorded audio in `Memory`, a SampleMemory of Codec::Word, through
+// `Codec`. Samples are encoded a frame at a time as they are appended, and
+// decoded a frame at a time into the reading cursor's cache, so engines see
+// plain float samples either way.
+template <typename Codec, typename Memory>
+class CodedMemory
+{
+public:
+    using Word = Codec::Word;
+    static constexpr uint32_t kFrameLength = Codec::kFrameLength;
+    static constexpr uint32_t kFrameWords = Codec::kFrameWords;
+
+    CodedMemory(Memory& memory) : memory_{memory} {}
+
+    void StartRecording(void)
+    {
+        memory_.StartRecording();
+        encoder_.Reset();
+        num_pending_ = 0;
+        revision_++;
+    }
+
+    void Append(std::span<const float> samples)
+    {
+        while (!samples.empty())
+        {
+            uint32_t count = std::min<uint32_t>(samples.size(),
+                kFrameLength - num_pending_);
+            std::copy_n(samples.data(), count, &pending_[num_pending_]);
+            samples = samples.subspan(count);
+            num_pending_ += count;
+
+            if (num_pending_ == kFrameLength)
+            {
+                Encode();
+            }
+        }
+    }
+
+    void Append(float sample)
+    {
+        Append(std::span<const float>(&sample, 1));
+    }
+
+    // The last frame is padded with silence. SampleMemory trims the end of
+    // the recording in words, which removes a little more than intended for
+    // the compressed codecs.
+    void StopRecording(void)
+    {
+        if (num_pending_)
+        {
+            std::fill(&pending_[num_pending_], &pending_[kFrameLength], 0.f);
+            Encode();
+        }
+
+        memory_.StopRecording();
+    }
+
+    // In samples, rounded down to whole frames
+    uint32_t length(void)
+    {
+        return memory_.length() / kFrameWords * kFrameLength;
+    }
+
+    // Reads decoded samples. The two most recent frames are kept decoded, so
+    // interpolating across a frame boundary in either direction doesn't
+    // decode the same frame over and over.
+    class Cursor
+    {
+    public:
+        Cursor(CodedMemory* memory) :
+            memory_(memory),
+            words_(memory->memory_.cursor())
+        {
+        }
+
+        void Seek(uint32_t index)
+        {
+            index_ = index;
+            uint32_t frame = index / kFrameLength;
+
+            if (frame != frames_[current_] || revision_ != memory_->revision_)
+            {
+                Load(frame);
+            }
+        }
+
+        Cursor& operator++()
+        {
+            Seek(index_ + 1);
+            return *this;
+        }
+
+        Cursor& operator--()
+        {
+            Seek(index_ - 1);
+            return *this;
+        }
+
+        float operator*() const
+        {
+            return cache_[current_][index_ % kFrameLength];
+        }
+
+        uint32_t index(void) const
+        {
+            return index_;
+        }
+
+    protected:
+        static constexpr uint32_t kNoFrame = UINT32_MAX;
+
+        CodedMemory* memory_;
+        Memory::Cursor words_;
+        float cache_[2][kFrameLength];
+        uint32_t frames_[2] = {kNoFrame, kNoFrame};
+        uint32_t current_ = 0;
+        uint32_t index_ = 0;
+        uint32_t revision_ = 0;
+
+        void Load(uint32_t frame)
+        {
+            if (revision_ != memory_->revision_)
+            {
+                frames_[0] = frames_[1] = kNoFrame;
+                revision_ = memory_->revision_;
+            }
+
+            current_ ^= 1;
+
+            if (frames_[current_] != frame)
+            {
+                // Past the end of the memory the words are left as zeros
+                Word words[kFrameWords] = {};
+                words_.Seek(frame * kFrameWords);
+                words_.Read(std::span<Word>(words, kFrameWords));
+                Codec::Decode(words, cache_[current_]);
+                frames_[current_] = frame;
+            }
+        }
+    };
+
+    Cursor cursor(void)
+    {
+        return Cursor(this);
+    }
+
+protected:
+    Memory& memory_;
+    Codec::Encoder encoder_;
+    float pending_[kFrameLength];
+    uint32_t num_pending_ = 0;
+    uint32_t revision_ = 0;         // Invalidates cursor caches
+
+    void Encode(void)
+    {
+        Word words[kFrameWords];
+        encoder_.Encode(pending_, words);
+        memory_.Append(std::span<const Word>(words, kFrameWords));
+        num_pending_ = 0;
+    }
+};
+
+}
@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #include "app/engine/envelope_follower.h"
+#include "util/fastmath.h"
 
 namespace recorder
 {
@@ -29,12 +30,10 @@ public:
     float Process(float in)
     {
         float envelope = follower_.Process(in * pregain_);
-        float sense = 20 * std::log10(envelope);
+        float sense = GainToDb(envelope);
 
         float gain = Compression(sense);
-        // TODO: can probably use a rougher exponential approximation since gain
-        // is usually small
-        return in * std::pow(10.0, gain / 20);
+        return in * DbToGain(gain);
     }
 
 protected:
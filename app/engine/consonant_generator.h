@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cmath>
-#include <cstdlib> // For rand()
 #include <array>
 
+#include "common/config.h"
+#include "util/random.h"
+#include "util/fastmath.h"
+
 //-------------------------------------------------------------------------------------------
 // Example: Basic 2nd-order filter for shaping the burst noise according to place of articulation
 //-------------------------------------------------------------------------------------------
@@ -67,6 +70,11 @@ public:
         Reset();
     }
 
+    void Seed(uint32_t seed)
+    {
+        random_.Seed(seed);
+    }
+
     // Set up a new consonant to be generated
     // durations (in seconds), amplitude, fundamental frequency, etc.
     void Start(ConsonantType type,
@@ -176,7 +184,7 @@ private:
     float GenerateClosureSample()
     {
         // partial voicing: small amplitude sine wave (or glottal model)
-        float sample = amplitude_ * 0.1f * std::sin(2.0f * M_PI * f0_ * phase_);
+        float sample = amplitude_ * 0.1f * recorder::Sin(2.0f * M_PI * f0_ * phase_);
         AdvancePhase();
         return sample;
     }
@@ -184,7 +192,7 @@ private:
     float GenerateBurstSample()
     {
         // White noise filtered by place-of-articulation filter
-        float rawNoise = static_cast<float>(std::rand()) / RAND_MAX * 2.0f - 1.0f;
+        float rawNoise = random_.NextBipolar();
         float shapedNoise = burstFilter_.Process(rawNoise);
         // Envelope shape: quickly rise and fall. Here we do a simple linear fade
         float env = 1.0f - (static_cast<float>(sampleCounter_) / static_cast<float>(burstSamples_));
@@ -195,7 +203,7 @@ private:
     float GenerateTransitionSample()
     {
         // Voice with a simple tilt factor to simulate place-of-articulation formant transition
-        float voice = amplitude_ * std::sin(2.0f * M_PI * f0_ * phase_);
+        float voice = amplitude_ * recorder::Sin(2.0f * M_PI * f0_ * phase_);
         // apply a simple tilt or filter factor
         voice *= (1.0f + transitionFilterFactor_);
         // fade-out or fade-in approach over the transition
@@ -287,7 +295,8 @@ private:
     //---------------------------------------------------------------------------------------
     // Internal members
     //---------------------------------------------------------------------------------------
-    float sampleRate_    = 44100.0f;
+    float sampleRate_    = recorder::kAudioSampleRate;
+    recorder::Random random_;
     ConsonantType type_  = ConsonantType::NONE;
 
     float f0_            = 100.0f; // fundamental frequency
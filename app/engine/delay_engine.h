@@ -12,6 +12,7 @@
 namespace recorder
 {
 
+template <uint32_t sample_rate = kAudioSampleRateHz>
 class DelayEngine
 {
 public:
@@ -24,14 +25,14 @@ public:
         float decay_ms = 250;
         float hold_ms = 100;
         compressor_.Init(threshold_dB, ratio, softness,
-            attack_ms, decay_ms, hold_ms, kAudioSampleRate);
+            attack_ms, decay_ms, hold_ms, kSampleRate);
 
         attack_ms = 10;
         decay_ms = kMinDelay * 1000;
         hold_ms = kMaxDelay * 1000;
-        follower_.Init(attack_ms, decay_ms, hold_ms, kAudioSampleRate);
+        follower_.Init(attack_ms, decay_ms, hold_ms, kSampleRate);
 
-        delay_time_lpf_.Init(10, kAudioSampleRate);
+        delay_time_lpf_.Init(10, kSampleRate);
 
         Reset();
     }
@@ -56,7 +57,7 @@ public:
         delay = delay_time_lpf_.Process(delay);
         float time = kMinDelay + delay * (kMaxDelay - kMinDelay);
         time = std::clamp<float>(time, kMinDelay, kMaxDelay);
-        float delay_samples = time * kAudioSampleRate;
+        float delay_samples = time * kSampleRate;
 
         uint32_t i_a = ReadIndex(static_cast<uint32_t>(delay_samples));
         uint32_t i_b = ReadIndex(static_cast<uint32_t>(delay_samples + 1));
@@ -79,13 +80,14 @@ public:
     }
 
 protected:
+    static constexpr float kSampleRate = sample_rate;
     static constexpr float kMinDelay = 0.1;
     static constexpr float kMaxDelay = 1.0;
     static constexpr float kMaxFeedback = 1.0;
     static constexpr float kTrailThreshold = std::pow(10.0, -60.0 / 20.0);
 
     static constexpr uint32_t kBufferSize = std::round(std::exp2(std::ceil(
-        std::log2(kMaxDelay * kAudioSampleRate + 1))));
+        std::log2(kMaxDelay * kSampleRate + 1))));
     float buffer_[kBufferSize];
     uint32_t write_head_;
     Compressor compressor_;
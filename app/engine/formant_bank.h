@@ -0,0 +1,256 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+#include "common/config.h"
+#include "app/engine/formant_table.h"
+#include "util/fastmath.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace recorder
+{
+
+// A bank of N parallel bandpass filters fed by the same input, with their
+// outputs mixed by a per-filter gain. Coefficients and state are kept as
+// struct-of-arrays padded to a multiple of 4 lanes so every filter is
+// processed in lockstep: with SSE/NEON on host builds, and as independent
+// scalar lanes on the Cortex-M7, which the compiler can interleave to keep
+// both FPU issue slots busy. Padding lanes have zero coefficients and gain,
+// so a 4th formant costs no more than 3.
+//
+// The NEON path, for ARM hosts, has not been built or run. bench and regress
+// exercise the SSE path on x86 hosts; the scalar path is the device's.
+//
+// All filters are RBJ bandpasses (b1 = 0, b2 = -b0), which lets them share
+// one input history and compute b0 * (x[n] - x[n-2]) with a single multiply.
+template <uint32_t N>
+class FormantBank
+{
+public:
+    static constexpr uint32_t kNumLanes = (N + 3) / 4 * 4;
+
+    void Init(float sampleRate)
+    {
+        sampleRate_ = sampleRate;
+        ramp_remaining_ = 0;
+
+        for (uint32_t i = 0; i < kNumLanes; i++)
+        {
+            b0_[i] = a1_[i] = a2_[i] = 0.0f;
+            target_b0_[i] = target_a1_[i] = target_a2_[i] = 0.0f;
+            gain_[i] = 0.0f;
+        }
+
+        Reset();
+    }
+
+    void Reset(void)
+    {
+        x1_ = x2_ = 0.0f;
+
+        for (uint32_t i = 0; i < kNumLanes; i++)
+        {
+            y1_[i] = y2_[i] = 0.0f;
+        }
+    }
+
+    void SetGain(uint32_t i, float gain)
+    {
+        gain_[i] = gain;
+    }
+
+    // Jump straight to the coefficients for (centerFrequency, Q), cancelling
+    // any ramp in progress
+    void SetParameters(uint32_t i, float centerFrequency, float Q)
+    {
+        ramp_remaining_ = 0;
+        Design(i, centerFrequency, Q);
+        b0_[i] = target_b0_[i];
+        a1_[i] = target_a1_[i];
+        a2_[i] = target_a2_[i];
+    }
+
+    // Set the coefficients that the next call to Ramp() will glide towards
+    void SetTarget(uint32_t i, float centerFrequency, float Q)
+    {
+        Design(i, centerFrequency, Q);
+    }
+
+    // Glide every filter linearly from its current coefficients to its
+    // target over the next `samples` calls to Process(). Both endpoints are
+    // stable and the stability region of (a1, a2) is convex, so every
+    // intermediate filter is stable too.
+    void Ramp(uint32_t samples)
+    {
+        samples = (samples < 1) ? 1 : samples;
+        float step = 1.0f / samples;
+
+        for (uint32_t i = 0; i < kNumLanes; i++)
+        {
+            delta_b0_[i] = (target_b0_[i] - b0_[i]) * step;
+            delta_a1_[i] = (target_a1_[i] - a1_[i]) * step;
+            delta_a2_[i] = (target_a2_[i] - a2_[i]) * step;
+        }
+
+        ramp_remaining_ = samples;
+        StepRamp();
+    }
+
+    float Process(float input)
+    {
+        float x = input - x2_;
+        x2_ = x1_;
+        x1_ = input;
+
+        float output = ProcessLanes(x);
+
+        if (ramp_remaining_)
+        {
+            StepRamp();
+        }
+
+        return output;
+    }
+
+protected:
+#if defined(__SSE__)
+    float ProcessLanes(float x)
+    {
+        __m128 in = _mm_set1_ps(x);
+        __m128 sum = _mm_setzero_ps();
+
+        for (uint32_t i = 0; i < kNumLanes; i += 4)
+        {
+            __m128 y1 = _mm_load_ps(&y1_[i]);
+            __m128 y2 = _mm_load_ps(&y2_[i]);
+            __m128 y0 = _mm_mul_ps(_mm_load_ps(&b0_[i]), in);
+            y0 = _mm_sub_ps(y0, _mm_mul_ps(_mm_load_ps(&a1_[i]), y1));
+            y0 = _mm_sub_ps(y0, _mm_mul_ps(_mm_load_ps(&a2_[i]), y2));
+            _mm_store_ps(&y2_[i], y1);
+            _mm_store_ps(&y1_[i], y0);
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(&gain_[i]), y0));
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, sum);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+#elif defined(__ARM_NEON)
+    float ProcessLanes(float x)
+    {
+        float32x4_t in = vdupq_n_f32(x);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+
+        for (uint32_t i = 0; i < kNumLanes; i += 4)
+        {
+            float32x4_t y1 = vld1q_f32(&y1_[i]);
+            float32x4_t y2 = vld1q_f32(&y2_[i]);
+            float32x4_t y0 = vmulq_f32(vld1q_f32(&b0_[i]), in);
+            y0 = vmlsq_f32(y0, vld1q_f32(&a1_[i]), y1);
+            y0 = vmlsq_f32(y0, vld1q_f32(&a2_[i]), y2);
+            vst1q_f32(&y2_[i], y1);
+            vst1q_f32(&y1_[i], y0);
+            sum = vmlaq_f32(sum, vld1q_f32(&gain_[i]), y0);
+        }
+
+        float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        return vget_lane_f32(vpadd_f32(pair, pair), 0);
+    }
+#else
+    float ProcessLanes(float x)
+    {
+        // Four independent accumulators so the lanes don't serialize on the
+        // final sum
+        float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+        for (uint32_t i = 0; i < kNumLanes; i += 4)
+        {
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                float y1 = y1_[i + j];
+                float y0 = b0_[i + j] * x - a1_[i + j] * y1 - a2_[i + j] * y2_[i + j];
+                y2_[i + j] = y1;
+                y1_[i + j] = y0;
+                sum[j] += gain_[i + j] * y0;
+            }
+        }
+
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    }
+#endif
+
+    void StepRamp(void)
+    {
+        if (--ramp_remaining_ == 0)
+        {
+            // Land exactly on the target to avoid accumulated rounding error
+            for (uint32_t i = 0; i < kNumLanes; i++)
+            {
+                b0_[i] = target_b0_[i];
+                a1_[i] = target_a1_[i];
+                a2_[i] = target_a2_[i];
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < kNumLanes; i++)
+            {
+                b0_[i] += delta_b0_[i];
+                a1_[i] += delta_a1_[i];
+                a2_[i] += delta_a2_[i];
+            }
+        }
+    }
+
+    void Design(uint32_t i, float centerFrequency, float Q)
+    {
+        if (kEnableFormantTable)
+        {
+            FormantTable::Coefficients c =
+                FormantTable::Lookup(centerFrequency / sampleRate_, Q);
+
+            target_b0_[i] = c.b0;
+            target_a1_[i] = c.a1;
+            target_a2_[i] = c.a2;
+        }
+        else
+        {
+            float omega = 2.0f * M_PI * centerFrequency / sampleRate_;
+            float alpha = Sin(omega) / (2.0f * Q);
+            float a0 = 1.0f + alpha;
+
+            target_b0_[i] = alpha / a0;
+            target_a1_[i] = -2.0f * Cos(omega) / a0;
+            target_a2_[i] = (1.0f - alpha) / a0;
+        }
+    }
+
+    float sampleRate_;
+
+    // Shared input history
+    float x1_, x2_;
+
+    // Per-lane coefficients, state and output gains
+    alignas(16) float b0_[kNumLanes];
+    alignas(16) float a1_[kNumLanes];
+    alignas(16) float a2_[kNumLanes];
+    alignas(16) float y1_[kNumLanes];
+    alignas(16) float y2_[kNumLanes];
+    alignas(16) float gain_[kNumLanes];
+
+    // Coefficient ramp state
+    float target_b0_[kNumLanes];
+    float target_a1_[kNumLanes];
+    float target_a2_[kNumLanes];
+    float delta_b0_[kNumLanes];
+    float delta_a1_[kNumLanes];
+    float delta_a2_[kNumLanes];
+    uint32_t ramp_remaining_;
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "formant_biquad.h"
+#include "formant_bank.h"
+#include <cstdint>
 #include <cmath>
 
 namespace recorder
@@ -71,15 +72,32 @@ namespace recorder
             SetVowel(VOWEL_A);
 
             // Initialize the filters with the current frequencies and Qs
-            for (int i = 0; i < 3; ++i)
+            filters_.Init(sampleRate_);
+            for (uint32_t i = 0; i < kNumFormants; ++i)
             {
                 currentFormantFreqs_[i] = targetFormantFreqs_[i];
                 currentFormantQs_[i] = targetFormantQs_[i];
-                filters_[i].Init(BANDPASS, sampleRate_, currentFormantFreqs_[i], currentFormantQs_[i]);
+                filters_.SetParameters(i, currentFormantFreqs_[i], currentFormantQs_[i]);
+                filters_.SetGain(i, kFormantGains[i]);
             }
 
             // Set a default formant rate
             formantRate_ = 0.002f;
+
+            // Default to updating the coefficients every sample
+            controlPeriod_ = 1;
+            controlCounter_ = 0;
+            UpdateControlRate();
+        }
+
+        // Evaluate the formant targets once every `period` samples and ramp
+        // the biquad coefficients linearly in between. A period of 1 gives
+        // the original per-sample behavior.
+        void SetControlPeriod(uint32_t period)
+        {
+            controlPeriod_ = (period < 1) ? 1 : period;
+            controlCounter_ = 0;
+            UpdateControlRate();
         }
 
         // Set the filter mode (normal or wah)
@@ -137,11 +155,43 @@ namespace recorder
         // Function to set the formant morphing rate
         void SetFormantRate(float rate)
         {
-            formantRate_ = rate;
+            if (rate != formantRate_)
+            {
+                formantRate_ = rate;
+                UpdateControlRate();
+            }
         }
 
         // Method to smoothly update parameters towards the target formant values
         void UpdateParameters()
+        {
+            if (controlPeriod_ > 1)
+            {
+                if (controlCounter_ == 0)
+                {
+                    UpdateTargets();
+                    StepFormants(controlRate_, controlPeriod_);
+                    controlCounter_ = controlPeriod_;
+                }
+
+                controlCounter_--;
+            }
+            else
+            {
+                UpdateTargets();
+                StepFormants(formantRate_, 1);
+            }
+        }
+
+        // Process a single audio sample. The bank sums the formant outputs
+        // weighted by kFormantGains.
+        float Process(float input)
+        {
+            return filters_.Process(input);
+        }
+
+    private:
+        void UpdateTargets()
         {
             // If in wah mode, first compute the new "target" by interpolating between /a/ and /ou/
             if (filterMode_ == FILTER_MODE_WAH)
@@ -160,45 +210,68 @@ namespace recorder
                 targetFormantQs_[2] = vowelA.Q3 + wahPosition_ * (vowelOU.Q3 - vowelA.Q3);
             }
 
-            // Smoothly move current formants toward the target formants
-            for (int i = 0; i < 3; ++i)
+        }
+
+        // Smoothly move current formants toward the target formants. `rate`
+        // is the smoothing factor for a step of `samples` samples.
+        void StepFormants(float rate, uint32_t samples)
+        {
+            for (uint32_t i = 0; i < kNumFormants; ++i)
             {
                 float freqDiff = targetFormantFreqs_[i] - currentFormantFreqs_[i];
-                currentFormantFreqs_[i] += freqDiff * formantRate_;
+                currentFormantFreqs_[i] += freqDiff * rate;
 
                 float qDiff = targetFormantQs_[i] - currentFormantQs_[i];
-                currentFormantQs_[i] += qDiff * formantRate_;
+                currentFormantQs_[i] += qDiff * rate;
 
                 // Update the filter parameters
-                filters_[i].SetParameters(
-                    currentFormantFreqs_[i] * freq_mult_,
-                    currentFormantQs_[i] * q_mult_);
+                if (samples > 1)
+                {
+                    filters_.SetTarget(i,
+                        currentFormantFreqs_[i] * freq_mult_,
+                        currentFormantQs_[i] * q_mult_);
+                }
+                else
+                {
+                    filters_.SetParameters(i,
+                        currentFormantFreqs_[i] * freq_mult_,
+                        currentFormantQs_[i] * q_mult_);
+                }
+            }
+
+            if (samples > 1)
+            {
+                filters_.Ramp(samples);
             }
         }
 
-        // Process a single audio sample
-        float Process(float input)
+        // Applying the one-pole smoothing N times in a row is the same as
+        // applying it once with rate 1 - (1 - rate)^N.
+        void UpdateControlRate()
         {
-            float output1 = filters_[0].Process(input);
-            float output2 = filters_[1].Process(input);
-            float output3 = filters_[2].Process(input);
-
-            // Sum the outputs and apply a gain factor
-            float output = (output1 + output2 * 0.3f + output3 * 0.3f);
-            return output;
+            controlRate_ = -std::expm1(controlPeriod_ * std::log1p(-formantRate_));
         }
 
-    private:
+        static constexpr uint32_t kNumFormants = 3;
+
+        // Output mix of F1, F2 and F3
+        static constexpr float kFormantGains[kNumFormants] = {1.0f, 0.3f, 0.3f};
+
         float sampleRate_;
-        FormantBiquad filters_[3];
+        FormantBank<kNumFormants> filters_;
 
-        float currentFormantFreqs_[3];
-        float targetFormantFreqs_[3];
-        float currentFormantQs_[3];
-        float targetFormantQs_[3];
+        float currentFormantFreqs_[kNumFormants];
+        float targetFormantFreqs_[kNumFormants];
+        float currentFormantQs_[kNumFormants];
+        float targetFormantQs_[kNumFormants];
 
         float formantRate_; // Rate for morphing toward target freq/Q
 
+        // Control-rate coefficient updates
+        uint32_t controlPeriod_;  // Samples between formant target updates
+        uint32_t controlCounter_; // Samples until the next update
+        float controlRate_;       // formantRate_ compounded over one period
+
         // Multipliers for freq and Q
         float q_mult_ = 1.0f;
         float freq_mult_ = 1.0f;
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#include "common/config.h"
+#include "util/fastmath.h"
+
+// GCC evaluates std::sin, std::cos and std::exp2 in constant expressions
+// as an extension. Elsewhere the table is built during static
+// initialization instead, and the tolerance isn't checked at compile time.
+#if defined(__GNUC__) && !defined(__clang__)
+#define FORMANT_TABLE_CONSTEXPR constexpr
+#else
+#define FORMANT_TABLE_CONSTEXPR
+#endif
+
+namespace recorder
+{
+
+// Bandpass coefficients (RBJ, constant 0 dB peak gain) tabulated at compile
+// time over a grid of log2(frequency / sample rate) x 1/Q, so the formant
+// filters can be retuned with a lookup instead of sin/cos/divide.
+// The coefficients are close to linear in 1/Q, so that axis needs only a
+// handful of points. The bandpass has b1 = 0 and b2 = -b0, so only b0, a1
+// and a2 are stored. Inputs outside the grid are clamped to its edges.
+class FormantTable
+{
+public:
+    struct Coefficients
+    {
+        float b0, a1, a2;
+    };
+
+    static constexpr uint32_t kFreqSize = kFormantTableFreqSize;
+    static constexpr uint32_t kQSize = kFormantTableQSize;
+
+    // Grid extents. Frequency is in octaves, -8 is fs / 256 (62.5 Hz at
+    // 16 kHz) and -1 is Nyquist. Q runs from 1 to 64.
+    static constexpr float kMinLog2Freq = -8;
+    static constexpr float kMaxLog2Freq = -1;
+    static constexpr float kMinInvQ = 1.f / 64;
+    static constexpr float kMaxInvQ = 1;
+
+    static_assert(kFreqSize >= 4 && kQSize >= 2,
+        "Table needs 4 frequencies and 2 Qs");
+
+    // `frequency` is normalized to the sample rate
+    static Coefficients Lookup(float frequency, float Q)
+    {
+        float x = (fastmath::Log2(frequency) - kMinLog2Freq) * kFreqScale;
+        float y = (1.f / Q - kMinInvQ) * kQScale;
+        return Interpolate(Clamp(x, kFreqSize - 1), Clamp(y, kQSize - 1));
+    }
+
+    // Reference design, as in FormantBank::Design
+    static FORMANT_TABLE_CONSTEXPR Coefficients Exact(double log2_freq, double inv_Q)
+    {
+        double omega = 2 * double(M_PI) * std::exp2(log2_freq);
+        double alpha = std::sin(omega) * inv_Q / 2;
+        double a0 = 1 + alpha;
+
+        return
+        {
+            .b0 = float(alpha / a0),
+            .a1 = float(-2 * std::cos(omega) / a0),
+            .a2 = float((1 - alpha) / a0),
+        };
+    }
+
+    // Largest coefficient error of the interpolated table against the exact
+    // design, probed at the centre of every cell. host/formant_report
+    // sweeps points between the grid's as well.
+    static FORMANT_TABLE_CONSTEXPR float MaxError(void)
+    {
+        float error = 0;
+
+        for (uint32_t i = 0; i < kFreqSize - 1; i++)
+        {
+            for (uint32_t j = 0; j < kQSize - 1; j++)
+            {
+                Coefficients table = Interpolate(i + 0.5f, j + 0.5f);
+                Coefficients exact = Exact(
+                    kMinLog2Freq + (i + 0.5f) / kFreqScale,
+                    kMinInvQ + (j + 0.5f) / kQScale);
+
+                error = std::max(error, std::fabs(table.b0 - exact.b0));
+                error = std::max(error, std::fabs(table.a1 - exact.a1));
+                error = std::max(error, std::fabs(table.a2 - exact.a2));
+            }
+        }
+
+        return error;
+    }
+
+protected:
+    static constexpr float kFreqScale =
+        (kFreqSize - 1) / (kMaxLog2Freq - kMinLog2Freq);
+    static constexpr float kQScale =
+        (kQSize - 1) / (kMaxInvQ - kMinInvQ);
+
+    struct Table
+    {
+        Coefficients data[kFreqSize][kQSize];
+    };
+
+    static FORMANT_TABLE_CONSTEXPR Table Generate(void)
+    {
+        Table table = {};
+
+        for (uint32_t i = 0; i < kFreqSize; i++)
+        {
+            for (uint32_t j = 0; j < kQSize; j++)
+            {
+                table.data[i][j] = Exact(
+                    kMinLog2Freq + float(i) / kFreqScale,
+                    kMinInvQ + float(j) / kQScale);
+            }
+        }
+
+        return table;
+    }
+
+    static FORMANT_TABLE_CONSTEXPR float Clamp(float x, float max)
+    {
+        return (x > 0) ? ((x < max) ? x : max) : 0;
+    }
+
+    // At grid position (x, y): linear in 1/Q, and cubic in frequency through
+    // the four nearest points, where the curvature of cos() would otherwise
+    // take a much finer grid
+    static FORMANT_TABLE_CONSTEXPR Coefficients Interpolate(float x, float y)
+    {
+        uint32_t j = y;
+        j = (j < kQSize - 1) ? j : kQSize - 2;
+        float fy = y - j;
+
+        uint32_t i = x;
+        i = (i < 1) ? 0 : ((i - 1 < kFreqSize - 4) ? i - 1 : kFreqSize - 4);
+        float t = x - i;
+
+        // Lagrange weights for points at 0, 1, 2 and 3
+        float w[4] =
+        {
+            -(t - 1) * (t - 2) * (t - 3) / 6,
+            t * (t - 2) * (t - 3) / 2,
+            -t * (t - 1) * (t - 3) / 2,
+            t * (t - 1) * (t - 2) / 6,
+        };
+
+        Coefficients c = {0, 0, 0};
+
+        for (uint32_t k = 0; k < 4; k++)
+        {
+            const Coefficients &c0 = kTable.data[i + k][j];
+            const Coefficients &c1 = kTable.data[i + k][j + 1];
+            c.b0 += w[k] * (c0.b0 + (c1.b0 - c0.b0) * fy);
+            c.a1 += w[k] * (c0.a1 + (c1.a1 - c0.a1) * fy);
+            c.a2 += w[k] * (c0.a2 + (c1.a2 - c0.a2) * fy);
+        }
+
+        return c;
+    }
+
+    static const Table kTable;
+};
+
+inline FORMANT_TABLE_CONSTEXPR const FormantTable::Table FormantTable::kTable =
+    FormantTable::Generate();
+
+#if defined(__GNUC__) && !defined(__clang__)
+static_assert(FormantTable::MaxError() < kFormantTableTolerance,
+    "Formant table is too coarse for the configured tolerance");
+#endif
+
+}
+
+#undef FORMANT_TABLE_CONSTEXPR
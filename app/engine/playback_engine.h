@@ -3,9 +3,11 @@
 #include <cstdint>
 
 #include "common/config.h"
+#include "common/io.h"
+#include "util/fastmath.h"
 #include "app/engine/sample_player.h"
 #include "app/engine/delay_engine.h"
-#include "app/engine/aafilter.h"
+#include "app/engine/upsampler.h"
 #include "app/engine/resonant_filter.h"
 #include "app/engine/ring_modulator.h"
 #include "app/engine/biquad.h"
@@ -23,11 +25,11 @@ namespace recorder
         {
             sample_player_.Init();
             delay_.Init();
-            aa_filter_.Init();
-            res_filter_.Init(16000, 700, 10);
-            ring_mod_.Init(16000, 400, .7);
+            upsampler_.Init();
+            res_filter_.Init(kAudioSampleRate, 700, 10);
+            ring_mod_.Init(kAudioSampleRate, 400, .7);
             // below is the filter responsible for boosting level in certain freq ranges (vocals, kalimba, etc), currently commented out here and on line 184. Arguments are Init(samplerate, freq, Q, db boost) and SetParameters(freq, Q, dbBoost).
-            main_filter_.Init(16000, 900, .5, 10);
+            main_filter_.Init(kAudioSampleRate, 900, .5, 10);
             main_filter_.SetParameters(900, .5, 10);
             Reset();
         }
@@ -39,7 +41,7 @@ namespace recorder
             cue_stop_ = false;
             sample_player_.Reset();
             delay_.Reset();
-            aa_filter_.Reset();
+            upsampler_.Reset();
         }
 
         bool playing(void)
@@ -57,6 +59,17 @@ namespace recorder
             return state_ == STATE_STOPPED;
         }
 
+        // The player's direction and speed, for SampleMemory::ServiceStream()
+        bool reverse(void) const
+        {
+            return sample_player_.reverse();
+        }
+
+        float speed(void) const
+        {
+            return sample_player_.speed();
+        }
+
         void Play(void)
         {
             cue_play_ = true;
@@ -106,9 +119,32 @@ namespace recorder
         {
             ringModOn = ring;
         }
+
+        struct ControlSnapshot
+        {
+            bool loop;
+            bool reverse;
+            PotInput pot;
+        };
+
         void Process(float (&block)[kAudioOSFactor], bool loop, bool reverse,
                      const PotInput &pot)
         {
+            ControlSnapshot controls =
+            {
+                .loop = loop,
+                .reverse = reverse,
+                .pot = pot,
+            };
+
+            ProcessBlock(block, 1, controls);
+        }
+
+        // Renders frames * kAudioOSFactor oversampled values into out. The
+        // pot mapping is evaluated once per block.
+        void ProcessBlock(float *out, size_t frames, const ControlSnapshot &controls)
+        {
+            const PotInput &pot = controls.pot;
             float pitch;
             if (state_ != STATE_SCRUBBING)
             {
@@ -118,7 +154,30 @@ namespace recorder
             {
                 pitch = 1.0;
             }
-            float speed = std::exp2(pitch);
+            float speed = Exp2(pitch);
+            float delay = pot[kPotDelayTime];
+            float feedback = pot[kPotDelayFeedback];
+
+            for (size_t n = 0; n < frames; n++)
+            {
+                float sample = RenderSample(speed, controls.loop,
+                    controls.reverse, delay, feedback);
+                sample *= kAudioOSFactor * kAudioOutputLevel;
+
+                upsampler_.Process(sample, out);
+                out += kAudioOSFactor;
+            }
+        }
+
+    protected:
+        float mapFloat(float x, float in_min, float in_max, float out_min, float out_max)
+        {
+            return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+        }
+
+        float RenderSample(float speed, bool loop, bool reverse,
+                           float delay, float feedback)
+        {
             float sample = 0;
 
             if (state_ == STATE_STOPPED)
@@ -171,8 +230,6 @@ namespace recorder
 
                 if (kEnableDelay)
                 {
-                    float delay = pot[kPotDelayTime];
-                    float feedback = pot[kPotDelayFeedback];
                     sample = delay_.Process(sample, delay, feedback);
                 }
             }
@@ -184,20 +241,9 @@ namespace recorder
             }
 
             // sample = main_filter_.Process(sample); //main filter, used to boost output in certain frequency ranges for different units (vocal, kalimba, etc.)
-            sample *= kAudioOSFactor * kAudioOutputLevel;
-
-            for (uint32_t i = 0; i < kAudioOSFactor; i++)
-            {
-                sample = aa_filter_.Process((i == 0) ? sample : 0);
-                block[i] = sample;
-            }
+            return sample;
         }
 
-    protected:
-        float mapFloat(float x, float in_min, float in_max, float out_min, float out_max)
-        {
-            return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
-        }
         enum State
         {
             STATE_STOPPED,
@@ -211,11 +257,11 @@ namespace recorder
         State state_;
         bool cue_play_;
         bool cue_stop_;
-        DelayEngine delay_;
+        DelayEngine<> delay_;
         ResonantFilter res_filter_;
         RingModulator ring_mod_;
         Biquad main_filter_;
-        AAFilter<float> aa_filter_;
+        Upsampler<float> upsampler_;
         bool ringModOn = false;
         static constexpr PotID kPotPitch = POT_1;
         static constexpr PotID kPotDelayTime = POT_2;
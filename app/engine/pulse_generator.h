@@ -1,9 +1,9 @@
 #pragma once
 #include <cstdint>
 #include <cmath>
-#include <cstdlib> // For std::rand() and RAND_MAX
+#include <algorithm>
 #include "common/config.h"
-#include <ctime>
+#include "util/random.h"
 namespace recorder
 {
     class PulseGenerator
@@ -15,7 +15,10 @@ namespace recorder
                            randomizationcounter(0),
                            randomizationperiod(5) // Change random variation every 2 samples
         {
-            std::srand(static_cast<unsigned>(std::time(0)));
+        }
+        void Seed(uint32_t seed)
+        {
+            random_.Seed(seed);
         }
         void SetBaseDutyCycle(float duty_cycle)
         {
@@ -55,12 +58,13 @@ namespace recorder
         float current_dutycycle;
         int randomizationcounter;
         const int randomizationperiod;
+        Random random_;
         void UpdateDutyCycle()
         {
             if (duty_cyclerandomization > 0.0f)
             {
                 // Generate random value between -1 and 1
-                float random_offset = ((static_cast<float>(std::rand()) / RAND_MAX) * 2.0f - 1.0f);
+                float random_offset = random_.NextBipolar();
                 // Scale by randomization amount and clamp result
                 float max_offset = 0.6f * duty_cyclerandomization; // Max 60% variation at full randomization
                 float offset = random_offset * max_offset;
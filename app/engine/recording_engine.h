@@ -2,10 +2,13 @@
 
 #include <cstdint>
 #include <cmath>
+#include <algorithm>
+#include <span>
 
 #include "common/config.h"
-#include "app/engine/resampler.h"
+#include "app/engine/sinc_resampler.h"
 #include "app/engine/aafilter.h"
+#include "util/fastmath.h"
 
 namespace recorder
 {
@@ -29,28 +32,53 @@ public:
         aa_filter_.Reset();
     }
 
+    struct ControlSnapshot
+    {
+        float pitch;
+    };
+
     void Process(const float (&block)[kAudioOSFactor], float pitch)
     {
-        float ratio = std::exp2(pitch);
-        float sample = 0;
+        ProcessBlock(block, 1, {.pitch = pitch});
+    }
+
+    // Consumes frames * kAudioOSFactor oversampled input values
+    void ProcessBlock(const float* in, size_t frames,
+        const ControlSnapshot& controls)
+    {
+        float ratio = Exp2(controls.pitch);
 
-        for (uint32_t i = 0; i < kAudioOSFactor; i++)
+        while (frames)
         {
-            sample = aa_filter_.Process(block[i]);
-        }
+            size_t count = std::min<size_t>(frames, kChunkSize);
+            float decimated[kChunkSize];
 
-        resampler_.Push(sample, ratio);
+            for (size_t n = 0; n < count; n++)
+            {
+                for (uint32_t i = 0; i < kAudioOSFactor; i++)
+                {
+                    decimated[n] = aa_filter_.Process(*in++);
+                }
+            }
 
-        while (resampler_.Pop(sample))
-        {
-            memory_.Append(sample);
+            // The resampler writes a chunk's output at once, which the
+            // memory's cursor copies as one run
+            size_t written = resampler_.Process(decimated, count, ratio,
+                output_);
+            memory_.Append(std::span<const float>(output_, written));
+            frames -= count;
         }
     }
 
 protected:
+    using Resampler = SincResampler<32, 32, 4>;
+
+    static constexpr uint32_t kChunkSize = kAudioBlockSize;
+
     T& memory_;
-    Resampler<16> resampler_;
+    Resampler resampler_;
     AAFilter<float> aa_filter_;
+    float output_[Resampler::MaxOutput(kChunkSize)];
 };
 
 }
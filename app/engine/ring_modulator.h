@@ -1,6 +1,7 @@
 #pragma once
 #include <cmath>
 #include "app/engine/envelope_follower.h"
+#include "util/fastmath.h"
 namespace recorder
 {
 
@@ -15,7 +16,7 @@ public:
         SetFrequency(frequency);
         SetMix(mix);
         
-        envFollower_.Init(50, 200, 500, 16000);
+        envFollower_.Init(50, 200, 500, sampleRate_);
     }
 
     void SetFrequency(float frequency)
@@ -31,7 +32,7 @@ public:
 
     float Process(float input)
     {
-        float oscillatorOutput = sin(phase_);
+        float oscillatorOutput = Sin(phase_);
 
         // Update oscillator phase with envelope follower
         float envelope = envFollower_.Process(input);
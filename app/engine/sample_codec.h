@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+
+#include "common/config.h"
+
+namespace recorder
+{
+
+// Storage codecs for recorded audio. Each one works in frames of
+// kFrameLength samples stored in kFrameWords words of type Word, and every
+// frame decodes on its own, so playback can seek to any frame. The encoder
+// keeps its state from one frame to the next.
+//
+//     codec      bits/sample  seconds in 863 KB at 16 kHz
+//     fp16       16           28
+//     mu-law     8            55
+//     IMA-ADPCM  4.125        107
+
+#if defined(__ARM_FP16_FORMAT_IEEE) || defined(__ARM_FP16_FORMAT_ALTERNATIVE)
+using Half = __fp16;
+#else
+using Half = _Float16;
+#endif
+
+class Fp16Codec
+{
+public:
+    using Word = Half;
+    static constexpr uint32_t kFrameLength = 32;
+    static constexpr uint32_t kFrameWords = kFrameLength;
+
+    class Encoder
+    {
+    public:
+        void Reset(void) {}
+
+        void Encode(const float* in, Word* out)
+        {
+            std::copy_n(in, kFrameLength, out);
+        }
+    };
+
+    static void Decode(const Word* in, float* out)
+    {
+        std::copy_n(in, kFrameLength, out);
+    }
+};
+
+// G.711 mu-law, with the 14-bit linear range mapped to [-1, 1]
+class MuLawCodec
+{
+public:
+    using Word = uint8_t;
+    static constexpr uint32_t kFrameLength = 32;
+    static constexpr uint32_t kFrameWords = kFrameLength;
+
+    class Encoder
+    {
+    public:
+        void Reset(void) {}
+
+        void Encode(const float* in, Word* out)
+        {
+            for (uint32_t i = 0; i < kFrameLength; i++)
+            {
+                out[i] = EncodeSample(in[i]);
+            }
+        }
+    };
+
+    static void Decode(const Word* in, float* out)
+    {
+        for (uint32_t i = 0; i < kFrameLength; i++)
+        {
+            out[i] = kDecodeTable[in[i]];
+        }
+    }
+
+    static Word EncodeSample(float sample)
+    {
+        int32_t linear = std::clamp(sample, -1.f, 1.f) * kClip;
+        uint8_t sign = (linear < 0) ? 0x80 : 0;
+        uint32_t magnitude = ((linear < 0) ? -linear : linear) + kBias;
+
+        // The segment is the position of the highest set bit above the bias
+        uint32_t segment = 31 - __builtin_clz(magnitude) - 5;
+        uint32_t mantissa = (magnitude >> (segment + 1)) & 0xF;
+        return ~(sign | (segment << 4) | mantissa);
+    }
+
+protected:
+    static constexpr uint32_t kBias = 33;
+    static constexpr int32_t kClip = 8158;
+
+    static constexpr std::array<float, 256> kDecodeTable = []()
+    {
+        std::array<float, 256> table = {};
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t word = ~i & 0xFF;
+            uint32_t segment = (word >> 4) & 7;
+            int32_t magnitude = (((word & 0xF) << 1) + kBias) << segment;
+            magnitude -= kBias;
+            table[i] = ((word & 0x80) ? -magnitude : magnitude) / float(kClip);
+        }
+
+        return table;
+    }();
+};
+
+// IMA-ADPCM, 4 bits per sample. Each frame starts with the predictor and step
+// index the decoder needs to start there.
+class AdpcmCodec
+{
+public:
+    using Word = uint8_t;
+    static constexpr uint32_t kFrameLength = 256;
+    static constexpr uint32_t kHeaderSize = 4;
+    static constexpr uint32_t kFrameWords = kHeaderSize + kFrameLength / 2;
+
+    struct State
+    {
+        int32_t predictor;
+        int32_t index;
+
+        // Applies one code and returns the new predictor
+        int32_t Step(uint32_t code)
+        {
+            int32_t step = kStepTable[index];
+            int32_t delta = step >> 3;
+
+            if (code & 4) delta += step;
+            if (code & 2) delta += step >> 1;
+            if (code & 1) delta += step >> 2;
+
+            predictor += (code & 8) ? -delta : delta;
+            predictor = std::clamp<int32_t>(predictor, INT16_MIN, INT16_MAX);
+            index = std::clamp<int32_t>(index + kIndexTable[code], 0, 88);
+            return predictor;
+        }
+    };
+
+    class Encoder
+    {
+    public:
+        void Reset(void)
+        {
+            state_ = {0, 0};
+        }
+
+        void Encode(const float* in, Word* out)
+        {
+            int16_t predictor = state_.predictor;
+            out[0] = predictor;
+            out[1] = predictor >> 8;
+            out[2] = state_.index;
+            out[3] = 0;
+            out += kHeaderSize;
+
+            for (uint32_t i = 0; i < kFrameLength; i += 2)
+            {
+                uint32_t low = EncodeSample(in[i]);
+                uint32_t high = EncodeSample(in[i + 1]);
+                *out++ = low | (high << 4);
+            }
+        }
+
+    protected:
+        State state_;
+
+        uint32_t EncodeSample(float sample)
+        {
+            int32_t target = std::clamp(sample, -1.f, 1.f) * INT16_MAX;
+            int32_t diff = target - state_.predictor;
+            int32_t step = kStepTable[state_.index];
+            uint32_t code = 0;
+
+            if (diff < 0)
+            {
+                code = 8;
+                diff = -diff;
+            }
+
+            if (diff >= step)
+            {
+                code |= 4;
+                diff -= step;
+            }
+
+            if (diff >= step >> 1)
+            {
+                code |= 2;
+                diff -= step >> 1;
+            }
+
+            if (diff >= step >> 2)
+            {
+                code |= 1;
+            }
+
+            // Track the decoder exactly so the error doesn't accumulate
+            state_.Step(code);
+            return code;
+        }
+    };
+
+    static void Decode(const Word* in, float* out)
+    {
+        State state =
+        {
+            .predictor = int16_t(in[0] | (in[1] << 8)),
+            .index = std::min<int32_t>(in[2], 88),
+        };
+        in += kHeaderSize;
+
+        for (uint32_t i = 0; i < kFrameLength; i += 2)
+        {
+            uint32_t codes = *in++;
+            *out++ = state.Step(codes & 0xF) * (1.f / INT16_MAX);
+            *out++ = state.Step(codes >> 4) * (1.f / INT16_MAX);
+        }
+    }
+
+protected:
+    static constexpr int8_t kIndexTable[16] =
+    {
+        -1, -1, -1, -1, 2, 4, 6, 8,
+        -1, -1, -1, -1, 2, 4, 6, 8,
+    };
+
+    static constexpr int16_t kStepTable[89] =
+    {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+        19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+        130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+        337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+        5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+    };
+};
+
+template <SampleCodecID id>
+struct SampleCodecType;
+
+template <>
+struct SampleCodecType<SAMPLE_CODEC_FP16>
+{
+    using type = Fp16Codec;
+};
+
+template <>
+struct SampleCodecType<SAMPLE_CODEC_MULAW>
+{
+    using type = MuLawCodec;
+};
+
+template <>
+struct SampleCodecType<SAMPLE_CODEC_ADPCM>
+{
+    using type = AdpcmCodec;
+};
+
+template <SampleCodecID id>
+using SampleCodec = SampleCodecType<id>::type;
+
+}
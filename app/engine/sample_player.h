@@ -3,8 +3,10 @@
 #include <cstdint>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include "drivers/system.h"
+#include "util/fastmath.h"
 
 namespace recorder
 {
@@ -49,6 +51,19 @@ public:
         return state_ == STATE_STOPPED;
     }
 
+    // The direction and speed of play as of the last sample, for a memory
+    // that prefetches, like FlashStream. The speed is 0 while scrubbing or
+    // stopped. Can be read from the main loop.
+    bool reverse(void) const
+    {
+        return velocity_.load(std::memory_order_relaxed) < 0;
+    }
+
+    float speed(void) const
+    {
+        return std::fabs(velocity_.load(std::memory_order_relaxed));
+    }
+
     void Scrub(float pot)
     {
  
@@ -118,8 +133,10 @@ public:
         {
             uint32_t index_a = position_;
             uint32_t index_b = index_a + 1;
-            float sample_a = memory_[index_a];
-            float sample_b = (index_b < length) ? memory_[index_b] : 0;
+            cursor_.Seek(index_a);
+            float sample_a = *cursor_;
+            ++cursor_;
+            float sample_b = (index_b < length) ? *cursor_ : 0;
 
             float frac = position_ - index_a;
             sample = std::lerp(sample_a, sample_b, frac);
@@ -177,7 +194,10 @@ public:
                 sample *= FadeCurve(fade_out_);
             }
         }
-    
+
+        bool moving = (state_ != STATE_STOPPED && state_ != STATE_SCRUBBING);
+        velocity_.store(moving ? (reverse ? -speed : speed) * speed_multiplier_ : 0,
+            std::memory_order_relaxed);
         return sample;
     }
 
@@ -196,7 +216,11 @@ protected:
     };
 
     T& memory_;
+    // Playback moves a few samples at a time, so the cursor almost never
+    // has to leave its link
+    typename T::Cursor cursor_{memory_.cursor()};
     float position_;
+    std::atomic<float> velocity_ = 0;
     State state_;
     float speed_multiplier_ = 1.0;
     float speed_multiplier_target_= 1.0;
@@ -208,7 +232,7 @@ protected:
     float FadeCurve(float tau)
     {
         tau = std::clamp<float>(tau, 0, 1);
-        return 0.5 * (1 - std::cos(kPi * tau));
+        return 0.5 * (1 - Cos(kPi * tau));
     }
 
 };
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <numbers>
+
+namespace recorder
+{
+
+// Band-limited resampler: a Kaiser-windowed sinc `taps` inputs long,
+// tabulated at `phases` points per input sample and interpolated between
+// the two nearest. Ratio is output sampling rate divided by input sampling
+// rate, from 1 / max_ratio to max_ratio.
+//
+// From a ratio of 1 up, each output is the dot product of `taps` inputs with
+// a row of the table, blended with the next row. The input is assumed to be
+// band-limited by AAFilter, with nothing above kPassband of Nyquist, so the
+// stopband only starts where images of the passband would fall.
+//
+// Below 1 the kernel is stretched by kStopband / ratio, which moves its
+// stopband down to the output's Nyquist frequency, so nothing above that is
+// passed to alias. The passband shrinks with it, and taps * kStopband /
+// ratio inputs are read with each coefficient interpolated from the table.
+//
+// Output is delayed by kDelay input samples at every ratio, half the kernel
+// at its widest, so the delay doesn't jump as the ratio changes.
+template <uint32_t taps, uint32_t phases, uint32_t max_ratio>
+class SincResampler
+{
+public:
+    static_assert(taps % 4 == 0, "Taps are summed four at a time");
+    static_assert((phases & (phases - 1)) == 0, "Phases must be a power of 2");
+
+    static constexpr uint32_t kTaps = taps;
+    static constexpr uint32_t kPhases = phases;
+    static constexpr uint32_t kDelay = (taps * max_ratio * 5 + 7) / 8;
+
+    // Largest number of outputs Process() writes for `frames` inputs
+    static constexpr size_t MaxOutput(size_t frames)
+    {
+        return frames * max_ratio + 1;
+    }
+
+    void Init(void)
+    {
+        for (uint32_t p = 0; p <= phases; p++)
+        {
+            float sum = 0;
+
+            for (uint32_t j = 0; j < taps; j++)
+            {
+                float x = float(j) - taps / 2 + float(p) / phases;
+                table_[p][j] = Kernel(x);
+                sum += table_[p][j];
+            }
+
+            // Every phase passes DC at unity gain
+            for (uint32_t j = 0; j < taps; j++)
+            {
+                table_[p][j] /= sum;
+            }
+        }
+
+        Reset();
+    }
+
+    void Reset(void)
+    {
+        std::fill(&history_[0], &history_[2 * kLength], 0.f);
+        head_ = 0;
+        phase_ = 0;
+    }
+
+    // Resamples `frames` inputs into `out`, which must have room for
+    // MaxOutput(frames) samples, and returns the number written
+    size_t Process(const float* in, size_t frames, float ratio, float* out)
+    {
+        ratio = std::clamp(ratio, 1.f / max_ratio, float(max_ratio));
+        float step = 1 / ratio;
+        float* start = out;
+
+        for (size_t n = 0; n < frames; n++)
+        {
+            // The history is stored twice so the taps always see it as one
+            // contiguous run, newest first
+            head_ = (head_ == 0) ? kLength - 1 : head_ - 1;
+            history_[head_] = in[n];
+            history_[head_ + kLength] = in[n];
+            const float* h = &history_[head_];
+
+            if (ratio >= 1)
+            {
+                while (phase_ < 1)
+                {
+                    *out++ = Interpolate(h, phase_);
+                    phase_ += step;
+                }
+            }
+            else
+            {
+                float scale = ratio / kStopband;
+
+                while (phase_ < 1)
+                {
+                    *out++ = Stretch(h, phase_, scale);
+                    phase_ += step;
+                }
+            }
+
+            phase_ -= 1;
+        }
+
+        return out - start;
+    }
+
+protected:
+    static constexpr uint32_t kLength = 2 * kDelay;
+
+    // AAFilter's passband edge, 6 kHz of 8 kHz, and the stopband edge its
+    // images start at
+    static constexpr float kPassband = 0.75f;
+    static constexpr float kStopband = 2 - kPassband;
+
+    // Kaiser's estimates for 80 dB of stopband attenuation, as AAFilter has
+    static constexpr float kAttenuation = 80;
+    static constexpr float kBeta = 0.1102f * (kAttenuation - 8.7f);
+    static constexpr float kTransition = (kAttenuation - 7.95f) /
+        (14.36f * taps) * 2;
+    static constexpr float kCutoff = kStopband - kTransition / 2;
+
+    // kDelay is taps / 2 * max_ratio * kStopband, rounded up
+    static_assert(kDelay >= taps / 2 * max_ratio * kStopband,
+        "The history must cover the kernel at its widest");
+
+    float table_[phases + 1][taps];
+    float history_[2 * kLength];
+    uint32_t head_;
+    float phase_;
+
+    // The impulse response at `x` input samples from its centre, with the
+    // cutoff relative to Nyquist
+    static float Kernel(float x)
+    {
+        float t = x / (taps / 2);
+        float window = BesselI0(kBeta * std::sqrt(std::max(0.f, 1 - t * t))) /
+            BesselI0(kBeta);
+        float sinc = 1;
+
+        if (x != 0)
+        {
+            float w = std::numbers::pi_v<float> * kCutoff * x;
+            sinc = std::sin(w) / w;
+        }
+
+        return kCutoff * sinc * window;
+    }
+
+    static float BesselI0(float x)
+    {
+        float sum = 1;
+        float term = 1;
+
+        for (uint32_t k = 1; term > 1e-7f * sum; k++)
+        {
+            float a = x / (2 * k);
+            term *= a * a;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // Four partial sums, which the compiler can keep in one vector register
+    // and the FPU can pipeline
+    static float Dot(const float* a, const float* b)
+    {
+        float sum[4] = {};
+
+        for (uint32_t j = 0; j < taps; j += 4)
+        {
+            sum[0] += a[j + 0] * b[j + 0];
+            sum[1] += a[j + 1] * b[j + 1];
+            sum[2] += a[j + 2] * b[j + 2];
+            sum[3] += a[j + 3] * b[j + 3];
+        }
+
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    }
+
+    float Interpolate(const float* h, float phase)
+    {
+        float position = phase * phases;
+        uint32_t p = position;
+        float mix = position - p;
+
+        // The inputs under the kernel: the oldest of them is where row 0's
+        // first tap lands
+        const float* x = h + kDelay - taps / 2;
+        float a = Dot(table_[p], x);
+        float b = Dot(table_[p + 1], x);
+
+        return a + (b - a) * mix;
+    }
+
+    // The kernel stretched by 1 / scale
+    float Stretch(const float* h, float phase, float scale)
+    {
+        // Input j is at table position (scale * (j - kDelay + phase) +
+        // taps / 2) * phases; the range of j covers the kernel
+        float reach = taps / 2 / scale;
+        uint32_t first = std::max(0.f, std::ceil(kDelay - phase - reach));
+        uint32_t last = std::min<uint32_t>(kLength,
+            std::ceil(kDelay - phase + reach));
+        float increment = scale * phases;
+        float position = (float(first) - kDelay + phase) * increment +
+            taps / 2 * phases;
+        constexpr float kLastPosition = taps * phases - 1;
+        float sum = 0;
+
+        for (uint32_t j = first; j < last; j++)
+        {
+            float clamped = std::clamp(position, 0.f, kLastPosition);
+            uint32_t i = clamped;
+            float mix = clamped - i;
+
+            // Table entry i is row i % phases of tap i / phases, and the
+            // next entry is the same tap in the next row
+            uint32_t p = i % phases;
+            uint32_t tap = i / phases;
+            float a = table_[p][tap];
+            float b = table_[p + 1][tap];
+
+            sum += h[j] * (a + (b - a) * mix);
+            position += increment;
+        }
+
+        return sum * scale;
+    }
+};
+
+}
@@ -2,11 +2,10 @@
 
 #include <cstdint>
 #include <cmath>
-#include <cstdlib> // For std::rand() and RAND_MAX
-#include <ctime>   // For time()
 
 #include "common/config.h"
-#include "app/engine/aafilter.h"
+#include "util/random.h"
+#include "app/engine/upsampler.h"
 #include "app/engine/formant_filter.h"
 #include "app/engine/one_pole.h"
 #include "app/engine/pulse_generator.h"
@@ -18,9 +17,16 @@
 namespace recorder
 {
 
+    // The engine runs at a compile-time sample rate so that every
+    // rate-derived constant folds away. ProcessBlock() adds the device's
+    // oversampling and only exists at kAudioSampleRate; RenderBlock() works at
+    // any rate, e.g. for offline rendering on the host.
+    template <uint32_t sample_rate = kAudioSampleRateHz>
     class SynthEngine
     {
     public:
+        static constexpr float kSampleRate = sample_rate;
+
         SynthEngine()
             : phase_(0.0f),
               currentFrequency_(130.81f), // Start at C3
@@ -44,8 +50,7 @@ namespace recorder
 
         void Init()
         {
-            // Seed random generator once at initialization
-            std::srand(static_cast<unsigned>(std::time(nullptr)));
+            Seed(Random::kDefaultSeed);
 
             // Initial parameters
             is_note_on_ = false;
@@ -57,28 +62,25 @@ namespace recorder
             previousTargetIndex_ = -1;
             delay_.Init();
 
-            // Set a local sample rate variable
-            sample_rate_ = 16000.0f;
-
             // Initialize filters
-            aa_filter_.Init();
-            aa_filter_.Reset();
+            upsampler_.Init();
 
             // Example delay parameters
             delay_time_ = 0.3f;
             delay_feedback_ = 0.4f;
 
             // Initialize formant filter
-            formant_filter_.Init(sample_rate_);
+            formant_filter_.Init(kSampleRate);
             freq_mult_ = 1.0f;
             formant_filter_.SetVoice(FormantFilter::VOICE_NEUTRAL);
             formant_filter_.setQMult(1.3);
             formant_filter_.setFreqMult(1.4f);
             formant_filter_.SetMode(FormantFilter::FILTER_MODE_NORMAL);
+            formant_filter_.SetControlPeriod(kFormantControlPeriod);
             formant_filter_.SetFormantRate(0.000001f);
             attack_formant_rate_ = 0.001f;
-            lowpass_filter_.Init(19000.0f, sample_rate_, 0.0f);
-            highpass_filter_.Init(120.0f, sample_rate_, 0.0f);
+            lowpass_filter_.Init(19000.0f, kSampleRate, 0.0f);
+            highpass_filter_.Init(120.0f, kSampleRate, 0.0f);
 
             // Set up pulse generator
             pulse_generator_.SetBaseDutyCycle(0.001f);
@@ -93,25 +95,46 @@ namespace recorder
             float decay_ms = 30.0f; // moderate release
 
             compressor_.Init(threshold_dB, ratio,
-                             attack_ms, decay_ms, sample_rate_);
-            // ADSR parameters
-            adsr_attack_time_ = 0.1f; // seconds
-            adsr_decay_time_ = 0.2f;
-            adsr_sustain_level_ = 0.8f;
-            adsr_release_time_ = 0.1f;
+                             attack_ms, decay_ms, kSampleRate);
 
             // Set initial formant
             formant_filter_.SetFormantRate(0.005f);
 
             // Initialize and set default vibrato parameters
-            vibrato_.Init(sample_rate_);
+            vibrato_.Init();
             // Example: vibrato rate = 5 Hz, depth = 0.12, buildup = 1.8 seconds
             vibrato_.SetParameters(6.0f, 0.12f, 1.8f);
             formant_filter_.setFreqMult(mapFloat(fundamentalFreq_, kMinFundamental, kMaxFundamental, 0.7f, 2.0f));
         }
 
         /**
-         * @brief Main audio processing entry point.
+         * @brief Reseed the engine's random sources. Renders with the same
+         *        seed and controls are identical. Init() resets the seed to
+         *        the default.
+         */
+        void Seed(uint32_t seed)
+        {
+            random_.Seed(seed);
+            pulse_generator_.Seed(~seed);
+        }
+
+        /**
+         * @brief Control inputs sampled once per processing block.
+         */
+        struct ControlSnapshot
+        {
+            bool button_pressed;     // The "voice" button (for normal note on/off or hold logic)
+            float pot_value;         // The main pitch knob (used either for scale or fundamental freq)
+            bool hold;               // Whether we are in "hold" mode for the voice button
+            float formant_pot_val;   // Some external pot controlling formant/WAH position
+            float vibrato_pot_val;   // Pot controlling vibrato depth
+            bool freq_select_button; // Button for adjusting the fundamental frequency
+        };
+
+        /**
+         * @brief Main audio processing entry point (single sample).
+         *
+         * Equivalent to ProcessBlock() with a block size of one.
          *
          * @param block                 Output buffer for oversampled audio frames
          * @param button_pressed        The "voice" button (for normal note on/off or hold logic)
@@ -129,129 +152,58 @@ namespace recorder
                      float vibrato_pot_val,
                      bool freq_select_button)
         {
-            //-----------------------------------------------------------------------------
-            // 1) Check if the hold state changed *while* freq_select_button is held
-            //    => Toggle between major/minor scale
-            //-----------------------------------------------------------------------------
-            if (freq_select_button && (hold != was_hold_))
-            {
-                // The hold switch has flipped while freq_select_button is pressed
-                is_minor_ = !is_minor_;
-            }
-
-            // Update stored hold state for next iteration
-            was_hold_ = hold;
-
-            // Only do this "ROBOT TO MONK" mapping if the formant pot value has changed
-            if (std::fabs(formant_pot_val - previous_formant_pot_val_) > 0.05f)
-            {
-                freq_rate_ = mapFloat(formant_pot_val, 0.0f, 1.0f, 0.1f, 0.0008f);
-                freq_wobbliness_ = mapFloat(formant_pot_val, 0.0f, 1.0f, 0.00f, 0.09f);
-                pulse_generator_.SetDutyCycleRandomization(
-                    mapFloat(formant_pot_val, 0.0f, 1.0f, 0.0f, 1.0f));
-                formant_filter_.SetFormantRate(
-                    mapFloat(formant_pot_val, 0.0f, 1.0f, 0.1f, 0.0000001f));
-                previous_formant_pot_val_ = formant_pot_val;
-            }
-
-            // Update formant/WAH parameters
-            formant_filter_.UpdateParameters();
-
-            // Vibrato depth
-            vibrato_.SetDepth(mapFloat(vibrato_pot_val, 0.0f, 1.0f, 0.05f, 1.0f));
-
-            // Map vibrato pot to some delay parameters
-            delay_feedback_ = mapFloat(vibrato_pot_val, 0.0f, 1.0f, 0.05f, 0.7f);
-            delay_time_ = mapFloat(vibrato_pot_val, 0.0f, 1.0f, 0.7f, 0.05f);
-
-            //------------------------------------------------------------------
-            //  Handle fundamental-frequency selection button
-            //------------------------------------------------------------------
-            if (freq_select_button && !was_freq_select_button_pressed_)
-            {
-                // Just pressed: start envelope so we can hear the fundamental
-                StartEnvelope();
-            }
-            else if (!freq_select_button && was_freq_select_button_pressed_)
+            ControlSnapshot controls =
             {
-                // Just released: stop envelope for that mode
-                StopEnvelope();
-            }
+                .button_pressed = button_pressed,
+                .pot_value = pot_value,
+                .hold = hold,
+                .formant_pot_val = formant_pot_val,
+                .vibrato_pot_val = vibrato_pot_val,
+                .freq_select_button = freq_select_button,
+            };
+
+            ProcessBlock(block, 1, controls);
+        }
 
-            //------------------------------------------------------------------
-            //  If NOT in freq-select mode => handle normal "voice" button logic
-            //------------------------------------------------------------------
-            if (!freq_select_button)
-            {
-                // Handle voice-button transitions (normal operation)
-                if (button_pressed && !was_button_pressed_)
-                {
-                    if (hold)
-                    {
-                        // Toggle mode: flip the note state
-                        is_note_on_ = !is_note_on_;
-                        if (is_note_on_)
-                            StartEnvelope();
-                        else
-                            StopEnvelope();
-                    }
-                    else
-                    {
-                        // Normal mode: just start the note
-                        StartEnvelope();
-                    }
-                }
-                else if (!hold && !button_pressed && was_button_pressed_)
-                {
-                    // Normal mode: release when button is released
-                    StopEnvelope();
-                }
+        /**
+         * @brief Render a block of audio with one set of control inputs.
+         *
+         * Pot mapping and button edge handling run once per block; the
+         * oscillator, envelope, pitch glide and formant smoothing still run
+         * once per sample. With frames == 1 the output is identical to the
+         * old per-sample path.
+         *
+         * @param out       Output buffer, frames * kAudioOSFactor oversampled values
+         * @param frames    Number of base-rate samples to render
+         * @param controls  Control inputs for the whole block
+         */
+        void ProcessBlock(float *out, size_t frames, const ControlSnapshot &controls)
+        {
+            static_assert(sample_rate == kAudioSampleRateHz,
+                "The upsampler is designed for the device sample rate");
 
-                // Update pitch if the note is being played
-                if ((hold && is_note_on_) || (!hold && button_pressed))
-                {
-                    UpdatePitchWithScale(pot_value);
-                }
-            }
-            else
+            RenderFrames(frames, controls, [&](float sample)
             {
-                //------------------------------------------------------------------
-                //  freq_select_button IS pressed => override pitch:
-                //     1) Keep envelope open
-                //     2) pot_value => fundamentalFreq_ (C1 .. C6)
-                //     3) Let vibrato apply if desired
-                //------------------------------------------------------------------
-                if (!is_note_on_)
-                {
-                    // If we somehow got here with note off, force note on
-                    StartEnvelope();
-                }
-
-                // Remap pot [0..1] to [C1..C6]
-                fundamentalFreq_ = mapFloat(pot_value, 0.0f, 1.0f, kMinFundamental, kMaxFundamental);
-                formant_filter_.setFreqMult(
-                    mapFloat(fundamentalFreq_, kMinFundamental, kMaxFundamental, 0.7f, 1.8f));
-
-                // Vibrato + smoothing
-                float freqWithVibrato = vibrato_.Process(fundamentalFreq_);
-                SmoothFrequencyToward(freqWithVibrato);
-            }
-
-            //------------------------------------------------------------------
-            //  Generate the audio block (oversampled frames)
-            //------------------------------------------------------------------
-            float sample = RenderOneSample();
-            sample *= (kAudioOSFactor * kAudioOutputLevel);
+                sample *= (kAudioOSFactor * kAudioOutputLevel);
+                upsampler_.Process(sample, out);
+                out += kAudioOSFactor;
+            });
+        }
 
-            for (uint32_t i = 0; i < kAudioOSFactor; i++)
+        /**
+         * @brief Render a block of audio at the engine's own sample rate,
+         *        without oversampling.
+         *
+         * @param out       Output buffer, frames values
+         * @param frames    Number of samples to render
+         * @param controls  Control inputs for the whole block
+         */
+        void RenderBlock(float *out, size_t frames, const ControlSnapshot &controls)
+        {
+            RenderFrames(frames, controls, [&](float sample)
             {
-                float filtered = aa_filter_.Process((i == 0) ? sample : 0.0f);
-                block[i] = filtered;
-            }
-
-            // Store button states for next iteration
-            was_button_pressed_ = button_pressed;
-            was_freq_select_button_pressed_ = freq_select_button;
+                *out++ = sample * kAudioOutputLevel;
+            });
         }
 
         /**
@@ -267,6 +219,39 @@ namespace recorder
         }
 
     private:
+        // Shared by ProcessBlock() and RenderBlock(); `output` receives each
+        // base-rate sample
+        template <typename Output>
+        void RenderFrames(size_t frames, const ControlSnapshot &controls, Output &&output)
+        {
+            ApplyControls(controls);
+
+            float target_frequency = 0.0f;
+
+            for (size_t n = 0; n < frames; n++)
+            {
+                // Update formant/WAH parameters
+                formant_filter_.UpdateParameters();
+
+                if (n == 0)
+                {
+                    HandleButtons(controls);
+                    target_frequency = UpdateTargetFrequency(controls);
+                }
+
+                UpdatePitch(controls, target_frequency);
+
+                //--------------------------------------------------------------
+                //  Generate the audio block
+                //--------------------------------------------------------------
+                output(RenderOneSample());
+            }
+
+            // Store button states for next block
+            was_button_pressed_ = controls.button_pressed;
+            was_freq_select_button_pressed_ = controls.freq_select_button;
+        }
+
         //--------------------------------------------------------------------------
         //                              CONSTANTS
         //--------------------------------------------------------------------------
@@ -319,6 +304,18 @@ namespace recorder
         static constexpr float kMinFundamental = 32.70f;   // ~C1
         static constexpr float kMaxFundamental = 1046.50f; // ~C6
 
+        static constexpr float kSamplePeriod = 1.0f / kSampleRate;
+
+        // ADSR parameters, in seconds and per-sample steps
+        static constexpr float kAttackTime = 0.1f;
+        static constexpr float kDecayTime = 0.2f;
+        static constexpr float kSustainLevel = 0.8f;
+        static constexpr float kReleaseTime = 0.1f;
+
+        static constexpr float kAttackIncrement = 1.0f / (kAttackTime * kSampleRate);
+        static constexpr float kDecayDecrement = (1.0f - kSustainLevel) / (kDecayTime * kSampleRate);
+        static constexpr float kReleaseDecrement = kSustainLevel / (kReleaseTime * kSampleRate);
+
         //--------------------------------------------------------------------------
         //                              ADSR STATE
         //--------------------------------------------------------------------------
@@ -354,6 +351,7 @@ namespace recorder
         float delay_feedback_;
         float freq_rate_;
         float freq_wobbliness_;
+        Random random_;
 
         // Button states
         bool was_button_pressed_;             // For the normal "voice" button
@@ -370,30 +368,180 @@ namespace recorder
         float previous_formant_pot_val_;
 
         // DSP components
-        AAFilter<float> aa_filter_;
+        Upsampler<float> upsampler_;
         FormantFilter formant_filter_;
         OnePoleLowpass lowpass_filter_;
         PulseGenerator pulse_generator_;
-        DelayEngine delay_;
+        DelayEngine<sample_rate> delay_;
         OnePoleHighpass highpass_filter_;
         CyclopsCompressor compressor_;
-        Vibrato vibrato_;
+        Vibrato<sample_rate> vibrato_;
 
-        // ADSR parameters
-        float adsr_attack_time_;
-        float adsr_decay_time_;
-        float adsr_sustain_level_;
-        float adsr_release_time_;
+        // ADSR state
         float adsr_value_;
         ADSRState adsr_state_;
 
-        // Misc
-        float sample_rate_;
-
         //--------------------------------------------------------------------------
         //                              PRIVATE METHODS
         //--------------------------------------------------------------------------
 
+        //--------------------------------------------------------------------------
+        //  Block-rate control handling
+        //--------------------------------------------------------------------------
+        void ApplyControls(const ControlSnapshot &controls)
+        {
+            //-----------------------------------------------------------------------------
+            // 1) Check if the hold state changed *while* freq_select_button is held
+            //    => Toggle between major/minor scale
+            //-----------------------------------------------------------------------------
+            if (controls.freq_select_button && (controls.hold != was_hold_))
+            {
+                // The hold switch has flipped while freq_select_button is pressed
+                is_minor_ = !is_minor_;
+            }
+
+            // Update stored hold state for next iteration
+            was_hold_ = controls.hold;
+
+            // Only do this "ROBOT TO MONK" mapping if the formant pot value has changed
+            float formant_pot_val = controls.formant_pot_val;
+
+            if (std::fabs(formant_pot_val - previous_formant_pot_val_) > 0.05f)
+            {
+                freq_rate_ = mapFloat(formant_pot_val, 0.0f, 1.0f, 0.1f, 0.0008f);
+                freq_wobbliness_ = mapFloat(formant_pot_val, 0.0f, 1.0f, 0.00f, 0.09f);
+                pulse_generator_.SetDutyCycleRandomization(
+                    mapFloat(formant_pot_val, 0.0f, 1.0f, 0.0f, 1.0f));
+                formant_filter_.SetFormantRate(
+                    mapFloat(formant_pot_val, 0.0f, 1.0f, 0.1f, 0.0000001f));
+                previous_formant_pot_val_ = formant_pot_val;
+            }
+
+            // Vibrato depth
+            float vibrato_pot_val = controls.vibrato_pot_val;
+            vibrato_.SetDepth(mapFloat(vibrato_pot_val, 0.0f, 1.0f, 0.05f, 1.0f));
+
+            // Map vibrato pot to some delay parameters
+            delay_feedback_ = mapFloat(vibrato_pot_val, 0.0f, 1.0f, 0.05f, 0.7f);
+            delay_time_ = mapFloat(vibrato_pot_val, 0.0f, 1.0f, 0.7f, 0.05f);
+        }
+
+        void HandleButtons(const ControlSnapshot &controls)
+        {
+            bool freq_select_button = controls.freq_select_button;
+            bool button_pressed = controls.button_pressed;
+            bool hold = controls.hold;
+
+            //------------------------------------------------------------------
+            //  Handle fundamental-frequency selection button
+            //------------------------------------------------------------------
+            if (freq_select_button && !was_freq_select_button_pressed_)
+            {
+                // Just pressed: start envelope so we can hear the fundamental
+                StartEnvelope();
+            }
+            else if (!freq_select_button && was_freq_select_button_pressed_)
+            {
+                // Just released: stop envelope for that mode
+                StopEnvelope();
+            }
+
+            //------------------------------------------------------------------
+            //  If NOT in freq-select mode => handle normal "voice" button logic
+            //------------------------------------------------------------------
+            if (!freq_select_button)
+            {
+                // Handle voice-button transitions (normal operation)
+                if (button_pressed && !was_button_pressed_)
+                {
+                    if (hold)
+                    {
+                        // Toggle mode: flip the note state
+                        is_note_on_ = !is_note_on_;
+                        if (is_note_on_)
+                            StartEnvelope();
+                        else
+                            StopEnvelope();
+                    }
+                    else
+                    {
+                        // Normal mode: just start the note
+                        StartEnvelope();
+                    }
+                }
+                else if (!hold && !button_pressed && was_button_pressed_)
+                {
+                    // Normal mode: release when button is released
+                    StopEnvelope();
+                }
+            }
+        }
+
+        bool NotePlaying(const ControlSnapshot &controls) const
+        {
+            return (controls.hold && is_note_on_) ||
+                   (!controls.hold && controls.button_pressed);
+        }
+
+        // Work out the (pre-vibrato) pitch target for this block. This only
+        // depends on the controls, so it runs once per block.
+        float UpdateTargetFrequency(const ControlSnapshot &controls)
+        {
+            if (!controls.freq_select_button)
+            {
+                // Update pitch if the note is being played
+                if (NotePlaying(controls))
+                {
+                    return ScaleTargetFrequency(controls.pot_value);
+                }
+
+                return 0.0f;
+            }
+            else
+            {
+                //------------------------------------------------------------------
+                //  freq_select_button IS pressed => override pitch:
+                //     1) Keep envelope open
+                //     2) pot_value => fundamentalFreq_ (C1 .. C6)
+                //     3) Let vibrato apply if desired
+                //------------------------------------------------------------------
+                if (!is_note_on_)
+                {
+                    // If we somehow got here with note off, force note on
+                    StartEnvelope();
+                }
+
+                // Remap pot [0..1] to [C1..C6]
+                fundamentalFreq_ = mapFloat(controls.pot_value, 0.0f, 1.0f, kMinFundamental, kMaxFundamental);
+                formant_filter_.setFreqMult(
+                    mapFloat(fundamentalFreq_, kMinFundamental, kMaxFundamental, 0.7f, 1.8f));
+                return fundamentalFreq_;
+            }
+        }
+
+        // Per-sample pitch glide toward the block's target frequency
+        void UpdatePitch(const ControlSnapshot &controls, float target_frequency)
+        {
+            if (controls.freq_select_button)
+            {
+                // Vibrato + smoothing
+                float freqWithVibrato = vibrato_.Process(target_frequency);
+                SmoothFrequencyToward(freqWithVibrato);
+            }
+            else if (NotePlaying(controls))
+            {
+                PossiblyUpdateFrequencyOffset(target_frequency);
+
+                float targetFrequency = target_frequency + targetFrequencyOffset_;
+
+                // Apply vibrato
+                float vibratoFreq = vibrato_.Process(targetFrequency);
+
+                // Smooth toward final (vibrato) freq
+                SmoothFrequencyToward(vibratoFreq);
+            }
+        }
+
         float RenderOneSample()
         {
             // If envelope is idle and the delay line is silent, output zero
@@ -406,7 +554,7 @@ namespace recorder
             UpdateEnvelope();
 
             // Advance oscillator
-            float phaseIncrement = currentFrequency_ / sample_rate_;
+            float phaseIncrement = currentFrequency_ * kSamplePeriod;
             phase_ += phaseIncrement;
             if (phase_ >= 1.0f)
                 phase_ -= 1.0f;
@@ -462,8 +610,7 @@ namespace recorder
             {
             case ADSRState::kAttack:
             {
-                float increment = 1.0f / (adsr_attack_time_ * sample_rate_);
-                adsr_value_ += increment;
+                adsr_value_ += kAttackIncrement;
                 if (adsr_value_ >= 1.0f)
                 {
                     adsr_value_ = 1.0f;
@@ -474,11 +621,10 @@ namespace recorder
 
             case ADSRState::kDecay:
             {
-                float decrement = (1.0f - adsr_sustain_level_) / (adsr_decay_time_ * sample_rate_);
-                adsr_value_ -= decrement;
-                if (adsr_value_ <= adsr_sustain_level_)
+                adsr_value_ -= kDecayDecrement;
+                if (adsr_value_ <= kSustainLevel)
                 {
-                    adsr_value_ = adsr_sustain_level_;
+                    adsr_value_ = kSustainLevel;
                     adsr_state_ = ADSRState::kSustain;
                 }
             }
@@ -486,13 +632,12 @@ namespace recorder
 
             case ADSRState::kSustain:
                 // Envelope stays at sustain level.
-                adsr_value_ = adsr_sustain_level_;
+                adsr_value_ = kSustainLevel;
                 break;
 
             case ADSRState::kRelease:
             {
-                float decrement = adsr_sustain_level_ / (adsr_release_time_ * sample_rate_);
-                adsr_value_ -= decrement;
+                adsr_value_ -= kReleaseDecrement;
 
                 // Morph back to "lips closed" OU
                 formant_filter_.SetVowel(FormantFilter::VOWEL_OU);
@@ -518,8 +663,9 @@ namespace recorder
         //--------------------------------------------------------------------------
         //  For normal (voice-button) operation: pick a diatonic note from pot_value
         //  using either the major or minor scale array, depending on is_minor_.
+        //  Returns the base target frequency, before offset and vibrato.
         //--------------------------------------------------------------------------
-        void UpdatePitchWithScale(float pot_value)
+        float ScaleTargetFrequency(float pot_value)
         {
             int targetIndex = DetermineTargetIndex(pot_value);
             PossiblyUpdateVowel(targetIndex);
@@ -527,17 +673,7 @@ namespace recorder
             // Choose major vs. minor array
             const float *scaleArray = is_minor_ ? kDiatonicMinorRatios : kDiatonicMajorRatios;
 
-            float baseTargetFrequency = fundamentalFreq_ * scaleArray[targetIndex] * freq_mult_;
-
-            PossiblyUpdateFrequencyOffset(baseTargetFrequency);
-
-            float targetFrequency = baseTargetFrequency + targetFrequencyOffset_;
-
-            // Apply vibrato
-            float vibratoFreq = vibrato_.Process(targetFrequency);
-
-            // Smooth toward final (vibrato) freq
-            SmoothFrequencyToward(vibratoFreq);
+            return fundamentalFreq_ * scaleArray[targetIndex] * freq_mult_;
         }
 
         int DetermineTargetIndex(float pot_value) const
@@ -569,7 +705,7 @@ namespace recorder
             if (targetIndex != previousTargetIndex_)
             {
                 // Random voice from { NEUTRAL, NASAL, DARK }
-                int randomVoice = std::rand() % 3;
+                int randomVoice = random_.NextBelow(3);
                 formant_filter_.SetVoice(static_cast<FormantFilter::VoiceType>(randomVoice));
 
                 // Then pick a random vowel from the 10 available vowels
@@ -588,8 +724,7 @@ namespace recorder
             {
                 // freq_wobbliness_ is controlling the +/- offset range
                 float maxOffset = baseTargetFrequency * freq_wobbliness_;
-                targetFrequencyOffset_ =
-                    ((static_cast<float>(std::rand()) / RAND_MAX) * 2.0f - 1.0f) * maxOffset;
+                targetFrequencyOffset_ = random_.NextBipolar() * maxOffset;
 
                 // Reset the offset counter (change offset every 1000 samples)
                 offsetCounter_ = 1000;
@@ -610,7 +745,7 @@ namespace recorder
             // 10 total vowels: VOWEL_I to VOWEL_SCHWA (in your FormantFilter)
             // If you only have 6 or so, adjust accordingly.
             constexpr int numVowels = 6;
-            int randomIndex = std::rand() % numVowels;
+            int randomIndex = random_.NextBelow(numVowels);
             return static_cast<FormantFilter::Vowel>(randomIndex);
         }
 
@@ -0,0 +1,172 @@
+#pragma once
+
+namespace recorder
+{
+
+// Interpolates by kOSFactor with the same response as AAFilter, without
+// running the filter over the stuffed zeros.
+//
+// Every pole p of the elliptic prototype is paired with its rotations
+// p * exp(2j*pi*r/kOSFactor), which turns the denominator into a polynomial
+// in z^-kOSFactor with poles p^kOSFactor. The matching zeros are folded into
+// the numerator, leaving an all-pole cascade that runs once per input sample
+// and an FIR numerator that splits into kOSFactor polyphase branches, one
+// per output sample.
+template <typename T>
+class Upsampler
+{
+public:
+    void Init(void)
+    {
+        Reset();
+    }
+
+    void Reset(void)
+    {
+        for (int n = 0; n < kNumSections; n++)
+        {
+            y_[n][0] = 0;
+            y_[n][1] = 0;
+        }
+
+        for (int n = 0; n < 2 * kTapsPerPhase; n++)
+        {
+            history_[n] = 0;
+        }
+
+        head_ = 0;
+    }
+
+    // Writes kOSFactor output samples for one input sample. Equivalent to
+    // AAFilter::Process() on the input followed by kOSFactor - 1 zeros.
+    void Process(T in, T* out)
+    {
+        for (int n = 0; n < kNumSections; n++)
+        {
+            T y = in - kPoles[n][0] * y_[n][0] - kPoles[n][1] * y_[n][1];
+            y_[n][1] = y_[n][0];
+            y_[n][0] = y;
+            in = y;
+        }
+
+        // The history is stored twice so the taps always see it as one
+        // contiguous run, newest first
+        head_ = (head_ == 0) ? kTapsPerPhase - 1 : head_ - 1;
+        history_[head_] = in;
+        history_[head_ + kTapsPerPhase] = in;
+        const T* h = &history_[head_];
+
+        for (int i = 0; i < kOSFactor; i++)
+        {
+            T sum = 0;
+
+            for (int j = 0; j < kTapsPerPhase; j++)
+            {
+                sum += kTaps[i][j] * h[j];
+            }
+
+            out[i] = sum;
+        }
+    }
+
+    int GetOversamplingFactor(void)
+    {
+        return kOSFactor;
+    }
+
+protected:
+    /*[[[cog
+    from scipy import signal
+    import numpy as np
+    import math
+
+    fs = 16000
+    min_oversampled_rate = 48000
+
+    fp = 6000 # passband corner in Hz
+    rp = 0.1 # passband ripple in dB
+    rs = 80 # stopband attenuation in dB
+
+    # Same prototype as AAFilter
+    factor = math.ceil(min_oversampled_rate / fs)
+    wp = fp / fs
+    ws = 0.5
+
+    n, wc = signal.ellipord(wp*2/factor, ws*2/factor, rp, rs)
+    n = 2 * int(math.ceil(n / 2))
+    n = max(2, n)
+    z, p, k = signal.ellip(n, rp, rs, wc, output='zpk')
+
+    if n % 2 == 0:
+        # DC gain is -rp for even-order filters, so amplify by rp
+        k *= math.pow(10, rp / 20)
+
+    # Multiply numerator and denominator by the rotated copies of each pole
+    rotations = np.exp(2j * np.pi * np.arange(1, factor) / factor)
+    extra = np.outer(p, rotations).flatten()
+    b = np.real(k * np.poly(np.concatenate((z, extra))))
+    sos = signal.zpk2sos([], p ** factor, 1)
+
+    taps = int(math.ceil(len(b) / factor))
+    b = np.concatenate((b, np.zeros(taps * factor - len(b))))
+    num_sections = len(sos)
+    mults = fs * (2 * num_sections + taps * factor)
+
+    cog.outl('static constexpr int kOSFactor = {};'.format(factor))
+    cog.outl('static constexpr int kNumSections = {:d};'.format(num_sections))
+    cog.outl('static constexpr int kTapsPerPhase = {:d};'.format(taps))
+    cog.outl('static constexpr float kPoles[kNumSections][2] ='
+        ' // n = {:d}, mults/s = {:d}'.format(n, mults))
+    cog.outl('{')
+    for sec in sos:
+        a = ''.join(['{:.8e},'.format(c).ljust(17) for c in sec[4:]])
+        cog.outl('    {' + a + '},')
+    cog.outl('};')
+    cog.outl('static constexpr float kTaps[kOSFactor][kTapsPerPhase] =')
+    cog.outl('{')
+    for phase in range(factor):
+        coeffs = b[phase::factor]
+        cog.outl('    {')
+        for i in range(0, taps, 4):
+            row = ''.join(['{:.8e},'.format(c).ljust(17) for c in coeffs[i:i+4]])
+            cog.outl('        ' + row.rstrip())
+        cog.outl('    },')
+    cog.outl('};')
+    ]]]*/
+    static constexpr int kOSFactor = 3;
+    static constexpr int kNumSections = 5;
+    static constexpr int kTapsPerPhase = 11;
+    static constexpr float kPoles[kNumSections][2] = // n = 10, mults/s = 688000
+    {
+        {-7.02051775e-01, 1.78579224e-01,  },
+        {-5.59236298e-02, 3.09237034e-01,  },
+        {6.59100791e-01,  5.32478829e-01,  },
+        {1.13458647e+00,  7.51324837e-01,  },
+        {1.38889758e+00,  9.22682256e-01,  },
+    };
+    static constexpr float kTaps[kOSFactor][kTapsPerPhase] =
+    {
+        {
+            7.49218660e-04,  2.70984000e-02,  1.89109578e-01,  5.97598145e-01,
+            1.06262535e+00,  1.15002661e+00,  7.68203807e-01,  3.04598738e-01,
+            6.39069584e-02,  5.30553804e-03,  5.59085693e-05,
+        },
+        {
+            3.54961542e-03,  5.81745818e-02,  2.98632257e-01,  7.67618189e-01,
+            1.15092332e+00,  1.06153378e+00,  6.00240876e-01,  1.96015934e-01,
+            3.16566808e-02,  1.66782200e-03,  0.00000000e+00,
+        },
+        {
+            1.07985931e-02,  1.10102228e-01,  4.37080816e-01,  9.29111678e-01,
+            1.18149716e+00,  9.28388463e-01,  4.41564557e-01,  1.16841711e-01,
+            1.39420161e-02,  3.95332962e-04,  0.00000000e+00,
+        },
+    };
+    //[[[end]]]
+
+    T y_[kNumSections][2];
+    T history_[2 * kTapsPerPhase];
+    int head_;
+};
+
+}
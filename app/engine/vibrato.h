@@ -1,17 +1,21 @@
 #pragma once
 
+#include <cstdint>
 #include <cmath>
 #include <algorithm> // for std::min, std::max
 
+#include "common/config.h"
+#include "util/fastmath.h"
+
 namespace recorder
 {
 
+template <uint32_t sample_rate = kAudioSampleRateHz>
 class Vibrato
 {
 public:
     Vibrato()
-        : sampleRate_(16000.0f),
-          phase_(0.0f),
+        : phase_(0.0f),
           rate_(5.0f),
           depth_(0.02f),
           targetDepth_(0.02f),
@@ -19,15 +23,14 @@ public:
           currentDepth_(0.0f),
           buildingUp_(false)
     {
+        UpdateIncrements();
     }
 
     /**
-     * @brief Initialize the vibrato with the given sample rate.
-     * @param sampleRate The audio sample rate (e.g. 16000).
+     * @brief Initialize the vibrato.
      */
-    void Init(float sampleRate)
+    void Init()
     {
-        sampleRate_   = sampleRate;
         phase_        = 0.0f;
         currentDepth_ = 0.0f;
         buildingUp_   = false;
@@ -46,6 +49,7 @@ public:
         rate_        = rate;
         targetDepth_ = depth; // We'll still clamp and smooth this in Process().
         buildupTime_ = (buildupTime <= 0.0f) ? 0.01f : buildupTime;
+        UpdateIncrements();
     }
 
     /**
@@ -93,19 +97,15 @@ public:
         // 2) Move "currentDepth_" smoothly toward "depth_"
         //    respecting "buildupTime_"
         //--------------------------------------------------
-        // We'll compute a per-sample increment factor based on buildupTime_:
-        // If buildupTime_ is X seconds, we want to fully go from 0 to 'depth_'
-        // in X * sampleRate_ samples => each sample we move an incremental fraction.
-        float alpha = 1.0f / (buildupTime_ * sampleRate_);
-        // We clamp alpha to something smaller if we want a minimum speed
-        // but let's keep it as is for now.
+        // alpha_ is the per-sample increment factor based on buildupTime_,
+        // see UpdateIncrements()
 
         // If buildingUp_ is true, we definitely ramp up from currentDepth_ toward depth_.
         // But also if depth_ changes in the middle, we still approach it (up or down).
         float cdDiff = depth_ - currentDepth_;
 
         // Move a fraction of that difference
-        currentDepth_ += cdDiff * alpha;
+        currentDepth_ += cdDiff * alpha_;
 
         // If we're close enough, or we've gone past, we can consider we've "caught up"
         if (std::fabs(cdDiff) < 0.0001f)
@@ -124,8 +124,7 @@ public:
         //--------------------------------------------------
         // 3) Increment the LFO phase
         //--------------------------------------------------
-        float phaseIncrement = (2.0f * static_cast<float>(M_PI) * rate_) / sampleRate_;
-        phase_ += phaseIncrement;
+        phase_ += phaseIncrement_;
         if (phase_ >= 2.0f * static_cast<float>(M_PI))
         {
             phase_ -= 2.0f * static_cast<float>(M_PI);
@@ -138,7 +137,7 @@ public:
         // Basic vibrato factor = sin(phase_) * currentDepth_
 
 
-        float vib = std::sin(phase_) * currentDepth_;
+        float vib = Sin(phase_) * currentDepth_;
 /*
         if (vib > 0.0f)
         {
@@ -152,9 +151,24 @@ public:
     }
 
 private:
-    float sampleRate_;   ///< The sample rate (e.g. 16000 Hz)
+    static constexpr float kSampleRate = sample_rate;
+
+    /**
+     * @brief Recompute the per-sample steps after a parameter change.
+     *
+     * If buildupTime_ is X seconds, we want to fully go from 0 to 'depth_'
+     * in X * kSampleRate samples => each sample we move an incremental fraction.
+     */
+    void UpdateIncrements()
+    {
+        alpha_ = 1.0f / (buildupTime_ * kSampleRate);
+        phaseIncrement_ = (2.0f * static_cast<float>(M_PI) * rate_) / kSampleRate;
+    }
+
     float phase_;        ///< The current LFO phase
     float rate_;         ///< LFO rate in Hz
+    float phaseIncrement_; ///< LFO phase step per sample
+    float alpha_;        ///< Per-sample buildup factor
 
     float depth_;        ///< The "live" depth that is slowly approaching targetDepth_
     float targetDepth_;  ///< Where we eventually want depth_ to be
@@ -20,6 +20,7 @@
 
 // CYCLOPS INCLUDES
 #include "app/engine/synth_engine.h"
+#include "app/engine/coded_memory.h"
 // CYCLOPS INCLUDES END HERE
 
 namespace recorder
@@ -44,7 +45,7 @@ namespace recorder
     };
 
     // CYCLOPS VARIABLES AND SUCH
-    SynthEngine synth_engine_;
+    SynthEngine<> synth_engine_;
     // CYCLOPS VARIABLES AND SUCH END HERE
 
     std::atomic<State> state_;
@@ -54,11 +55,16 @@ namespace recorder
     EdgeDetector tune_button_;
     uint32_t playback_timeout_;
     float last_pot_value;
-    // SampleMemory<__fp16> sample_memory_;
-    // RecordingEngine recording_{sample_memory_};
-    // PlaybackEngine playback_{sample_memory_};
+    // using StorageCodec = SampleCodec<kSampleCodec>;
+    // using StorageMemory = SampleMemory<StorageCodec::Word>;
+    // StorageMemory sample_memory_;
+    // CodedMemory<StorageCodec, StorageMemory> coded_memory_{sample_memory_};
+    // RecordingEngine recording_{coded_memory_};
+    // PlaybackEngine playback_{coded_memory_};
     DeviceIO io_;
     Monitor monitor_;
+    BootStats boot_stats_;
+    SampleSaveStats save_stats_ = {};
     int count = 0;
     OutputPin<GPIOC_BASE, 2> ledPin;
 
@@ -106,6 +112,7 @@ namespace recorder
 
     void StateMachine(bool standby)
     {
+        io_.human.in.pot = analog_.pot();
         switches_.Process(io_.human.in);
         play_button_.Process(io_.human.in.sw[SWITCH_PLAY]);
         tune_button_.Process(io_.human.in.sw[SWITCH_TUNE]);
@@ -118,19 +125,20 @@ namespace recorder
         {
             /*
             ledPin.Write(0);
+            sample_memory_.ServiceErase();
             if (record)
             {
                 recording_.Reset();
                 analog_.StartRecording();
-                sample_memory_.StartRecording();
+                coded_memory_.StartRecording();
                 Transition(STATE_RECORD);
             }
             else if (play_button_.is_high())
             {
                 playback_.Reset();
                 playback_.Play();
+                sample_memory_.StartPlayback(io_.human.in.sw[SWITCH_REVERSE]);
                 analog_.StartPlayback();
-                sample_memory_.StartPlayback();
                 playback_timeout_ = 0;
                 Transition(STATE_PLAY);
             }
@@ -179,16 +187,18 @@ namespace recorder
         // else if (state == STATE_RECORD)
         // {
         //     ledPin.Write(1);
+        //     sample_memory_.ServiceErase();
         //     if (!record)
         //     {
         //         analog_.Stop();
         //         Transition(STATE_IDLE);
-        //         sample_memory_.StopRecording();
+        //         coded_memory_.StopRecording();
         //     }
         // }
         // else if (state == STATE_PLAY)
         // {
         //     ledPin.Write(1);
+        //     sample_memory_.ServiceStream(playback_.reverse(), playback_.speed());
         //     if (analog_.running())
         //     {
         //         if (scrub)
@@ -305,7 +315,8 @@ namespace recorder
         // {
         //     if (sample_memory_.Commit())
         //     {
-        //         printf("Save completed\n");
+        //         printf("Save completed in %" PRIu32 " ms\n",
+        //             sample_memory_.save_stats().stop_to_saved_ms);
         //         sample_memory_.PrintInfo("    ");
         //     }
         //     else
@@ -324,25 +335,34 @@ namespace recorder
         }
     }
 
-    const AudioOutput Process(const AudioInput &audio_in, const PotInput &pot)
+    void Process(const AudioInput &audio_in, const AudioOutput &audio_out,
+        const PotInput &pot)
     {
         ScopedProfilingPin<PROFILE_PROCESS> profile;
-        io_.human.in.pot = pot;
-        AudioOutput audio_out = {};
+        ScopedProfilingZone<PROFILE_PROCESS> zone;
         State state = state_.load(std::memory_order_acquire);
 
         if (state == STATE_SYNTH)
         {
-            bool button_pressed = play_button_.is_high();
-            bool tune = tune_button_.is_low();
-            bool hold = io_.human.in.sw[SWITCH_LOOP];
-            float pot_value = pot[POT_1];
-            float vib = pot[POT_3];
-            float formant = pot[POT_2];
-            synth_engine_.Process(audio_out[AUDIO_OUT_LINE], button_pressed, pot_value, hold, formant, vib, tune);
+            SynthEngine<>::ControlSnapshot controls =
+            {
+                .button_pressed = play_button_.is_high(),
+                .pot_value = pot[POT_1],
+                .hold = io_.human.in.sw[SWITCH_LOOP],
+                .formant_pot_val = pot[POT_2],
+                .vibrato_pot_val = pot[POT_3],
+                .freq_select_button = tune_button_.is_low(),
+            };
+            synth_engine_.ProcessBlock(audio_out[AUDIO_OUT_LINE].data(),
+                kAudioBlockSize, controls);
+        }
+        else
+        {
+            for (auto &channel : audio_out)
+            {
+                std::fill(channel.begin(), channel.end(), 0.f);
+            }
         }
-
-        return audio_out;
     }
 
     extern "C" int main(void)
@@ -374,10 +394,14 @@ namespace recorder
             analog_.Start(false);
         }
 
+        boot_stats_ = {.ready_ms = system::Uptime_ms()};
+        printf("Ready after %" PRIu32 " ms\n", boot_stats_.ready_ms);
+
         for (;;)
         {
             printf("test");
             ProfilingPin<PROFILE_MAIN_LOOP>::Set();
+            // sample_memory_.ServiceLoad();
             std::atomic_thread_fence(std::memory_order_acq_rel);
 
             bool standby = false;
@@ -385,7 +409,13 @@ namespace recorder
 
             if (message.type == Message::TYPE_QUERY)
             {
-                monitor_.Report(io_);
+                // boot_stats_.load = sample_memory_.load_stats();
+                // save_stats_ = sample_memory_.save_stats();
+                monitor_.Report(io_, analog_.timing(), boot_stats_, save_stats_);
+            }
+            else if (message.type == Message::TYPE_PROFILE)
+            {
+                monitor_.ReportZone(message.zone);
             }
             else if (message.type == Message::TYPE_STANDBY)
             {
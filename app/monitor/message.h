@@ -17,6 +17,7 @@ struct __attribute__ ((packed)) Message
         TYPE_STANDBY = 's',
         TYPE_ERASE = 'e',
         TYPE_WATCHDOG = 'w',
+        TYPE_PROFILE = 'z',
     };
 
     uint8_t type;
@@ -24,6 +25,7 @@ struct __attribute__ ((packed)) Message
     union
     {
         char text[128];
+        uint8_t zone;
     };
 };
 
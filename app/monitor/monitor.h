@@ -3,6 +3,9 @@
 #include <cstdint>
 
 #include "common/io.h"
+#include "drivers/profiling_zone.h"
+#include "drivers/audio_timing.h"
+#include "drivers/sample_memory.h"
 #include "app/monitor/a85.h"
 #include "app/monitor/packet.h"
 #include "app/monitor/message.h"
@@ -10,6 +13,12 @@
 namespace recorder
 {
 
+struct BootStats
+{
+    uint32_t ready_ms;      // Uptime when the main loop started
+    SampleLoadStats load;
+};
+
 class Monitor
 {
 public:
@@ -62,17 +71,28 @@ public:
         return message_.payload;
     }
 
-    void Report(const DeviceIO& io)
+    void Report(const DeviceIO& io, const AudioTimingStats& timing,
+                const BootStats& boot, const SampleSaveStats& save)
     {
-        PopulateState(io);
+        PopulateState(io, timing, boot, save);
         state_.Sign();
         a85::Encode(line_, sizeof(line_), &state_, sizeof(state_));
 
         printf("\xff%s\n", line_);
     }
 
+    void ReportZone(uint32_t zone)
+    {
+        PopulateZone(zone);
+        zone_.Sign();
+        a85::Encode(line_, sizeof(line_), &zone_, sizeof(zone_));
+
+        printf("\xff%s\n", line_);
+    }
+
 protected:
-    char line_[sizeof(Message::text)];
+    // Long enough for the encoded State packet
+    char line_[256];
     size_t length_;
     Packet<Message> message_;
 
@@ -92,16 +112,33 @@ protected:
                 bool line_in_detect : 1;
             };
         };
+
+        AudioTimingStats audio;
+        BootStats boot;
+        SampleSaveStats save;
     };
 
     Packet<State> state_;
 
+    struct __attribute__ ((packed)) Zone
+    {
+        uint8_t id;
+        uint8_t num_zones;
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t total;
+    };
+
+    Packet<Zone> zone_;
+
     void Ack(void)
     {
         printf("\xff" "ack\n");
     }
 
-    void PopulateState(const DeviceIO& io)
+    void PopulateState(const DeviceIO& io, const AudioTimingStats& timing,
+                       const BootStats& boot, const SampleSaveStats& save)
     {
         auto& state = state_.payload;
         auto& human = io.human.in;
@@ -116,6 +153,30 @@ protected:
         state.loop = human.sw[SWITCH_LOOP];
         state.reverse = human.sw[SWITCH_REVERSE];
         state.line_in_detect = human.detect[DETECT_LINE_IN];
+        state.audio = timing;
+        state.boot = boot;
+        state.save = save;
+    }
+
+    void PopulateZone(uint32_t id)
+    {
+        auto& zone = zone_.payload;
+        zone.id = id;
+        zone.num_zones = NUM_PROFILES;
+
+        if (id < NUM_PROFILES)
+        {
+            auto& stats = profiling::Zones<>::stats(static_cast<Profile>(id));
+            zone.count = stats.count;
+            zone.min = stats.count ? stats.min : 0;
+            zone.max = stats.max;
+            zone.total = stats.total;
+        }
+        else
+        {
+            zone.count = zone.min = zone.max = 0;
+            zone.total = 0;
+        }
     }
 };
 
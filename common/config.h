@@ -7,9 +7,22 @@ namespace recorder
 {
 
 constexpr float kAudioSampleRate = 16000;
+constexpr uint32_t kAudioSampleRateHz = kAudioSampleRate; // For template arguments
 constexpr uint32_t kAudioOSFactor = std::ceil(48000.0 / kAudioSampleRate);
 constexpr float kAudioOSRate = kAudioSampleRate * kAudioOSFactor;
 
+// Base-rate samples per audio callback. The ADC and DAC DMA buffers hold two
+// blocks each and interrupt once per block, so larger blocks mean fewer
+// interrupts but add latency: input reaches the output two blocks later.
+// The pots are read one per callback, so each pot is sampled at
+// kAudioSampleRate / kAudioBlockSize / NUM_POTS (125 Hz with 16 samples and
+// 8 pots, against 2 kHz at one sample per callback), and the values the
+// engines see step once per block.
+constexpr uint32_t kAudioBlockSize = 16;
+constexpr uint32_t kAudioOSBlockSize = kAudioBlockSize * kAudioOSFactor;
+static_assert(kAudioBlockSize >= 1 && kAudioBlockSize <= 64,
+    "Audio block size out of range");
+
 constexpr float kAudioOutputLevel = 1.0;
 constexpr float kAudioFadeTime = 20e-3;
 constexpr uint32_t kButtonDebounceDuration_ms = 10;
@@ -21,6 +34,44 @@ constexpr uint32_t kADCIRQPriority = 1;
 constexpr uint32_t kTickIRQPriority = 10;
 constexpr uint32_t kSerialIRQPriority = 11;
 
+// Formant filter coefficients are recalculated every this many samples and
+// ramped linearly in between. 1 recalculates them every sample.
+constexpr uint32_t kFormantControlPeriod = 16;
+
+// Formant bandpass coefficients are looked up from a table generated at
+// compile time instead of being designed with sin/cos. Each entry costs 12
+// bytes of flash; with GCC the build fails if the largest interpolated
+// coefficient error exceeds the tolerance. host/formant_report measures the
+// error between grid points and the effect on rendered audio.
+constexpr bool kEnableFormantTable = true;
+constexpr uint32_t kFormantTableFreqSize = 64;
+constexpr uint32_t kFormantTableQSize = 16;
+constexpr float kFormantTableTolerance = 0.002;
+
+// Use the polynomial approximations in util/fastmath.h instead of libm on
+// the audio path
+constexpr bool kEnableFastMath = true;
+
+// Time each ScopedProfilingZone with the cycle counter and keep per-zone
+// statistics for the monitor
+constexpr bool kEnableProfilingZones = true;
+
+// How recordings are stored in RAM; see app/engine/sample_codec.h. ADPCM
+// fits four times as much audio as fp16, mu-law twice as much.
+enum SampleCodecID
+{
+    SAMPLE_CODEC_FP16,
+    SAMPLE_CODEC_MULAW,
+    SAMPLE_CODEC_ADPCM,
+};
+
+constexpr SampleCodecID kSampleCodec = SAMPLE_CODEC_ADPCM;
+
+// Play the saved recording straight from flash through a FlashStream instead
+// of loading all of it into RAM at boot. SampleMemory's cursors read through
+// the stream until a new recording replaces the saved one.
+constexpr bool kEnableFlashStreaming = true;
+
 constexpr bool kEnableDelay = true;
 constexpr bool kEnableLineIn = VARIANT_LINE_IN;
 constexpr bool kEnableReverse = true;
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <array>
+#include <span>
 #include "common/config.h"
 
 namespace recorder
@@ -75,20 +76,21 @@ struct HumanIO
     }
 };
 
-using AudioInput = std::array<float[kAudioOSFactor], NUM_AUDIO_INS>;
-using AudioOutput = std::array<float[kAudioOSFactor], NUM_AUDIO_OUTS>;
-
-struct AudioIO
+// Views of one block of oversampled audio, pointing straight into the DMA
+// buffers. Input is interleaved by channel in the order the ADC scans it.
+struct AudioInput
 {
-    AudioInput in;
-    AudioOutput out;
+    std::span<const float, NUM_AUDIO_INS * kAudioOSBlockSize> samples;
 
-    void Init(void)
+    float operator()(uint32_t ch, uint32_t idx) const
     {
-        *this = {};
+        return samples[idx * NUM_AUDIO_INS + ch];
     }
 };
 
+using AudioOutput =
+    std::array<std::span<float, kAudioOSBlockSize>, NUM_AUDIO_OUTS>;
+
 struct DeviceIO
 {
     HumanIO human;
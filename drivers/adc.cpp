@@ -114,12 +114,20 @@ void Adc::InitDMA(void)
     LL_DMA_DisableIT_HT(DMA1, LL_DMA_STREAM_1);
 }
 
+uint32_t Adc::DMAPosition::Get(void)
+{
+    return kDMABufferSize - LL_DMA_GetDataLength(DMA1, LL_DMA_STREAM_1);
+}
+
 void Adc::DMAService(void)
 {
     ScopedProfilingPin<PROFILE_ADC_DMA_SERVICE> profile;
+    ScopedProfilingZone<PROFILE_ADC_DMA_SERVICE> zone;
+    timing_.Enter(read_index_ / (kDMABufferSize / 2));
     LL_DMA_ClearFlag_TC1(DMA1);
     LL_DMA_ClearFlag_HT1(DMA1);
 
+    // One pot per block: see kAudioBlockSize for the resulting pot rate
     if (!LL_ADC_REG_IsConversionOngoing(ADC1))
     {
         float pot = LL_ADC_REG_ReadConversionData16(ADC1);
@@ -136,6 +144,7 @@ void Adc::DMAService(void)
     }
 
     PerformCallback();
+    timing_.Exit();
 }
 
 void Adc::DMAHandler(void)
@@ -270,6 +279,8 @@ void Adc::Init(Callback callback)
     }
 
     Reset();
+    timing_.Init(kDMABufferSize,
+        system::kSystemClock / kAudioSampleRateHz * kAudioBlockSize);
 
     InitGPIO();
 
@@ -329,6 +340,7 @@ void Adc::Reset(void)
 {
     read_index_ = 0;
     current_pot_ = 0;
+    pot_ = {};
 
     for (uint32_t i = 0; i < NUM_POTS; i++)
     {
@@ -351,6 +363,7 @@ void Adc::Start(void)
         LL_ADC_REG_StartConversion(ADC2);
 
         DMA1->LIFCR = 0x7D << (8 * LL_DMA_STREAM_1);
+        timing_.Restart();
         LL_DMA_EnableStream(DMA1, LL_DMA_STREAM_1);
 
         started_ = true;
@@ -6,6 +6,8 @@
 #include "libDaisy/Drivers/STM32H7xx_HAL_Driver/Inc/stm32h7xx_ll_adc.h"
 
 #include "common/io.h"
+#include "drivers/audio_block.h"
+#include "drivers/audio_timing.h"
 #include "util/hysteresis_filter.h"
 #include "util/interpolator.h"
 
@@ -21,9 +23,21 @@ public:
     void Start(void);
     void Stop(void);
 
+    const AudioTimingStats& timing(void) const
+    {
+        return timing_.stats();
+    }
+
+    // Updated from the DMA interrupt, so a value may be one callback stale
+    const PotInput& pot(void) const
+    {
+        return pot_;
+    }
+
 protected:
     static inline Adc* instance_;
     Callback callback_;
+    PotInput pot_;
     bool started_;
 
     struct PotFilter
@@ -112,13 +126,21 @@ protected:
 
     PotFilter pot_filter_[NUM_POTS];
     uint32_t current_pot_;
+    // Ping-pong: the DMA fills one block while the callback reads the other
     static constexpr uint32_t kDMABufferSize =
-        NUM_AUDIO_INS * kAudioOSFactor * 2;
+        NUM_AUDIO_INS * kAudioOSBlockSize * 2;
 
     __attribute__ ((section (".dma")))
     static inline uint32_t dma_buffer_[kDMABufferSize];
     uint32_t read_index_;
 
+    struct DMAPosition
+    {
+        static uint32_t Get(void);
+    };
+
+    AudioTiming<DMAPosition> timing_;
+
     void InitGPIO(void);
 
     void InitDMA(void);
@@ -134,25 +156,22 @@ protected:
 
     void PerformCallback(void)
     {
-        PotInput pot;
-        AudioInput audio;
+        constexpr uint32_t kBlockSize = kDMABufferSize / 2;
 
         for (uint32_t i = 0; i < NUM_POTS; i++)
         {
-            pot[i] = pot_filter_[i].Next();
+            pot_[i] = pot_filter_[i].Next();
         }
 
-        for (uint32_t idx = 0; idx < kAudioOSFactor; idx++)
-        {
-            for (uint32_t ch = 0; ch < NUM_AUDIO_INS; ch++)
-            {
-                float sample = dma_buffer_[read_index_];
-                read_index_ = (read_index_ + 1) % kDMABufferSize;
-                audio[ch][idx] = (sample / 0xFFFF) * 2 - 1;
-            }
-        }
+        // The DMA has moved on to the other half, so convert this one in
+        // place and hand it over without copying
+        uint32_t* block = &dma_buffer_[read_index_];
+        read_index_ = (read_index_ + kBlockSize) % kDMABufferSize;
+        ConvertADCBlock(block, kBlockSize);
 
-        callback_(audio, pot);
+        AudioInput audio = {std::span<const float, kBlockSize>(
+            SampleView(block), kBlockSize)};
+        callback_(audio, pot_);
     }
 };
 
@@ -6,6 +6,7 @@
 
 #include "common/io.h"
 #include "common/config.h"
+#include "util/fastmath.h"
 
 namespace recorder
 {
@@ -13,8 +14,11 @@ namespace recorder
 class Analog
 {
 public:
-    using Callback =
-        const AudioOutput (*)(const AudioInput&, const PotInput& pot);
+    // Called from the ADC DMA interrupt with each block of kAudioBlockSize
+    // base-rate samples. `out` views the half of the DAC buffer that plays
+    // next and must be filled in full.
+    using Callback = void (*)(const AudioInput& in, const AudioOutput& out,
+        const PotInput& pot);
 
     void Init(Callback callback);
 
@@ -38,6 +42,16 @@ public:
         return state_ == STATE_STOPPED;
     }
 
+    const AudioTimingStats& timing(void) const
+    {
+        return adc_.timing();
+    }
+
+    const PotInput& pot(void) const
+    {
+        return adc_.pot();
+    }
+
     void Start(bool enable_amplifier)
     {
         if (state_ == STATE_STOPPED)
@@ -100,16 +114,16 @@ protected:
     float FadeCurve(float tau)
     {
         tau = std::clamp<float>(tau, 0, 1);
-        return 0.5 * (1 - std::cos(kPi * tau)) - 1;
+        return 0.5 * (1 - Cos(kPi * tau)) - 1;
     }
 
     void Service(const AudioInput& in, const PotInput& pot)
     {
-        AudioOutput out;
+        AudioOutput out = dac_.Block();
 
         if (state_ == STATE_STARTING)
         {
-            for (uint32_t i = 0; i < kAudioOSFactor; i++)
+            for (uint32_t i = 0; i < kAudioOSBlockSize; i++)
             {
                 fade_position_ += 1 / kFadeDuration;
 
@@ -126,7 +140,7 @@ protected:
         }
         else if (state_ == STATE_RUNNING)
         {
-            out = callback_(in, pot);
+            callback_(in, out, pot);
 
             if (cue_stop_)
             {
@@ -140,7 +154,7 @@ protected:
         }
         else if (state_ == STATE_STOPPING)
         {
-            for (uint32_t i = 0; i < kAudioOSFactor; i++)
+            for (uint32_t i = 0; i < kAudioOSBlockSize; i++)
             {
                 fade_position_ -= 1 / kFadeDuration;
 
@@ -149,19 +163,20 @@ protected:
                     out[ch][i] = FadeCurve(fade_position_);
                 }
             }
-
-            if (fade_position_ <= 0)
-            {
-                state_ = STATE_STOPPED;
-                StopTimer();
-                adc_.Stop();
-                dac_.Stop();
-                amp_enable_.Clear();
-                boost_enable_.Clear();
-            }
         }
 
-        dac_.Process(out);
+        dac_.Commit();
+
+        // Stopping resets the DAC buffer, so wait until the block is done
+        if (state_ == STATE_STOPPING && fade_position_ <= 0)
+        {
+            state_ = STATE_STOPPED;
+            StopTimer();
+            adc_.Stop();
+            dac_.Stop();
+            amp_enable_.Clear();
+            boost_enable_.Clear();
+        }
     }
 };
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+namespace recorder
+{
+
+// A sample stored in a uint32_t DMA buffer word. Blocks are converted in
+// place, so a half of the buffer holds raw codes while the DMA owns it and
+// samples while the callback does; may_alias keeps the compiler from
+// reordering the two views of the same memory.
+using AudioSample = float __attribute__((__may_alias__));
+
+static_assert(sizeof(AudioSample) == sizeof(uint32_t));
+
+inline AudioSample* SampleView(uint32_t *block)
+{
+    return reinterpret_cast<AudioSample*>(block);
+}
+
+// 16-bit ADC codes to samples on [-1, 1]. Straight-line loops with no
+// wraparound, so the compiler can unroll and vectorize them.
+inline void ConvertADCBlock(uint32_t *block, uint32_t size)
+{
+    AudioSample *samples = SampleView(block);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        samples[i] = float(block[i]) * (2.f / 0xFFFF) - 1;
+    }
+}
+
+// Samples on [-1, 1] to 12-bit DAC codes
+inline void ConvertDACBlock(uint32_t *block, uint32_t size)
+{
+    AudioSample *samples = SampleView(block);
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        float sample = std::clamp(0.5f * (samples[i] + 1), 0.f, 1.f);
+        block[i] = 0.5f + 0xFFF * sample;
+    }
+}
+
+}
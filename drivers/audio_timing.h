@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+
+#include "drivers/profiling_zone.h"
+
+namespace recorder
+{
+
+struct AudioTimingStats
+{
+    // Histogram buckets are powers of 4 ticks: [0, 4), [4, 16), ... with the
+    // last bucket open-ended
+    static constexpr uint32_t kNumBuckets = 8;
+
+    uint32_t callbacks;
+    uint32_t late;          // Entered after the DMA had wrapped into our half
+    uint32_t overruns;      // The DMA wrapped into our half while we ran
+    uint32_t max_jitter;
+    uint32_t max_execution;
+    uint32_t jitter[kNumBuckets];
+    uint32_t execution[kNumBuckets];
+
+    void Reset(void)
+    {
+        callbacks = late = overruns = 0;
+        max_jitter = max_execution = 0;
+
+        for (uint32_t i = 0; i < kNumBuckets; i++)
+        {
+            jitter[i] = execution[i] = 0;
+        }
+    }
+
+    static uint32_t Bucket(uint32_t ticks)
+    {
+        uint32_t bucket = (31 - __builtin_clz(ticks | 1)) / 2;
+        return (bucket < kNumBuckets) ? bucket : kNumBuckets - 1;
+    }
+};
+
+// Deadline accounting for a callback serviced from the half-transfer and
+// transfer-complete interrupts of a circular DMA. The callback owns the half
+// the DMA has just finished; if the DMA is already back in that half when
+// the callback starts or ends, the samples it reads or writes have been
+// overwritten, which is heard as a click.
+//
+// `DMAPosition::Get()` returns the index of the next buffer item the DMA
+// will transfer, and `Clock` is one of the profiling clocks. Both are
+// template parameters so the accounting can run on the host against a
+// simulated DMA.
+template <typename DMAPosition, typename Clock = profiling::DefaultClock>
+class AudioTiming
+{
+public:
+    // `period` is the expected time between callbacks in clock ticks
+    void Init(uint32_t buffer_size, uint32_t period)
+    {
+        half_size_ = buffer_size / 2;
+        period_ = period;
+        stats_.Reset();
+        Restart();
+    }
+
+    // Call when the DMA is (re)started so the gap isn't counted as jitter
+    void Restart(void)
+    {
+        first_ = true;
+    }
+
+    // `half` is the half of the buffer the callback is about to service
+    void Enter(uint32_t half)
+    {
+        uint32_t now = Clock::Now();
+
+        if (!first_)
+        {
+            uint32_t interval = now - entry_;
+            uint32_t jitter = (interval > period_) ?
+                interval - period_ : period_ - interval;
+            stats_.jitter[AudioTimingStats::Bucket(jitter)]++;
+            stats_.max_jitter = (jitter > stats_.max_jitter) ?
+                jitter : stats_.max_jitter;
+        }
+
+        first_ = false;
+        entry_ = now;
+        half_ = half;
+        stats_.callbacks++;
+        stats_.late += DMAInHalf();
+    }
+
+    void Exit(void)
+    {
+        uint32_t execution = Clock::Now() - entry_;
+        stats_.execution[AudioTimingStats::Bucket(execution)]++;
+        stats_.max_execution = (execution > stats_.max_execution) ?
+            execution : stats_.max_execution;
+        stats_.overruns += DMAInHalf();
+    }
+
+    // Read without locking, so a value may be one callback stale
+    const AudioTimingStats& stats(void) const
+    {
+        return stats_;
+    }
+
+protected:
+    AudioTimingStats stats_;
+    uint32_t half_size_;
+    uint32_t period_;
+    uint32_t entry_;
+    uint32_t half_;
+    bool first_;
+
+    bool DMAInHalf(void)
+    {
+        return DMAPosition::Get() / half_size_ == half_;
+    }
+};
+
+}
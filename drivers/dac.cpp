@@ -20,7 +20,7 @@ void Dac::Init(void)
 
 void Dac::Reset(void)
 {
-    write_index_ = (kAudioOSFactor * 2) % kDMABufferSize;
+    write_index_ = 0;
 
     for (uint32_t i = 0; i < kDMABufferSize; i++)
     {
@@ -135,6 +135,7 @@ void Dac::InitDMA(void)
 void Dac::DMAHandler(void)
 {
     ScopedProfilingPin<PROFILE_DAC_DMA_SERVICE> profile;
+    ScopedProfilingZone<PROFILE_DAC_DMA_SERVICE> zone;
     LL_DMA_ClearFlag_TC0(DMA1);
     LL_DMA_ClearFlag_HT0(DMA1);
     LL_DMA_IsActiveFlag_TC0(DMA1);
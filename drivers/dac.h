@@ -1,9 +1,8 @@
 #pragma once
 
-#include <algorithm>
-
 #include "common/config.h"
 #include "common/io.h"
+#include "drivers/audio_block.h"
 
 namespace recorder
 {
@@ -13,16 +12,20 @@ class Dac
 public:
     void Init(void);
 
-    void Process(const AudioOutput& audio)
+    // The half of the buffer the DMA plays next, for the callback to render
+    // into directly
+    AudioOutput Block(void)
+    {
+        return {std::span<float, kAudioOSBlockSize>(
+            SampleView(&dma_buffer_[write_index_]), kAudioOSBlockSize)};
+    }
+
+    // Converts the block from Block() to DAC codes in place and moves on to
+    // the other half
+    void Commit(void)
     {
-        for (uint32_t i = 0; i < kAudioOSFactor; i++)
-        {
-            float sample = audio[AUDIO_OUT_LINE][i];
-            sample = std::clamp<float>(0.5 * (sample + 1), 0, 1);
-            uint32_t code = 0.5 + 0xFFF * sample;
-            dma_buffer_[write_index_] = code;
-            write_index_ = (write_index_ + 1) % kDMABufferSize;
-        }
+        ConvertDACBlock(&dma_buffer_[write_index_], kAudioOSBlockSize);
+        write_index_ = (write_index_ + kAudioOSBlockSize) % kDMABufferSize;
     }
 
     void Start(void);
@@ -34,7 +37,9 @@ protected:
     void InitDMA(void);
     void Reset(void);
 
-    static constexpr uint32_t kDMABufferSize = kAudioOSFactor * 2;
+    // Ping-pong: the callback fills one block while the DMA plays the other
+    static_assert(NUM_AUDIO_OUTS == 1);
+    static constexpr uint32_t kDMABufferSize = kAudioOSBlockSize * 2;
     __attribute__ ((section (".dma")))
     static inline uint32_t dma_buffer_[kDMABufferSize];
     uint32_t write_index_;
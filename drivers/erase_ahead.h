@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+namespace recorder
+{
+
+struct EraseAheadStats
+{
+    uint32_t checks;        // Sectors blank-checked
+    uint32_t erases;
+    uint32_t erased_bytes;
+};
+
+// Keeps a bitmap in RAM of the sectors of `Storage` known to be erased, and
+// erases ranges ahead of time from the main loop. Nothing is known at boot;
+// a sector's state is learned the first time a range that covers it is
+// serviced, by a blank check, and kept up to date from then on by the
+// erases done here and the writes reported to Invalidate().
+//
+// `Storage` is Flash, or anything with its erase granularity, block sizes,
+// BeginErase(), FinishErase(), Writable() and busy(). Writes to the ranges
+// serviced here have to be reported, or the bitmap goes stale.
+template <typename Storage>
+class EraseAhead
+{
+public:
+    EraseAhead(Storage& storage) : storage_{storage} {}
+
+    void Init(void)
+    {
+        std::fill_n(known_, kNumWords, 0);
+        std::fill_n(erased_, kNumWords, 0);
+        in_flight_ = {};
+        stats_ = {};
+    }
+
+    // Call before programming a range. An erase still in flight finishes
+    // before the program can start, so it counts as done.
+    void Invalidate(uint32_t location, uint32_t length)
+    {
+        Settle();
+        uint32_t end = SectorAfter(location + length);
+
+        for (uint32_t sector = location / kSectorSize; sector < end; sector++)
+        {
+            Set(known_, sector, true);
+            Set(erased_, sector, false);
+        }
+    }
+
+    // Bytes of a range, in whole sectors, known to be erased
+    uint32_t erased_bytes(uint32_t location, uint32_t length)
+    {
+        uint32_t end = SectorAfter(location + length);
+        uint32_t count = 0;
+
+        for (uint32_t sector = location / kSectorSize; sector < end; sector++)
+        {
+            count += Get(erased_, sector);
+        }
+
+        return count * kSectorSize;
+    }
+
+    const EraseAheadStats& stats(void) const
+    {
+        return stats_;
+    }
+
+    // Takes one step towards the whole of a range being erased: one blank
+    // check of a sector, or one erase of the largest block that fits in the
+    // range. Returns immediately while the storage is busy, and true once
+    // every sector in the range is known to be erased.
+    bool Service(uint32_t location, uint32_t length)
+    {
+        if (storage_.busy())
+        {
+            return false;
+        }
+
+        Settle();
+
+        uint32_t first = location / kSectorSize;
+        uint32_t end = SectorAfter(location + length);
+        uint32_t sector = first;
+
+        while (sector < end && Get(erased_, sector))
+        {
+            sector++;
+        }
+
+        if (sector == end)
+        {
+            return true;
+        }
+
+        Block block = BlockAt(sector, first, end);
+        uint32_t block_end = block.sector + block.count;
+        bool dirty = false;
+
+        for (uint32_t s = block.sector; s < block_end && !dirty; s++)
+        {
+            dirty = Get(known_, s) && !Get(erased_, s);
+        }
+
+        // A sector nothing is known about may already be blank, as on a new
+        // part, which is cheaper to find out than to erase
+        if (!dirty)
+        {
+            uint32_t s = block.sector;
+
+            while (Get(known_, s))
+            {
+                s++;
+            }
+
+            bool blank = storage_.Writable(s * kSectorSize, kSectorSize);
+            Set(known_, s, true);
+            Set(erased_, s, blank);
+            stats_.checks++;
+
+            if (blank)
+            {
+                return false;
+            }
+        }
+
+        Erase(block);
+        return false;
+    }
+
+protected:
+    static constexpr uint32_t kSectorSize = Storage::kEraseGranularity;
+    static constexpr uint32_t kNumSectors = Storage::kSize / kSectorSize;
+    static constexpr uint32_t kNumWords = (kNumSectors + 31) / 32;
+
+    // Largest first, each a multiple of the next
+    static constexpr uint32_t kBlockSizes[] =
+    {
+        Storage::kBlock64Size,
+        Storage::kBlock32Size,
+        kSectorSize,
+    };
+
+    struct Block
+    {
+        uint32_t sector;
+        uint32_t count;
+    };
+
+    Storage& storage_;
+    uint32_t known_[kNumWords];
+    uint32_t erased_[kNumWords];
+    Block in_flight_;
+    EraseAheadStats stats_;
+
+    static uint32_t SectorAfter(uint32_t location)
+    {
+        return (location + kSectorSize - 1) / kSectorSize;
+    }
+
+    static bool Get(const uint32_t* bits, uint32_t sector)
+    {
+        return bits[sector / 32] & (1u << (sector % 32));
+    }
+
+    static void Set(uint32_t* bits, uint32_t sector, bool value)
+    {
+        uint32_t mask = 1u << (sector % 32);
+        bits[sector / 32] = value ?
+            (bits[sector / 32] | mask) :
+            (bits[sector / 32] & ~mask);
+    }
+
+    // The largest aligned block holding `sector` that lies within the range
+    static Block BlockAt(uint32_t sector, uint32_t first, uint32_t end)
+    {
+        for (uint32_t size : kBlockSizes)
+        {
+            uint32_t count = size / kSectorSize;
+            uint32_t start = sector - (sector % count);
+
+            if (start >= first && start + count <= end)
+            {
+                return {start, count};
+            }
+        }
+
+        return {sector, 1};
+    }
+
+    void Erase(const Block& block)
+    {
+        uint32_t block_end = block.sector + block.count;
+
+        for (uint32_t s = block.sector; s < block_end; s++)
+        {
+            Set(known_, s, true);
+            Set(erased_, s, false);
+        }
+
+        storage_.BeginErase(block.sector * kSectorSize, block.count * kSectorSize);
+        storage_.FinishErase();
+        in_flight_ = block;
+        stats_.erases++;
+        stats_.erased_bytes += block.count * kSectorSize;
+    }
+
+    // Marks the last erase done. Only call once nothing can use its sectors
+    // before the storage has finished it.
+    void Settle(void)
+    {
+        uint32_t block_end = in_flight_.sector + in_flight_.count;
+
+        for (uint32_t s = in_flight_.sector; s < block_end; s++)
+        {
+            Set(erased_, s, true);
+        }
+
+        in_flight_ = {};
+    }
+};
+
+}
@@ -5,7 +5,7 @@
 namespace recorder
 {
 
-void Flash::Init(void)
+void Flash::InitPeripheral(void)
 {
     __HAL_RCC_GPIOF_CLK_ENABLE();
     __HAL_RCC_GPIOG_CLK_ENABLE();
@@ -19,35 +19,6 @@ void Flash::Init(void)
     InitDMA();
 
     __HAL_RCC_QSPI_CLK_ENABLE();
-    while (QUADSPI->SR & QUADSPI_SR_BUSY);
-    uint32_t prescaler = 1;
-    uint32_t fifo_threshold = 1;
-    QUADSPI->CR =
-        ((prescaler - 1) << QUADSPI_CR_PRESCALER_Pos) |
-        ((fifo_threshold - 1) << QUADSPI_CR_FTHRES_Pos) |
-        QSPI_FLASH_ID_1 |
-        QSPI_DUALFLASH_DISABLE |
-        QSPI_SAMPLE_SHIFTING_NONE;
-    QUADSPI->DCR =
-        ((POSITION_VAL(kSize) - 1) << QUADSPI_DCR_FSIZE_Pos) |
-        QSPI_CS_HIGH_TIME_2_CYCLE |
-        QSPI_CLOCK_MODE_0;
-    QUADSPI->CR |= QUADSPI_CR_EN;
-
-    ExitPowerDown();
-    Reset();
-
-    if (ReadStatus() != STATUS_QUAD_ENABLE)
-    {
-        WriteStatus(STATUS_QUAD_ENABLE);
-    }
-
-    state_ =
-    {
-        .location = 0,
-        .length = 0,
-        .bytes = nullptr,
-    };
 }
 
 void Flash::InitPin(GPIO_TypeDef* base, uint32_t pin, uint32_t alternate)
@@ -112,64 +83,4 @@ void Flash::InitDMA(void)
     LL_MDMA_Init(MDMA, LL_MDMA_CHANNEL_0, &mdma_init);
 }
 
-void Flash::ReadData(uint8_t* buffer, uint32_t address, uint32_t count)
-{
-    ScopedProfilingPin<PROFILE_FLASH_READ> profile1;
-    ScopedProfilingPin<PROFILE_FLASH_ACCESS> profile2;
-
-    while (count)
-    {
-        LL_MDMA_DisableChannel(MDMA, LL_MDMA_CHANNEL_0);
-        uint32_t dest_addr = reinterpret_cast<uint32_t>(buffer);
-        LL_MDMA_SetDestinationAddress(MDMA, LL_MDMA_CHANNEL_0, dest_addr);
-        uint32_t bus = (dest_addr & 0xDF000000) ?
-            LL_MDMA_DEST_BUS_SYSTEM_AXI :
-            LL_MDMA_DEST_BUS_AHB_TCM;
-        LL_MDMA_SetDestBusSelection(MDMA, LL_MDMA_CHANNEL_0, bus);
-        uint32_t block_length = std::min<uint32_t>(count, 0x10000);
-        LL_MDMA_SetBufferTransferLength(MDMA, LL_MDMA_CHANNEL_0,
-            std::min<uint32_t>(128, block_length) - 1);
-        LL_MDMA_SetBlkDataLength(MDMA, LL_MDMA_CHANNEL_0, block_length);
-
-        if (block_length < 128)
-        {
-            LL_MDMA_SetSourceBurstSize(
-                MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_SRC_BURST_SINGLE);
-            LL_MDMA_SetDestinationBurstSize(
-                MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_DEST_BURST_SINGLE);
-        }
-        else
-        {
-            LL_MDMA_SetSourceBurstSize(
-                MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_SRC_BURST_16BEATS);
-            LL_MDMA_SetDestinationBurstSize(
-                MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_DEST_BURST_16BEATS);
-        }
-
-        LL_MDMA_EnableChannel(MDMA, LL_MDMA_CHANNEL_0);
-
-        while (QUADSPI->SR & QUADSPI_SR_BUSY);
-        constexpr uint32_t dummy_cycles = 8;
-        QUADSPI->DLR = block_length - 1;
-        QUADSPI->CCR =
-            kIndirectRead |
-            QSPI_DATA_4_LINES |
-            (dummy_cycles << QUADSPI_CCR_DCYC_Pos) |
-            QSPI_ADDRESS_24_BITS |
-            QSPI_ADDRESS_1_LINE |
-            QSPI_INSTRUCTION_1_LINE |
-            CMD_FAST_READ_QUAD_OUT;
-        QUADSPI->AR = address;
-
-        while (!LL_MDMA_IsActiveFlag_BT(MDMA, LL_MDMA_CHANNEL_0));
-        LL_MDMA_ClearFlag_BT(MDMA, LL_MDMA_CHANNEL_0);
-        while (!(QUADSPI->SR & QUADSPI_SR_TCF));
-        QUADSPI->FCR = QUADSPI_FCR_CTCF;
-
-        count -= block_length;
-        buffer += block_length;
-        address += block_length;
-    }
-}
-
 }
@@ -5,6 +5,7 @@
 
 #include "drivers/profiling.h"
 #include "drivers/system.h"
+#include "drivers/qspi.h"
 
 namespace recorder
 {
@@ -14,13 +15,52 @@ class Flash
 public:
     static constexpr uint32_t kSize = 8 * 1024 * 1024;
     static constexpr uint32_t kEraseGranularity = 4 * 1024;
+    static constexpr uint32_t kBlock32Size = 32 * 1024;
+    static constexpr uint32_t kBlock64Size = 64 * 1024;
     static constexpr uint32_t kWriteGranularity = 1;
     static constexpr uint8_t kFillByte = 0xFF;
+    static constexpr uint32_t kFillWord = 0xFFFFFFFF;
+
+    void Init(void)
+    {
+        InitPeripheral();
+        mapped_ = false;
+
+        while (QUADSPI->SR & QUADSPI_SR_BUSY);
+        uint32_t prescaler = 1;
+        uint32_t fifo_threshold = 4;    // So polled reads can take words
+        QUADSPI->CR =
+            ((prescaler - 1) << QUADSPI_CR_PRESCALER_Pos) |
+            ((fifo_threshold - 1) << QUADSPI_CR_FTHRES_Pos) |
+            QSPI_FLASH_ID_1 |
+            QSPI_DUALFLASH_DISABLE |
+            QSPI_SAMPLE_SHIFTING_NONE;
+        QUADSPI->DCR =
+            ((POSITION_VAL(kSize) - 1) << QUADSPI_DCR_FSIZE_Pos) |
+            QSPI_CS_HIGH_TIME_2_CYCLE |
+            QSPI_CLOCK_MODE_0;
+        QUADSPI->CR |= QUADSPI_CR_EN;
+
+        ExitPowerDown();
+        Reset();
+
+        if (ReadStatus() != STATUS_QUAD_ENABLE)
+        {
+            WriteStatus(STATUS_QUAD_ENABLE);
+        }
 
-    void Init(void);
+        state_ =
+        {
+            .location = 0,
+            .length = 0,
+            .bytes = nullptr,
+        };
+    }
 
     void PowerDown(void)
     {
+        // The part ignores the command while it's programming or erasing
+        WaitForWriteInProgress();
         EnterPowerDown();
     }
 
@@ -38,31 +78,67 @@ public:
         return true;
     }
 
-    bool Writable(uint32_t location, uint32_t length)
+    // Copies through the memory-mapped window. The flash streams the data
+    // for as long as the addresses are sequential, so large reads cost one
+    // command in all.
+    bool ReadMapped(void* dst, uint32_t location, uint32_t length)
     {
         WaitForWriteInProgress();
+        ScopedProfilingPin<PROFILE_FLASH_READ> profile1;
+        ScopedProfilingPin<PROFILE_FLASH_ACCESS> profile2;
+        Map();
 
-        uint8_t buffer[1024];
+        auto bytes = reinterpret_cast<uint8_t*>(dst);
+        uint32_t end = location + length;
 
-        while (length)
+        while (location < end)
         {
-            uint32_t len = std::min<uint32_t>(1024, length);
+            uint32_t word = qspi::ReadMapped32(location & ~3);
+            uint32_t offset = location & 3;
+            uint32_t count = std::min(4 - offset, end - location);
 
-            if (!Read(buffer, location, len))
+            if (count == 4 && (reinterpret_cast<uintptr_t>(bytes) & 3) == 0)
             {
-                return false;
+                *reinterpret_cast<uint32_t*>(bytes) = word;
             }
-
-            for (uint32_t i = 0; i < len; i++)
+            else
             {
-                if (buffer[i] != kFillByte)
+                for (uint32_t i = 0; i < count; i++)
                 {
-                    return false;
+                    bytes[i] = word >> (8 * (offset + i));
                 }
             }
 
-            location += len;
-            length -= len;
+            bytes += count;
+            location += count;
+        }
+
+        return true;
+    }
+
+    // Checks a word at a time through the memory-mapped window, with no
+    // copy
+    bool Writable(uint32_t location, uint32_t length)
+    {
+        WaitForWriteInProgress();
+        Map();
+
+        uint32_t end = location + length;
+
+        while (location < end)
+        {
+            uint32_t word = qspi::ReadMapped32(location & ~3);
+            uint32_t offset = location & 3;
+            uint32_t count = std::min(4 - offset, end - location);
+            uint32_t mask = (count == 4) ? 0xFFFFFFFF :
+                ((1u << (8 * count)) - 1) << (8 * offset);
+
+            if ((word & mask) != (kFillWord & mask))
+            {
+                return false;
+            }
+
+            location += count;
         }
 
         return true;
@@ -123,6 +199,13 @@ public:
         return done;
     }
 
+    // True while a program or erase started by FinishWrite() or
+    // FinishErase() is still under way
+    bool busy(void)
+    {
+        return write_in_progress();
+    }
+
     void AbortWrite(void)
     {
         ProfilingPin<PROFILE_FLASH_WRITE>::Clear();
@@ -210,9 +293,15 @@ public:
 
 protected:
     static constexpr uint32_t kPageSize = 256;
-    static constexpr uint32_t kBlock32Size = 32 * 1024;
-    static constexpr uint32_t kBlock64Size = 64 * 1024;
 
+    // Transfers shorter than this are polled, where setting up the MDMA
+    // would take longer than the transfer
+    static constexpr uint32_t kMinDMALength = 64;
+
+    bool mapped_;
+
+    // Pins, clocks and the MDMA channel
+    void InitPeripheral(void);
     void InitPin(GPIO_TypeDef* base, uint32_t pin, uint32_t alternate);
     void InitDMA(void);
 
@@ -220,6 +309,7 @@ protected:
     {
         CMD_WRITE_STATUS_REG    = 0x01,
         CMD_PAGE_PROGRAM        = 0x02,
+        CMD_QUAD_PAGE_PROGRAM   = 0x32,
         CMD_NORMAL_READ         = 0x03,
         CMD_FAST_READ           = 0x0B,
         CMD_READ_STATUS_REG     = 0x05,
@@ -257,9 +347,53 @@ protected:
 
     static constexpr uint32_t kIndirectWrite = 0;
     static constexpr uint32_t kIndirectRead = QUADSPI_CCR_FMODE_0;
+    static constexpr uint32_t kMemoryMapped =
+        QUADSPI_CCR_FMODE_0 | QUADSPI_CCR_FMODE_1;
+    static constexpr uint32_t kReadDummyCycles = 8;
+
+    // Quad output fast read, used for indirect and memory-mapped reads
+    static constexpr uint32_t kQuadRead =
+        QSPI_DATA_4_LINES |
+        (kReadDummyCycles << QUADSPI_CCR_DCYC_Pos) |
+        QSPI_ADDRESS_24_BITS |
+        QSPI_ADDRESS_1_LINE |
+        QSPI_INSTRUCTION_1_LINE |
+        CMD_FAST_READ_QUAD_OUT;
+
+    // Quad input page program, which takes the data on all four lines once
+    // QE is set, as Init() leaves it
+    static constexpr uint32_t kQuadProgram =
+        QSPI_DATA_4_LINES |
+        QSPI_ADDRESS_24_BITS |
+        QSPI_ADDRESS_1_LINE |
+        QSPI_INSTRUCTION_1_LINE |
+        CMD_QUAD_PAGE_PROGRAM;
+
+    // Memory-mapped mode holds the peripheral busy until it is aborted, so
+    // every other access calls Unmap() first
+    void Map(void)
+    {
+        if (!mapped_)
+        {
+            while (QUADSPI->SR & QUADSPI_SR_BUSY);
+            QUADSPI->CCR = kMemoryMapped | kQuadRead;
+            mapped_ = true;
+        }
+    }
+
+    void Unmap(void)
+    {
+        if (mapped_)
+        {
+            QUADSPI->CR |= QUADSPI_CR_ABORT;
+            while (QUADSPI->CR & QUADSPI_CR_ABORT);
+            mapped_ = false;
+        }
+    }
 
     void SendCommand(Command cmd)
     {
+        Unmap();
         while (QUADSPI->SR & QUADSPI_SR_BUSY);
         QUADSPI->CCR = QSPI_INSTRUCTION_1_LINE | kIndirectWrite | cmd;
         while (!(QUADSPI->SR & QUADSPI_SR_TCF));
@@ -281,15 +415,86 @@ protected:
 
     uint8_t DataRead8(void)
     {
-        return *reinterpret_cast<volatile uint8_t*>(&QUADSPI->DR);
+        return qspi::Read8();
     }
 
     void DataWrite8(uint8_t byte)
     {
-        *reinterpret_cast<volatile uint8_t*>(&(QUADSPI->DR)) = byte;
+        qspi::Write8(byte);
     }
 
-    void ReadData(uint8_t* buffer, uint32_t address, uint32_t count);
+    void ReadData(uint8_t* buffer, uint32_t address, uint32_t count)
+    {
+        ScopedProfilingPin<PROFILE_FLASH_READ> profile1;
+        ScopedProfilingPin<PROFILE_FLASH_ACCESS> profile2;
+        Unmap();
+
+        while (count)
+        {
+            uint32_t block_length = std::min<uint32_t>(count, 0x10000);
+            bool aligned = !(reinterpret_cast<uintptr_t>(buffer) & 3);
+
+            if (block_length < kMinDMALength)
+            {
+                ReadPolled(buffer, address, block_length);
+            }
+            else
+            {
+                // Whole words where the buffer allows, the rest in bytes
+                if (aligned)
+                {
+                    block_length &= ~3;
+                }
+
+                qspi::StartReadDMA(buffer, block_length, aligned ? 4 : 1);
+                StartRead(address, block_length);
+                qspi::FinishDMA();
+                FinishCommand();
+            }
+
+            count -= block_length;
+            buffer += block_length;
+            address += block_length;
+        }
+    }
+
+    // Drains the FIFO from the CPU, a word at a time while a whole word is
+    // waiting
+    void ReadPolled(uint8_t* buffer, uint32_t address, uint32_t count)
+    {
+        StartRead(address, count);
+
+        while (count >= 4)
+        {
+            while (!(QUADSPI->SR & QUADSPI_SR_FTF));
+            uint32_t word = qspi::Read32();
+            std::copy_n(reinterpret_cast<uint8_t*>(&word), 4, buffer);
+            buffer += 4;
+            count -= 4;
+        }
+
+        while (count--)
+        {
+            while (!(QUADSPI->SR & QUADSPI_SR_FLEVEL));
+            *buffer++ = DataRead8();
+        }
+
+        FinishCommand();
+    }
+
+    void StartRead(uint32_t address, uint32_t count)
+    {
+        while (QUADSPI->SR & QUADSPI_SR_BUSY);
+        QUADSPI->DLR = count - 1;
+        QUADSPI->CCR = kIndirectRead | kQuadRead;
+        QUADSPI->AR = address;
+    }
+
+    void FinishCommand(void)
+    {
+        while (!(QUADSPI->SR & QUADSPI_SR_TCF));
+        QUADSPI->FCR = QUADSPI_FCR_CTCF;
+    }
 
     void PageProgram(const uint8_t* buffer, uint32_t address, uint32_t count,
         bool blocking)
@@ -297,23 +502,24 @@ protected:
         WriteEnable();
         while (QUADSPI->SR & QUADSPI_SR_BUSY);
         QUADSPI->DLR = count - 1;
-        QUADSPI->CCR =
-            kIndirectWrite |
-            QSPI_DATA_1_LINE |
-            QSPI_ADDRESS_24_BITS |
-            QSPI_ADDRESS_1_LINE |
-            QSPI_INSTRUCTION_1_LINE |
-            CMD_PAGE_PROGRAM;
+        QUADSPI->CCR = kIndirectWrite | kQuadProgram;
         QUADSPI->AR = address;
 
-        while (count--)
+        if (count < kMinDMALength)
         {
-            while (!(QUADSPI->SR & QUADSPI_SR_FTF));
-            DataWrite8(*buffer++);
+            WritePolled(buffer, count);
+        }
+        else
+        {
+            // Whole words where the buffer allows, the rest in bytes
+            bool aligned = !(reinterpret_cast<uintptr_t>(buffer) & 3);
+            uint32_t dma_length = aligned ? (count & ~3) : count;
+            qspi::StartWriteDMA(buffer, dma_length, aligned ? 4 : 1);
+            qspi::FinishDMA();
+            WritePolled(buffer + dma_length, count - dma_length);
         }
 
-        while (!(QUADSPI->SR & QUADSPI_SR_TCF));
-        QUADSPI->FCR = QUADSPI_FCR_CTCF;
+        FinishCommand();
 
         if (blocking)
         {
@@ -321,6 +527,27 @@ protected:
         }
     }
 
+    // Fills the FIFO from the CPU, a word at a time while there's room for
+    // a whole word
+    void WritePolled(const uint8_t* buffer, uint32_t count)
+    {
+        while (count >= 4)
+        {
+            uint32_t word;
+            std::copy_n(buffer, 4, reinterpret_cast<uint8_t*>(&word));
+            while (!(QUADSPI->SR & QUADSPI_SR_FTF));
+            qspi::Write32(word);
+            buffer += 4;
+            count -= 4;
+        }
+
+        while (count--)
+        {
+            while (!(QUADSPI->SR & QUADSPI_SR_FTF));
+            DataWrite8(*buffer++);
+        }
+    }
+
     void EraseCommand(Command command, uint32_t address,
         bool blocking)
     {
@@ -390,6 +617,7 @@ protected:
 
     uint8_t ReadStatus(void)
     {
+        Unmap();
         while (QUADSPI->SR & QUADSPI_SR_BUSY);
         QUADSPI->DLR = 0;
         QUADSPI->CCR =
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+namespace recorder
+{
+
+struct FlashStreamStats
+{
+    uint32_t refills;
+    uint32_t underruns;     // Items the audio path wanted that weren't resident
+    uint32_t bytes_read;
+};
+
+// Plays a recording straight out of flash instead of a copy in RAM. The
+// recording is split into blocks of `window_length` items, and `num_windows`
+// buffers hold the block being played and the ones after it in the direction
+// of play. Service() refills them from the main loop; the audio path only
+// ever reads resident windows, and gets silence (counted as an underrun) if
+// the one it needs hasn't arrived. The player's direction and speed are
+// passed to Service(), so it doesn't have to guess them from the position.
+//
+// `Storage` is Flash, or anything else with its Read(). Service() must run
+// at least once per block at the fastest playback speed, and a refill must
+// take less time than playing the blocks already resident.
+template <typename T, typename Storage, uint32_t window_length = 1024,
+          uint32_t num_windows = 3>
+class FlashStream
+{
+public:
+    static_assert(num_windows >= 2, "One window ahead of the one playing");
+
+    static constexpr uint32_t kNumWindows = num_windows;
+
+    FlashStream(Storage& storage) : storage_{storage} {}
+
+    // `address` is in bytes, `length` in items
+    void Open(uint32_t address, uint32_t length)
+    {
+        Close();
+        address_ = address;
+        num_blocks_ = (length + window_length - 1) / window_length;
+        position_.store(0, std::memory_order_relaxed);
+        stats_ = {};
+        length_ = length;
+    }
+
+    void Close(void)
+    {
+        length_ = 0;
+
+        for (Window& window : windows_)
+        {
+            window.block.store(kNoBlock, std::memory_order_release);
+        }
+    }
+
+    // Moves the position Service() prefetches around to where play is
+    // about to begin, so the first windows can be read before it does
+    void Cue(uint32_t position)
+    {
+        position_.store(position, std::memory_order_relaxed);
+    }
+
+    uint32_t length(void)
+    {
+        return length_;
+    }
+
+    const FlashStreamStats& stats(void) const
+    {
+        return stats_;
+    }
+
+    // Call from the main loop with the player's direction and speed. Reads
+    // at most one block per call, nearest first, so the loop isn't held up
+    // for long. The block being played is wanted, then a block ahead of it
+    // in the direction of play for each sample per sample of speed, and
+    // the rest of the windows hold the blocks behind it, so a change of
+    // direction finds them resident. Scrubbing, at a speed of 0, keeps one
+    // block either side.
+    void Service(bool reverse, float speed)
+    {
+        if (length_ == 0)
+        {
+            return;
+        }
+
+        uint32_t position = position_.load(std::memory_order_relaxed);
+        int32_t direction = reverse ? -1 : 1;
+        int32_t ahead = std::clamp<float>(std::ceil(speed), 1, num_windows - 1);
+        uint32_t wanted[num_windows];
+        uint32_t block = position / window_length;
+
+        for (int32_t i = 0; i < int32_t(num_windows); i++)
+        {
+            int32_t offset = (i <= ahead) ? i : ahead - i;
+            wanted[i] = Wrap(block + direction * offset);
+        }
+
+        for (uint32_t i = 0; i < num_windows; i++)
+        {
+            if (Find(wanted[i]) < 0)
+            {
+                Refill(Victim(wanted), wanted[i]);
+                return;
+            }
+        }
+    }
+
+    class Cursor
+    {
+    public:
+        Cursor(FlashStream* stream) : stream_(stream) {}
+
+        // Seek() also reports the play position that Service() prefetches
+        // around; stepping with ++ and -- doesn't, so reading the next item
+        // to interpolate doesn't move it.
+        void Seek(uint32_t index)
+        {
+            index_ = index;
+            stream_->position_.store(index, std::memory_order_relaxed);
+        }
+
+        Cursor& operator++()
+        {
+            index_++;
+            return *this;
+        }
+
+        Cursor& operator--()
+        {
+            index_--;
+            return *this;
+        }
+
+        T operator*()
+        {
+            return stream_->Get(index_, window_);
+        }
+
+        uint32_t index(void) const
+        {
+            return index_;
+        }
+
+        template <typename U>
+        uint32_t Read(std::span<U> out)
+        {
+            uint32_t count = 0;
+
+            while (count < out.size() && index_ < stream_->length_)
+            {
+                out[count++] = **this;
+                index_++;
+            }
+
+            return count;
+        }
+
+    protected:
+        FlashStream* stream_;
+        uint32_t index_ = 0;
+        uint32_t window_ = 0;   // Where the last item was found
+    };
+
+    Cursor cursor(void)
+    {
+        return Cursor(this);
+    }
+
+protected:
+    static constexpr uint32_t kNoBlock = UINT32_MAX;
+
+    struct Window
+    {
+        std::atomic<uint32_t> block = kNoBlock;
+        T data[window_length];
+    };
+
+    Storage& storage_;
+    Window windows_[num_windows];
+    uint32_t address_ = 0;
+    uint32_t length_ = 0;
+    uint32_t num_blocks_ = 0;
+    std::atomic<uint32_t> position_ = 0;
+    FlashStreamStats stats_ = {};
+
+    // The audio path's side. Windows are only refilled after being marked
+    // empty, and the audio interrupt can't be preempted by the main loop, so
+    // a window found here stays valid until we return.
+    T Get(uint32_t index, uint32_t& hint)
+    {
+        if (index >= length_)
+        {
+            return T(0);
+        }
+
+        uint32_t block = index / window_length;
+
+        for (uint32_t i = 0; i < num_windows; i++)
+        {
+            uint32_t w = (hint + i) % num_windows;
+
+            if (windows_[w].block.load(std::memory_order_acquire) == block)
+            {
+                hint = w;
+                return windows_[w].data[index % window_length];
+            }
+        }
+
+        stats_.underruns++;
+        return T(0);
+    }
+
+    uint32_t Wrap(int32_t block)
+    {
+        int32_t num_blocks = num_blocks_;
+        return ((block % num_blocks) + num_blocks) % num_blocks;
+    }
+
+    int32_t Find(uint32_t block)
+    {
+        for (uint32_t w = 0; w < num_windows; w++)
+        {
+            if (windows_[w].block.load(std::memory_order_relaxed) == block)
+            {
+                return w;
+            }
+        }
+
+        return -1;
+    }
+
+    // A window holding none of the wanted blocks. There is always one when a
+    // wanted block is missing.
+    uint32_t Victim(const uint32_t (&wanted)[num_windows])
+    {
+        for (uint32_t w = 0; w < num_windows; w++)
+        {
+            uint32_t block = windows_[w].block.load(std::memory_order_relaxed);
+
+            if (std::find(wanted, wanted + num_windows, block) ==
+                wanted + num_windows)
+            {
+                return w;
+            }
+        }
+
+        return 0;
+    }
+
+    void Refill(uint32_t w, uint32_t block)
+    {
+        uint32_t first = block * window_length;
+        uint32_t count = std::min(window_length, length_ - first);
+        uint32_t size = count * sizeof(T);
+
+        windows_[w].block.store(kNoBlock, std::memory_order_release);
+        storage_.Read(windows_[w].data, address_ + first * sizeof(T), size);
+        windows_[w].block.store(block, std::memory_order_release);
+
+        stats_.refills++;
+        stats_.bytes_read += size;
+    }
+};
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "drivers/profiles.h"
+
+#if defined(STM32H750xx)
+#include "libDaisy/Drivers/CMSIS/Device/ST/STM32H7xx/Include/stm32h7xx.h"
+#else
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace recorder
+{
+
+namespace profiling
+{
+
+// Clock backends. Each provides Init() and Now(), a free-running 32-bit tick
+// count; zones are timed with unsigned differences, so wraparound is fine as
+// long as a zone is shorter than one wrap (67 s for the DWT at 64 MHz).
+
+#if defined(STM32H750xx)
+// Cortex-M7 DWT cycle counter
+class DWTClock
+{
+public:
+    static void Init(void)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->LAR = 0xC5ACCE55;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    static uint32_t Now(void)
+    {
+        return DWT->CYCCNT;
+    }
+};
+
+using DefaultClock = DWTClock;
+#else
+// Nanoseconds from std::chrono::steady_clock
+class ChronoClock
+{
+public:
+    static void Init(void) {}
+
+    static uint32_t Now(void)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+// Host timestamp counter, closer to cycles than ChronoClock but in units of
+// the invariant TSC frequency
+class TSCClock
+{
+public:
+    static void Init(void) {}
+
+    static uint32_t Now(void)
+    {
+        return __rdtsc();
+    }
+};
+#endif
+
+using DefaultClock = ChronoClock;
+#endif
+
+struct ZoneStats
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+
+    void Reset(void)
+    {
+        count = 0;
+        min = UINT32_MAX;
+        max = 0;
+        total = 0;
+    }
+
+    void Add(uint32_t ticks)
+    {
+        count++;
+        total += ticks;
+        min = (ticks < min) ? ticks : min;
+        max = (ticks > max) ? ticks : max;
+    }
+
+    uint32_t mean(void) const
+    {
+        return count ? total / count : 0;
+    }
+};
+
+// Statistics for every Profile, timed with `Clock`. Each zone should only be
+// entered from one interrupt priority, since the update isn't atomic.
+template <typename Clock = DefaultClock>
+class Zones
+{
+public:
+    static void Init(void)
+    {
+        Clock::Init();
+        Reset();
+    }
+
+    static void Reset(void)
+    {
+        for (ZoneStats &zone : stats_)
+        {
+            zone.Reset();
+        }
+    }
+
+    static const ZoneStats &stats(Profile profile)
+    {
+        return stats_[profile];
+    }
+
+    static void Add(Profile profile, uint32_t ticks)
+    {
+        stats_[profile].Add(ticks);
+    }
+
+protected:
+    static inline ZoneStats stats_[NUM_PROFILES];
+};
+
+}
+
+// Times its own lifetime into profiling::Zones. Compiles to nothing when
+// kEnableProfilingZones is false.
+template <Profile profile, typename Clock = profiling::DefaultClock>
+class ScopedProfilingZone
+{
+public:
+    ScopedProfilingZone()
+    {
+        if (kEnableProfilingZones)
+        {
+            start_ = Clock::Now();
+        }
+    }
+
+    ~ScopedProfilingZone()
+    {
+        if (kEnableProfilingZones)
+        {
+            profiling::Zones<Clock>::Add(profile, Clock::Now() - start_);
+        }
+    }
+
+protected:
+    uint32_t start_;
+};
+
+}
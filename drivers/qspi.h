@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "libDaisy/Drivers/STM32H7xx_HAL_Driver/Inc/stm32h7xx_ll_mdma.h"
+
+// Data register, MDMA and memory-mapped accesses to the QUADSPI peripheral
+// used by Flash. Register reads and writes go through QUADSPI directly; these
+// are the accesses that depend on their width or on another peripheral, kept
+// here so the host can substitute host/fake/drivers/qspi.h and run Flash
+// against a simulated peripheral.
+
+namespace recorder::qspi
+{
+
+inline uint8_t Read8(void)
+{
+    return *reinterpret_cast<volatile uint8_t*>(&QUADSPI->DR);
+}
+
+inline uint32_t Read32(void)
+{
+    return QUADSPI->DR;
+}
+
+inline void Write8(uint8_t byte)
+{
+    *reinterpret_cast<volatile uint8_t*>(&QUADSPI->DR) = byte;
+}
+
+inline void Write32(uint32_t word)
+{
+    QUADSPI->DR = word;
+}
+
+// Reads through the memory-mapped window, at a byte offset into the flash
+inline uint32_t ReadMapped32(uint32_t offset)
+{
+    return *reinterpret_cast<const volatile uint32_t*>(QSPI_BASE + offset);
+}
+
+// Sets MDMA channel 0 up to move `length` bytes from `src` to `dst` in
+// `width`-byte beats, triggered by the FIFO threshold. One side is the data
+// register, which stays put; the other is memory, which advances.
+inline void StartDMA(uint32_t src, uint32_t dst, uint32_t length, uint32_t width)
+{
+    LL_MDMA_DisableChannel(MDMA, LL_MDMA_CHANNEL_0);
+    uint32_t data_register = reinterpret_cast<uint32_t>(&QUADSPI->DR);
+    LL_MDMA_SetSourceAddress(MDMA, LL_MDMA_CHANNEL_0, src);
+    LL_MDMA_SetDestinationAddress(MDMA, LL_MDMA_CHANNEL_0, dst);
+    LL_MDMA_SetSourceBusSelection(MDMA, LL_MDMA_CHANNEL_0,
+        (src & 0xDF000000) ? LL_MDMA_SRC_BUS_SYSTEM_AXI : LL_MDMA_SRC_BUS_AHB_TCM);
+    LL_MDMA_SetDestBusSelection(MDMA, LL_MDMA_CHANNEL_0,
+        (dst & 0xDF000000) ? LL_MDMA_DEST_BUS_SYSTEM_AXI : LL_MDMA_DEST_BUS_AHB_TCM);
+    LL_MDMA_SetSourceIncMode(MDMA, LL_MDMA_CHANNEL_0, (src == data_register) ?
+        LL_MDMA_SRC_FIXED : LL_MDMA_SRC_INCREMENT);
+    LL_MDMA_SetDestinationIncMode(MDMA, LL_MDMA_CHANNEL_0, (dst == data_register) ?
+        LL_MDMA_DEST_FIXED : LL_MDMA_DEST_INCREMENT);
+
+    bool words = (width == 4);
+    LL_MDMA_SetSourceDataSize(MDMA, LL_MDMA_CHANNEL_0, words ?
+        LL_MDMA_SRC_DATA_SIZE_WORD : LL_MDMA_SRC_DATA_SIZE_BYTE);
+    LL_MDMA_SetDestinationDataSize(MDMA, LL_MDMA_CHANNEL_0, words ?
+        LL_MDMA_DEST_DATA_SIZE_WORD : LL_MDMA_DEST_DATA_SIZE_BYTE);
+    LL_MDMA_SetSourceIncSize(MDMA, LL_MDMA_CHANNEL_0, words ?
+        LL_MDMA_SRC_INC_OFFSET_WORD : LL_MDMA_SRC_INC_OFFSET_BYTE);
+    LL_MDMA_SetDestinationIncSize(MDMA, LL_MDMA_CHANNEL_0, words ?
+        LL_MDMA_DEST_INC_OFFSET_WORD : LL_MDMA_DEST_INC_OFFSET_BYTE);
+
+    LL_MDMA_SetBufferTransferLength(MDMA, LL_MDMA_CHANNEL_0,
+        std::min<uint32_t>(128, length) - 1);
+    LL_MDMA_SetBlkDataLength(MDMA, LL_MDMA_CHANNEL_0, length);
+
+    if (length < 128)
+    {
+        LL_MDMA_SetSourceBurstSize(
+            MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_SRC_BURST_SINGLE);
+        LL_MDMA_SetDestinationBurstSize(
+            MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_DEST_BURST_SINGLE);
+    }
+    else
+    {
+        LL_MDMA_SetSourceBurstSize(
+            MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_SRC_BURST_16BEATS);
+        LL_MDMA_SetDestinationBurstSize(
+            MDMA, LL_MDMA_CHANNEL_0, LL_MDMA_DEST_BURST_16BEATS);
+    }
+
+    LL_MDMA_EnableChannel(MDMA, LL_MDMA_CHANNEL_0);
+}
+
+// From the data register to `dst`. Start the read command after this.
+inline void StartReadDMA(void* dst, uint32_t length, uint32_t width)
+{
+    StartDMA(reinterpret_cast<uint32_t>(&QUADSPI->DR),
+        reinterpret_cast<uint32_t>(dst), length, width);
+}
+
+// From `src` to the data register. Start the write command first, so the
+// FIFO threshold paces the transfer.
+inline void StartWriteDMA(const void* src, uint32_t length, uint32_t width)
+{
+    StartDMA(reinterpret_cast<uint32_t>(src),
+        reinterpret_cast<uint32_t>(&QUADSPI->DR), length, width);
+}
+
+// Waits for the transfer set up by StartReadDMA() or StartWriteDMA() to
+// finish
+inline void FinishDMA(void)
+{
+    while (!LL_MDMA_IsActiveFlag_BT(MDMA, LL_MDMA_CHANNEL_0));
+    LL_MDMA_ClearFlag_BT(MDMA, LL_MDMA_CHANNEL_0);
+}
+
+}
@@ -0,0 +1,769 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "drivers/save_data.h"
+
+namespace recorder
+{
+
+// A recording as the store knows it. Everything but `address` and `id` is
+// kept in the header in front of the audio, so a recording can be checked
+// against what is about to play it without reading any of the audio.
+struct RecordingInfo
+{
+    uint32_t address;       // Of the audio, just after the header
+    uint32_t size;          // Bytes of audio
+    uint32_t crc32;         // Of the audio
+    uint32_t id;            // Kept when compaction moves the recording
+    uint32_t sample_rate;   // Hz
+    uint8_t codec;          // SampleCodecID
+    uint8_t word_size;      // Bytes per stored word
+};
+
+struct RecordingStoreStats
+{
+    uint32_t recordings;    // Live, in the log
+    uint32_t deleted;       // Deleted, still taking space in the log
+    uint32_t evicted;       // Live, dropped from the tail to make room
+    uint32_t moved;         // By compaction
+    uint32_t rolled_forward;// Appends at boot the directory didn't have yet
+};
+
+// An append-only log of recordings in `NVMem`, with the directory kept in a
+// SaveData region at its start.
+//
+// Recordings go in slots aligned to `alignment`, one after the other round
+// the rest of the part, so every block is erased once per lap of the log,
+// whatever is recorded. The directory holds only where the log starts and
+// ends; the recordings in between are found from their headers, a read per
+// recording. There is always room for a recording of `max_size` at the head:
+// committing one drops the oldest from the tail if the next wouldn't fit.
+//
+// Committing a recording writes its header and then a directory block, so
+// it takes the same time however much is stored. The header is the commit
+// point: one written after the last directory block is rolled forward at
+// boot, and audio written without one is ignored.
+//
+// Deleted recordings keep their space until the tail reaches them, which
+// ServiceCompaction() brings forward by moving live recordings from the tail
+// to the head.
+//
+// The store only reads, programs and erases the directory. Erasing the
+// space from head() before anything is programmed there is left to the
+// caller, which can do it ahead of time; see SampleMemory.
+template <typename NVMem, uint32_t max_size, uint32_t alignment>
+class RecordingStore
+{
+public:
+    // A flash page, so the audio after it starts on a page boundary
+    static constexpr uint32_t kHeaderSize = 256;
+
+    static constexpr uint32_t SlotSize(uint32_t size)
+    {
+        return (kHeaderSize + size + alignment - 1) / alignment * alignment;
+    }
+
+    static constexpr uint32_t kMaxSlotSize = SlotSize(max_size);
+
+    RecordingStore(NVMem& nvmem) : nvmem_{nvmem} {}
+
+    // Reads the directory and walks the log, reading each header once
+    void Init(void)
+    {
+        move_ = {};
+        stats_ = {};
+
+        bool changed = false;
+
+        if (!directory_.Init(directory_data_))
+        {
+            changed = Rebuild();
+        }
+        else if (directory_data_.magic != kMagic ||
+                 directory_data_.check != Check(directory_data_) ||
+                 !IsSlot(directory_data_.tail) || !IsSlot(directory_data_.head))
+        {
+            // Another layout's save data, or a block that passes SaveData's
+            // checksum only by chance, as one cut short can
+            directory_.Erase();
+            directory_.Init();
+            Rebuild();
+            changed = true;
+        }
+
+        Walk([this](uint32_t, const Header& header)
+        {
+            Count(header, 1);
+        });
+
+        Header header;
+
+        // Committed, but cut off before the directory was
+        while (ReadHeader(directory_data_.head, header) &&
+               header.sequence == directory_data_.sequence + 1)
+        {
+            Header tail;
+
+            // A moved recording replaces the one at the tail it was copied
+            // from
+            if (ReadHeader(directory_data_.tail, tail) &&
+                Count() > 0 && tail.id == header.id)
+            {
+                DropTail();
+            }
+
+            directory_data_.next_id =
+                std::max(directory_data_.next_id, header.id + 1);
+            Advance(header);
+            stats_.rolled_forward++;
+            changed = true;
+        }
+
+        changed |= MakeRoom();
+
+        if (changed)
+        {
+            SaveDirectory();
+        }
+    }
+
+    // Where the next recording's header goes, with its audio after it. The
+    // next kMaxSlotSize bytes hold nothing live.
+    uint32_t head(void) const
+    {
+        return directory_data_.head;
+    }
+
+    const RecordingStoreStats& stats(void) const
+    {
+        return stats_;
+    }
+
+    // Commits a recording whose audio has been written from head() +
+    // kHeaderSize, filling in `info.address` and `info.id`. The space it
+    // takes must have been erased before any of it was written, and no move
+    // can be in progress.
+    bool Append(RecordingInfo& info)
+    {
+        if (moving() || info.size > max_size)
+        {
+            return false;
+        }
+
+        Header header =
+        {
+            .magic = kMagic,
+            .sequence = directory_data_.sequence + 1,
+            .id = directory_data_.next_id,
+            .size = info.size,
+            .crc32 = info.crc32,
+            .sample_rate = info.sample_rate,
+            .codec = info.codec,
+            .word_size = info.word_size,
+            .checksum = 0,
+            .deleted = kFillWord,
+        };
+
+        if (!WriteHeader(directory_data_.head, header))
+        {
+            return false;
+        }
+
+        info.address = directory_data_.head + kHeaderSize;
+        info.id = header.id;
+        directory_data_.next_id++;
+        Advance(header);
+        MakeRoom();
+        return SaveDirectory();
+    }
+
+    // Marks a recording deleted in its header. Its space is reclaimed once
+    // it reaches the tail.
+    bool Delete(uint32_t id)
+    {
+        uint32_t found = kNoSlot;
+
+        Walk([&](uint32_t slot, const Header& header)
+        {
+            if (header.id == id && !IsDeleted(header))
+            {
+                found = slot;
+            }
+        });
+
+        if (found == kNoSlot)
+        {
+            return false;
+        }
+
+        if (moving() && move_.source == found)
+        {
+            AbortCompaction();
+        }
+
+        uint32_t mark = ~kFillWord;
+
+        if (!nvmem_.Write(found + offsetof(Header, deleted), &mark, sizeof(mark)))
+        {
+            return false;
+        }
+
+        stats_.recordings--;
+        stats_.deleted++;
+        return true;
+    }
+
+    // Calls `visit` with each live recording, oldest first
+    template <typename Visit>
+    void ForEach(Visit&& visit)
+    {
+        Walk([&](uint32_t slot, const Header& header)
+        {
+            if (!IsDeleted(header))
+            {
+                visit(Info(slot, header));
+            }
+        });
+    }
+
+    bool Find(uint32_t id, RecordingInfo& info)
+    {
+        bool found = false;
+
+        ForEach([&](const RecordingInfo& recording)
+        {
+            if (recording.id == id)
+            {
+                info = recording;
+                found = true;
+            }
+        });
+
+        return found;
+    }
+
+    // The live recording appended last, which compaction may have moved
+    // since
+    bool Newest(RecordingInfo& info)
+    {
+        bool found = false;
+
+        ForEach([&](const RecordingInfo& recording)
+        {
+            if (!found || recording.id > info.id)
+            {
+                info = recording;
+                found = true;
+            }
+        });
+
+        return found;
+    }
+
+    // Takes one step of compaction: drops a deleted recording from the
+    // tail, or copies a chunk of the live one there to the head, so the
+    // deleted ones after it reach the tail in turn. Live recordings are only
+    // moved once the one after next would have to drop them, and if a move
+    // leaves room for a recording of `max_size`. Does nothing, and returns
+    // false, once no deleted recordings are left or nothing is to be moved.
+    //
+    // Whatever is programmed from head() has to have been erased when a move
+    // starts, and left alone until it ends; see move_length().
+    bool ServiceCompaction(void)
+    {
+        if (!moving())
+        {
+            if (stats_.deleted == 0)
+            {
+                return false;
+            }
+
+            Header header;
+
+            if (!ReadHeader(directory_data_.tail, header) || IsDeleted(header))
+            {
+                DropTail();
+                SaveDirectory();
+                return true;
+            }
+
+            if (!Crowded() || !WorthMoving() || !MoveFits(header.size))
+            {
+                return false;
+            }
+
+            move_ = {.source = directory_data_.tail, .offset = 0, .header = header};
+            return true;
+        }
+
+        uint32_t size = move_.header.size;
+
+        if (move_.offset < size)
+        {
+            uint32_t length = std::min(kCopyChunkSize, size - move_.offset);
+            uint32_t from = move_.source + kHeaderSize + move_.offset;
+            uint32_t to = directory_data_.head + kHeaderSize + move_.offset;
+
+            if (!nvmem_.Read(copy_buffer_, from, length) ||
+                !nvmem_.Write(to, copy_buffer_, length))
+            {
+                AbortCompaction();
+                return false;
+            }
+
+            move_.offset += length;
+            return true;
+        }
+
+        // The copy's header commits the move
+        Header header = move_.header;
+        header.sequence = directory_data_.sequence + 1;
+        AbortCompaction();
+
+        if (!WriteHeader(directory_data_.head, header))
+        {
+            return false;
+        }
+
+        Advance(header);
+        DropTail();
+        MakeRoom();
+        stats_.moved++;
+        SaveDirectory();
+        return true;
+    }
+
+    bool moving(void) const
+    {
+        return move_.source != kNoSlot;
+    }
+
+    // Bytes from head() that the move in progress programs, or 0
+    uint32_t move_length(void) const
+    {
+        return moving() ? kHeaderSize + move_.header.size : 0;
+    }
+
+    // Leaves a move unfinished, as a recording about to be saved needs the
+    // head. What it programmed has to be erased again before it's used.
+    void AbortCompaction(void)
+    {
+        move_ = {};
+    }
+
+    // Forgets every recording
+    bool Erase(void)
+    {
+        if (!directory_.Erase())
+        {
+            return false;
+        }
+
+        Init();
+        return true;
+    }
+
+protected:
+    static constexpr uint32_t kMagic = 0x52454331;     // "REC1"
+    static constexpr uint32_t kFillWord = NVMem::kFillByte * 0x01010101u;
+    static constexpr uint32_t kNoSlot = 0xFFFFFFFF;
+
+    // About 1 ms of page programs per step, as when saving
+    static constexpr uint32_t kCopyChunkSize = 1024;
+
+    static constexpr uint32_t kDirectorySize = NVMem::kEraseGranularity * 2;
+    static constexpr uint32_t kFirstSlot =
+        (kDirectorySize + alignment - 1) / alignment * alignment;
+    static constexpr uint32_t kLastSlot = NVMem::kSize - kMaxSlotSize;
+    static constexpr uint32_t kNumSlots = (kLastSlot - kFirstSlot) / alignment + 1;
+
+    static_assert(alignment % NVMem::kEraseGranularity == 0);
+    static_assert(kFirstSlot + 2 * kMaxSlotSize <= NVMem::kSize);
+
+    struct __attribute__ ((packed)) Header
+    {
+        uint32_t magic;
+        uint32_t sequence;      // One more than the header before
+        uint32_t id;
+        uint32_t size;
+        uint32_t crc32;
+        uint32_t sample_rate;
+        uint8_t codec;
+        uint8_t word_size;
+        uint16_t checksum;
+        uint32_t deleted;       // Left erased until Delete(), so unchecked
+    };
+
+    static_assert(sizeof(Header) <= kHeaderSize);
+
+    struct Directory
+    {
+        uint32_t magic;
+        uint32_t tail;          // Slot of the oldest recording in the log
+        uint32_t head;          // Slot the next one goes in
+        uint32_t sequence;      // Of the last header in the log
+        uint32_t next_id;
+        uint32_t check;         // Last, so a block cut short fails it
+    };
+
+    struct Move
+    {
+        uint32_t source = kNoSlot;
+        uint32_t offset;        // Bytes of audio copied
+        Header header;
+    };
+
+    NVMem& nvmem_;
+    SaveData<NVMem, Directory, kDirectorySize> directory_{nvmem_};
+    Directory directory_data_;
+    RecordingStoreStats stats_;
+    Move move_;
+    uint8_t copy_buffer_[kCopyChunkSize];
+
+    void Reset(void)
+    {
+        directory_data_ =
+        {
+            .magic = kMagic,
+            .tail = kFirstSlot,
+            .head = kFirstSlot,
+            .sequence = 0,
+            .next_id = 1,
+            .check = 0,
+        };
+    }
+
+    static uint32_t Check(const Directory& directory)
+    {
+        return ~(directory.magic + directory.tail + directory.head +
+                 directory.sequence + directory.next_id);
+    }
+
+    bool SaveDirectory(void)
+    {
+        directory_data_.check = Check(directory_data_);
+        return directory_.Save(directory_data_);
+    }
+
+    static bool IsSlot(uint32_t slot)
+    {
+        return slot >= kFirstSlot && slot <= kLastSlot &&
+            (slot % alignment) == 0;
+    }
+
+    // The slot after one holding `size` bytes of audio, back at the start
+    // if a recording of `max_size` wouldn't fit there
+    static uint32_t NextSlot(uint32_t slot, uint32_t size)
+    {
+        slot += SlotSize(size);
+        return (slot > kLastSlot) ? kFirstSlot : slot;
+    }
+
+    static bool IsDeleted(const Header& header)
+    {
+        return header.deleted != kFillWord;
+    }
+
+    static uint16_t Checksum(const Header& header)
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(&header);
+        uint16_t sum = 0;
+
+        for (uint32_t i = 0; i < offsetof(Header, checksum); i++)
+        {
+            sum += bytes[i];
+        }
+
+        return sum;
+    }
+
+    static RecordingInfo Info(uint32_t slot, const Header& header)
+    {
+        return
+        {
+            .address = slot + kHeaderSize,
+            .size = header.size,
+            .crc32 = header.crc32,
+            .id = header.id,
+            .sample_rate = header.sample_rate,
+            .codec = header.codec,
+            .word_size = header.word_size,
+        };
+    }
+
+    bool ReadHeader(uint32_t slot, Header& header)
+    {
+        return nvmem_.Read(&header, slot, sizeof(Header)) &&
+            header.magic == kMagic && header.checksum == Checksum(header) &&
+            header.size <= max_size;
+    }
+
+    bool WriteHeader(uint32_t slot, Header& header)
+    {
+        header.checksum = Checksum(header);
+        header.deleted = kFillWord;
+        return nvmem_.Write(slot, &header, sizeof(Header));
+    }
+
+    uint32_t Count(void) const
+    {
+        return stats_.recordings + stats_.deleted;
+    }
+
+    void Count(const Header& header, int32_t n)
+    {
+        if (IsDeleted(header))
+        {
+            stats_.deleted += n;
+        }
+        else
+        {
+            stats_.recordings += n;
+        }
+    }
+
+    // Calls `visit` with each header in the log, oldest first. A slot in the
+    // log without a valid header is only left by damage; the walk carries on
+    // from the next aligned one that has a header newer than the last.
+    template <typename Visit>
+    void Walk(Visit&& visit)
+    {
+        uint32_t slot = directory_data_.tail;
+        uint32_t last_sequence = 0;
+
+        for (uint32_t n = 0; slot != directory_data_.head && n < kNumSlots; n++)
+        {
+            Header header;
+
+            if (ReadHeader(slot, header) && header.sequence > last_sequence &&
+                header.sequence <= directory_data_.sequence)
+            {
+                visit(slot, header);
+                last_sequence = header.sequence;
+                slot = NextSlot(slot, header.size);
+            }
+            else
+            {
+                slot = NextSlot(slot, 0);
+            }
+        }
+    }
+
+    void Advance(const Header& header)
+    {
+        directory_data_.head = NextSlot(directory_data_.head, header.size);
+        directory_data_.sequence = header.sequence;
+        Count(header, 1);
+    }
+
+    // Drops the recording at the tail, or steps past a damaged slot.
+    // Returns true if the recording was live.
+    bool DropTail(void)
+    {
+        Header header;
+        bool live = false;
+
+        if (ReadHeader(directory_data_.tail, header))
+        {
+            directory_data_.tail = NextSlot(directory_data_.tail, header.size);
+            Count(header, -1);
+            live = !IsDeleted(header);
+        }
+        else
+        {
+            directory_data_.tail = NextSlot(directory_data_.tail, 0);
+        }
+
+        if (Count() == 0)
+        {
+            directory_data_.tail = directory_data_.head;
+        }
+
+        return live;
+    }
+
+    static bool InReserve(uint32_t slot, uint32_t head)
+    {
+        return slot >= head && slot < head + kMaxSlotSize;
+    }
+
+    // Drops recordings from the tail until one of `max_size` fits at the
+    // head. Returns true if any were dropped.
+    bool MakeRoom(void)
+    {
+        bool dropped = false;
+
+        while (Count() > 0 && InReserve(directory_data_.tail, directory_data_.head))
+        {
+            stats_.evicted += DropTail();
+            dropped = true;
+        }
+
+        return dropped;
+    }
+
+    // Whether the recording after the next one could drop the tail
+    bool Crowded(void)
+    {
+        uint32_t head = directory_data_.head;
+        uint32_t tail = directory_data_.tail;
+        uint32_t free;
+
+        if (tail > head)
+        {
+            free = tail - head;
+        }
+        else
+        {
+            free = (kLastSlot + alignment - head) + (tail - kFirstSlot);
+        }
+
+        return free < 2 * kMaxSlotSize;
+    }
+
+    // Whether the live recordings from the tail up to the first deleted one
+    // take no more space than it does, so moving them reclaims at least as
+    // much as it programs
+    bool WorthMoving(void)
+    {
+        uint32_t live = 0;
+        bool found = false;
+        bool worth = false;
+
+        Walk([&](uint32_t, const Header& header)
+        {
+            if (found)
+            {
+                return;
+            }
+            else if (IsDeleted(header))
+            {
+                found = true;
+                worth = (live <= SlotSize(header.size));
+            }
+            else
+            {
+                live += SlotSize(header.size);
+            }
+        });
+
+        return worth;
+    }
+
+    // Finds the log from the headers alone, when the directory has been
+    // lost: the newest header, and those before it with the sequence numbers
+    // and slots that lead up to it. Recordings dropped from the tail but not
+    // yet erased can come back. Returns false if there are no headers.
+    bool Rebuild(void)
+    {
+        Reset();
+
+        Header newest = {};
+        uint32_t newest_slot = kNoSlot;
+
+        for (uint32_t slot = kFirstSlot; slot <= kLastSlot; slot += alignment)
+        {
+            Header header;
+
+            if (ReadHeader(slot, header) &&
+                (newest_slot == kNoSlot || header.sequence > newest.sequence))
+            {
+                newest = header;
+                newest_slot = slot;
+            }
+        }
+
+        if (newest_slot == kNoSlot)
+        {
+            return false;
+        }
+
+        directory_data_.tail = newest_slot;
+        directory_data_.head = NextSlot(newest_slot, newest.size);
+        directory_data_.sequence = newest.sequence;
+
+        // Stopping at the space kept clear for the next recording, which
+        // only holds recordings already dropped, and before the recording a
+        // move copied, which only the move's commit dropped
+        for (uint32_t n = 1; n < kNumSlots && n < newest.sequence; n++)
+        {
+            Header header;
+            uint32_t sequence = newest.sequence - n;
+            uint32_t previous = PreviousSlot(directory_data_.tail, sequence, header);
+
+            if (previous == kNoSlot || InReserve(previous, directory_data_.head) ||
+                Contains(header.id))
+            {
+                break;
+            }
+
+            directory_data_.tail = previous;
+        }
+
+        Walk([this](uint32_t, const Header& header)
+        {
+            directory_data_.next_id =
+                std::max(directory_data_.next_id, header.id + 1);
+        });
+
+        return true;
+    }
+
+    bool Contains(uint32_t id)
+    {
+        bool found = false;
+
+        Walk([&](uint32_t, const Header& header)
+        {
+            found |= (header.id == id);
+        });
+
+        return found;
+    }
+
+    // The slot before `slot` in the log, if it holds the header numbered
+    // `sequence`, which is read into `header`
+    uint32_t PreviousSlot(uint32_t slot, uint32_t sequence, Header& header)
+    {
+        for (uint32_t back = alignment; back <= kMaxSlotSize; back += alignment)
+        {
+            uint32_t previous;
+
+            if (slot == kFirstSlot)
+            {
+                previous = kLastSlot + alignment - back;
+            }
+            else if (slot >= kFirstSlot + back)
+            {
+                previous = slot - back;
+            }
+            else
+            {
+                break;
+            }
+
+            if (ReadHeader(previous, header) && header.sequence == sequence &&
+                NextSlot(previous, header.size) == slot)
+            {
+                return previous;
+            }
+        }
+
+        return kNoSlot;
+    }
+
+    // Whether moving the tail recording to the head would still leave room
+    // for a recording of `max_size`, without dropping anything
+    bool MoveFits(uint32_t size)
+    {
+        uint32_t head = NextSlot(directory_data_.head, size);
+        uint32_t tail = NextSlot(directory_data_.tail, size);
+        return !InReserve(tail, head);
+    }
+};
+
+}
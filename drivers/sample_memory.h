@@ -4,23 +4,53 @@
 #include <cstdio>
 #include <cinttypes>
 #include <algorithm>
+#include <span>
 
 #include "drivers/system.h"
 #include "drivers/flash.h"
+#include "drivers/flash_stream.h"
+#include "drivers/erase_ahead.h"
 #include "drivers/crc.h"
-#include "drivers/save_data.h"
+#include "drivers/recording_store.h"
 #include "common/config.h"
 #include "util/buffer_chain.h"
 
 namespace recorder
 {
 
+enum SampleLoadStatus : uint32_t
+{
+    LOAD_NONE,          // No saved recording, or streamed from flash
+    LOAD_IN_PROGRESS,
+    LOAD_OK,
+    LOAD_BAD_CRC,
+    LOAD_ABORTED,       // A new recording started first
+};
+
+struct SampleLoadStats
+{
+    uint32_t size;          // Bytes of saved audio
+    uint32_t loaded;        // Bytes read into RAM so far
+    uint32_t done_ms;       // Uptime when the load finished
+    SampleLoadStatus status;
+};
+
+struct SampleSaveStats
+{
+    uint32_t saves;
+    uint32_t stop_to_saved_ms;  // From the end of the recording, last save
+    uint32_t erase_ms;          // Of that, spent erasing
+    uint32_t erased_ahead;      // Bytes of it that were erased already
+};
+
 class SampleMemoryBase
 {
 protected:
     static constexpr uint32_t kBuffer1Size = 512 * 1024;
     static constexpr uint32_t kBuffer2Size = 288 * 1024;
     static constexpr uint32_t kBuffer3Size =  63 * 1024;
+    static constexpr uint32_t kBufferSize =
+        kBuffer1Size + kBuffer2Size + kBuffer3Size;
 
     __attribute__ ((section (".sram1")))
     static inline uint8_t buffer1_[kBuffer1Size];
@@ -40,94 +70,279 @@ public:
     {
    
         dirty_ = false;
+        streaming_ = false;
+        stream_.Close();
         buffer_index_ = 0;
+        crc_offset_ = 0;
+        load_ = {};
+        save_stats_ = {};
         flash_.Init();
+        erase_ahead_.Init();
         crc_.Init();
         buffer_chain_.Init(link_info_);
 
-        if (save_.Init(audio_info_))
+        store_.Init();
+
+        if (store_.Newest(audio_info_))
         {
-            printf("Save data found:\n");
+            printf("Recording found:\n");
             PrintInfo("    ");
 
-            if (audio_info_.address < kAudioBufferAddress)
+            if (!Playable(audio_info_))
             {
-                printf("Invalid address\n");
-                audio_info_.address = kAudioBufferAddress;
+                printf("Recorded in another format\n");
                 audio_info_.size = 0;
             }
+            else if (kEnableFlashStreaming)
+            {
+                // Nothing to load, so boot doesn't wait on flash. Only the
+                // header is checked, since the CRC would mean reading all of
+                // the audio.
+                printf("Audio will be streamed from flash\n");
+                OpenStream();
+            }
             else
             {
-                printf("Loading audio... ");
+                // Loaded a chunk at a time by ServiceLoad() from the main
+                // loop, so boot doesn't wait on flash
+                printf("Loading audio in the background\n");
                 crc_.Seed(0);
-                uint32_t total_size = audio_info_.size;
-                uint32_t address = audio_info_.address;
-
-                for (auto link : buffer_chain_)
-                {
-                    uint32_t read_size = std::min(link.size(), total_size);
-                    system::ReloadWatchdog();
-                    flash_.Read(link.buffer, address, read_size);
-                    system::ReloadWatchdog();
-                    crc_.Process(link.buffer, read_size);
-                    total_size -= read_size;
-                    address += read_size;
-
-                    if (total_size == 0)
-                    {
-                        break;
-                    }
-
-                }
-
-                if (audio_info_.crc32 == crc_.value())
-                {
-                    printf("done\n");
-                }
-                else
-                {
-                    printf("invalid CRC32: 0x%08" PRIX32 "\n", crc_.value());
-                    audio_info_.size = 0;
-                }
+                load_.size = audio_info_.size;
+                load_.status = LOAD_IN_PROGRESS;
             }
         }
         else
         {
-            printf("No save data found\n");
-            audio_info_.address = kAudioBufferAddress;
-            audio_info_.size = 0;
+            printf("No recordings found\n");
+            audio_info_ = {};
         }
-       
+    }
+
+    using Stream = FlashStream<T, Flash>;
+
+    // Reads the recording from RAM, or from flash through the stream while
+    // the saved one is streamed
+    class Cursor
+    {
+    public:
+        Cursor(SampleMemory* memory) :
+            memory_(memory),
+            chain_(&memory->buffer_chain_),
+            stream_(memory->stream_.cursor())
+        {
+        }
+
+        void Seek(uint32_t index)
+        {
+            if (memory_->streaming_)
+            {
+                stream_.Seek(index);
+            }
+            else
+            {
+                chain_.Seek(index);
+            }
+        }
+
+        Cursor& operator++()
+        {
+            if (memory_->streaming_)
+            {
+                ++stream_;
+            }
+            else
+            {
+                ++chain_;
+            }
+
+            return *this;
+        }
+
+        Cursor& operator--()
+        {
+            if (memory_->streaming_)
+            {
+                --stream_;
+            }
+            else
+            {
+                --chain_;
+            }
+
+            return *this;
+        }
+
+        T operator*()
+        {
+            return memory_->streaming_ ? *stream_ : *chain_;
+        }
+
+        template <typename U>
+        uint32_t Read(std::span<U> out)
+        {
+            return memory_->streaming_ ? stream_.Read(out) : chain_.Read(out);
+        }
+
+    protected:
+        SampleMemory* memory_;
+        BufferChain<T>::Cursor chain_;
+        Stream::Cursor stream_;
+    };
+
+    // Call from the main loop after Init(). Reads the next chunk of the saved
+    // recording into RAM and runs it through the CRC. Until the load is done,
+    // length() covers only the part already loaded, so playback can start on
+    // it straight away.
+    //
+    // The CRC can only be checked once everything has been read. If it fails
+    // then, the recording is dropped as it would have been at boot: length()
+    // becomes 0, which stops any playback at its next sample. The save data is
+    // left alone, so a bad read is retried on the next boot.
+    void ServiceLoad(void)
+    {
+        if (load_.status != LOAD_IN_PROGRESS)
+        {
+            return;
+        }
+
+        uint32_t offset = load_.loaded;
+        uint32_t size = std::min(kLoadChunkSize, load_.size - offset);
+
+        for (auto link : buffer_chain_)
+        {
+            if (offset < link.offset + link.size())
+            {
+                // A chunk doesn't cross into the next link
+                uint32_t in_link = offset - link.offset;
+                size = std::min(size, link.size() - in_link);
+                uint8_t* dst = reinterpret_cast<uint8_t*>(link.buffer) + in_link;
+                flash_.Read(dst, audio_info_.address + offset, size);
+                crc_.Process(dst, size);
+                break;
+            }
+        }
+
+        load_.loaded += size;
+
+        if (load_.loaded == load_.size)
+        {
+            load_.done_ms = system::Uptime_ms();
+
+            if (audio_info_.crc32 == crc_.value())
+            {
+                printf("Audio loaded in %" PRIu32 " ms\n", load_.done_ms);
+                load_.status = LOAD_OK;
+            }
+            else
+            {
+                printf("Loaded audio has invalid CRC32: 0x%08" PRIX32 "\n",
+                    crc_.value());
+                load_.status = LOAD_BAD_CRC;
+                audio_info_.size = 0;
+            }
+        }
+    }
+
+    bool loading(void)
+    {
+        return load_.status == LOAD_IN_PROGRESS;
+    }
+
+    const SampleLoadStats& load_stats(void) const
+    {
+        return load_;
     }
 
     void StartRecording(void)
     {
+        // A new recording replaces one that is still loading, and needs the
+        // CRC unit when it stops
+        if (loading())
+        {
+            load_.status = LOAD_ABORTED;
+        }
+
+        // It also replaces a streamed recording as what is played
+        streaming_ = false;
+        stream_.Close();
         buffer_index_ = 0;
+        write_cursor_.Seek(0);
     }
 
-    void StartPlayback(void)
+    // Call before play starts. A streamed recording has its first windows
+    // read here, so the audio path finds them resident.
+    void StartPlayback(bool reverse)
     {
         buffer_index_ = 0;
+
+        if (streaming_)
+        {
+            stream_.Cue(reverse ? length() - 1 : 0);
+
+            for (uint32_t i = 0; i < Stream::kNumWindows; i++)
+            {
+                stream_.Service(reverse, 1);
+            }
+        }
     }
 
-    const T& operator[](size_t index)
+    // Call from the main loop while playing, with the player's direction
+    // and speed. Refills the stream's windows while the saved recording is
+    // streamed from flash, and does nothing otherwise.
+    void ServiceStream(bool reverse, float speed)
     {
-        return buffer_chain_[index];
+        if (streaming_)
+        {
+            stream_.Service(reverse, speed);
+        }
+    }
+
+    bool streaming(void) const
+    {
+        return streaming_;
+    }
+
+    const FlashStreamStats& stream_stats(void) const
+    {
+        return stream_.stats();
+    }
+
+    // For readers that keep their own place, like SamplePlayer
+    Cursor cursor(void)
+    {
+        return Cursor(this);
+    }
+
+    // Random access through a shared cursor, so nearby indices are cheap.
+    // Only use from one context at a time.
+    T operator[](size_t index)
+    {
+        read_cursor_.Seek(index);
+        return *read_cursor_;
     }
 
     uint32_t length(void)
     {
-        return audio_info_.size / sizeof(T);
+        uint32_t size = loading() ? load_.loaded : audio_info_.size;
+        return size / sizeof(T);
     }
 
     void Append(T item)
     {
         if (buffer_index_ < buffer_chain_.length())
         {
-            buffer_chain_[buffer_index_++] = item;
+            *write_cursor_ = item;
+            ++write_cursor_;
+            buffer_index_++;
         }
     }
 
+    template <typename U>
+    void Append(std::span<U> items)
+    {
+        buffer_index_ += write_cursor_.Write(items);
+    }
+
     void StopRecording(void)
     {
         uint32_t min_length =
@@ -139,39 +354,21 @@ public:
             // button being released.
             buffer_index_ -= min_length;
 
-            uint32_t address = audio_info_.address + audio_info_.size;
-            uint32_t size = buffer_index_ * sizeof(T);
-
-            uint32_t granularity = Flash::kEraseGranularity;
-            address += granularity - 1;
-            address -= (address % granularity);
-
-            if (address + size > Flash::kSize)
-            {
-                address = kAudioBufferAddress;
-            }
-
-            crc_.Seed(0);
-            uint32_t total_size = size;
-
-            for (auto link : buffer_chain_)
-            {
-                system::ReloadWatchdog();
-                uint32_t chunk_size = std::min(link.size(), total_size);
-                crc_.Process(link.buffer, chunk_size);
-                total_size -= chunk_size;
-
-                if (total_size == 0)
-                {
-                    break;
-                }
-            }
+            stop_ms_ = system::Uptime_ms();
 
+            // Saved at the head of the store, which a move by compaction
+            // can't have as well. The CRC is worked out during the save,
+            // while the flash is busy.
+            store_.AbortCompaction();
             audio_info_ =
             {
-                .address = address,
-                .size    = size,
-                .crc32   = crc_.value(),
+                .address     = store_.head() + Store::kHeaderSize,
+                .size        = buffer_index_ * uint32_t(sizeof(T)),
+                .crc32       = 0,
+                .id          = 0,
+                .sample_rate = kAudioSampleRateHz,
+                .codec       = kSampleCodec,
+                .word_size   = sizeof(T),
             };
 
             dirty_ = true;
@@ -179,19 +376,27 @@ public:
     }
     T Read(size_t index)
     {
-        return buffer_chain_[index];
+        return (*this)[index];
     }
+
+    Flash& flash(void)
+    {
+        return flash_;
+    }
+
     bool dirty(void)
     {
         return dirty_ && audio_info_.size > 0;
     }
 
+    // Only what ServiceErase() hasn't already erased is left to erase
     bool BeginErase(void)
     {
-        uint32_t granularity = Flash::kEraseGranularity;
-        uint32_t erase_size = audio_info_.size + granularity - 1;
-        erase_size -= (erase_size % granularity);
-        return flash_.BeginErase(audio_info_.address, erase_size);
+        crc_.Seed(0);
+        crc_offset_ = 0;
+        erase_start_ms_ = system::Uptime_ms();
+        save_stats_.erased_ahead = erase_ahead_.erased_bytes(SaveSlot(), SaveLength());
+        return (SaveSlot() % Flash::kEraseGranularity) == 0;
     }
     void Overwrite(T item, size_t index)
     {
@@ -202,8 +407,11 @@ public:
     }
     bool FinishErase(void)
     {
-        if (flash_.FinishErase())
+        ServiceCrc();
+
+        if (erase_ahead_.Service(SaveSlot(), SaveLength()))
         {
+            save_stats_.erase_ms = system::Uptime_ms() - erase_start_ms_;
             chain_iter_ = buffer_chain_.begin();
             return true;
         }
@@ -231,20 +439,34 @@ public:
         uint32_t address = audio_info_.address + link.offset;
         uint32_t remaining = audio_info_.size - link.offset;
         uint32_t write_size = std::min(link.size(), remaining);
+        erase_ahead_.Invalidate(address, write_size);
         return flash_.BeginWrite(address, link.buffer, write_size);
     }
 
+    // Programs up to kPagesPerWrite pages per call, running the CRC over
+    // the recording while each one programs
     bool FinishWrite(void)
     {
-        if (flash_.FinishWrite())
-        {
-            chain_iter_++;
-            return true;
-        }
-        else
+        uint32_t pages = 0;
+
+        while (pages < kPagesPerWrite)
         {
-            return false;
+            if (flash_.busy())
+            {
+                ServiceCrc();
+            }
+            else if (flash_.FinishWrite())
+            {
+                chain_iter_++;
+                return true;
+            }
+            else
+            {
+                pages++;
+            }
         }
+
+        return false;
     }
 
     void AbortWrite(void)
@@ -254,11 +476,80 @@ public:
 
     bool Commit(void)
     {
-        return save_.Save(audio_info_);
+        // Whatever the erase and the page programs didn't cover
+        while (ServiceCrc())
+        {
+            system::ReloadWatchdog();
+        }
+
+        audio_info_.crc32 = crc_.value();
+        erase_ahead_.Invalidate(SaveSlot(), Store::kHeaderSize);
+
+        if (!store_.Append(audio_info_))
+        {
+            return false;
+        }
+
+        save_stats_.saves++;
+        save_stats_.stop_to_saved_ms = system::Uptime_ms() - stop_ms_;
+        return true;
+    }
+
+    const SampleSaveStats& save_stats(void) const
+    {
+        return save_stats_;
+    }
+
+    // Call from the main loop while nothing else needs the flash: not while
+    // saving, or playing from it. Erases the space the next recording will
+    // be saved to a step at a time, so saving it takes only page programs,
+    // then compacts the store into it while there's nothing to save.
+    void ServiceErase(void)
+    {
+        if (loading())
+        {
+            return;
+        }
+
+        // A move programs the erased space, which is left alone until the
+        // move is committed or aborted
+        if (!store_.moving() &&
+            !erase_ahead_.Service(store_.head(), Store::kMaxSlotSize))
+        {
+            return;
+        }
+
+        uint32_t head = store_.head();
+        bool moving = store_.moving();
+        store_.ServiceCompaction();
+
+        if (!moving && store_.moving())
+        {
+            erase_ahead_.Invalidate(head, store_.move_length());
+        }
+        else if (moving && !store_.moving() && streaming_)
+        {
+            // The move may have been of the recording being streamed, whose
+            // old copy is free to be erased now
+            if (store_.Newest(audio_info_))
+            {
+                OpenStream();
+            }
+        }
+    }
+
+    using Store = RecordingStore<Flash, SampleMemoryBase::kBufferSize,
+                                 Flash::kBlock64Size>;
+
+    // Every saved recording, of which the newest is the one loaded
+    Store& store(void)
+    {
+        return store_;
     }
 
     void PrintInfo(const char* line_prefix)
     {
+        printf("%sID:      %" PRIu32 "\n", line_prefix, audio_info_.id);
         printf("%sAddress: 0x%08" PRIX32 "\n", line_prefix, audio_info_.address);
         printf("%sSize:    0x%08" PRIX32 "\n", line_prefix, audio_info_.size);
         printf("%sCRC32:   0x%08" PRIX32 "\n", line_prefix, audio_info_.crc32);
@@ -271,29 +562,93 @@ public:
 
     void Erase(void)
     {
-        save_.Erase();
+        store_.Erase();
     }
 
 protected:
+    // About 1 ms of reading at a time
+    static constexpr uint32_t kLoadChunkSize = 16 * 1024;
+
+    // About 1 ms of programming at the typical page program time
+    static constexpr uint32_t kPagesPerWrite = 4;
+
+    // About 100 us of CRC, under half a page program
+    static constexpr uint32_t kCrcSliceSize = 4 * 1024;
+
     Flash flash_;
+    Store store_{flash_};
+    Stream stream_{flash_};
+    bool streaming_;
+    EraseAhead<Flash> erase_ahead_{flash_};
     Crc crc_;
     bool dirty_;
     uint32_t buffer_index_;
+    uint32_t crc_offset_;     // Bytes of the recording the save has CRCed
+    uint32_t stop_ms_;
+    uint32_t erase_start_ms_;
+    SampleLoadStats load_;
+    SampleSaveStats save_stats_;
+
+    // Runs the next slice of the recording being saved through the CRC.
+    // Returns false once all of it has been.
+    bool ServiceCrc(void)
+    {
+        uint32_t offset = crc_offset_;
+
+        if (offset >= audio_info_.size)
+        {
+            return false;
+        }
+
+        uint32_t size = std::min(kCrcSliceSize, audio_info_.size - offset);
 
-    struct AudioInfo
+        for (auto link : buffer_chain_)
+        {
+            if (offset < link.offset + link.size())
+            {
+                // A slice doesn't cross into the next link
+                uint32_t in_link = offset - link.offset;
+                size = std::min(size, link.size() - in_link);
+                crc_.Process(reinterpret_cast<uint8_t*>(link.buffer) + in_link, size);
+                break;
+            }
+        }
+
+        crc_offset_ += size;
+        return true;
+    }
+
+    RecordingInfo audio_info_;
+
+    // Plays the saved recording from flash rather than RAM from now on
+    void OpenStream(void)
     {
-        uint32_t address;
-        uint32_t size;
-        uint32_t crc32;
-    };
+        stream_.Open(audio_info_.address, audio_info_.size / sizeof(T));
+        streaming_ = true;
+    }
 
-    AudioInfo audio_info_;
-    static constexpr uint32_t kSaveDataRegionSize = Flash::kEraseGranularity * 2;
-    SaveData<Flash, AudioInfo, kSaveDataRegionSize> save_{flash_};
+    // Whether a recording can be played back as this build stores audio
+    static bool Playable(const RecordingInfo& info)
+    {
+        return info.codec == kSampleCodec &&
+            info.sample_rate == kAudioSampleRateHz &&
+            info.word_size == sizeof(T) && (info.size % sizeof(T)) == 0;
+    }
 
-    static constexpr uint32_t kAudioBufferAddress = kSaveDataRegionSize;
+    // The recording being saved, with its header in front
+    uint32_t SaveSlot(void)
+    {
+        return audio_info_.address - Store::kHeaderSize;
+    }
+
+    uint32_t SaveLength(void)
+    {
+        return Store::kHeaderSize + audio_info_.size;
+    }
     BufferChain<T> buffer_chain_;
     BufferChain<T>::iter chain_iter_;
+    BufferChain<T>::Cursor write_cursor_{&buffer_chain_};
+    Cursor read_cursor_{this};
     static inline BufferChain<T>::Link link_info_[] =
     {
         {reinterpret_cast<T*>(buffer1_), kBuffer1Size / sizeof(T), 0},
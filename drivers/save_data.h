@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
 
 namespace recorder
 {
@@ -200,7 +201,137 @@ protected:
         return nvmem_.Read(&block_, BlockLocation(block_n), kBlockSize);
     }
 
+    enum BlockState
+    {
+        BLOCK_BLANK,
+        BLOCK_VALID,
+        BLOCK_INVALID,      // Written, but not in full or not readable
+    };
+
+    BlockState ReadBlock(uint32_t block_n)
+    {
+        if (!LoadBlock(block_n))
+        {
+            return BLOCK_INVALID;
+        }
+
+        auto bytes = reinterpret_cast<const uint8_t*>(&block_);
+
+        if (std::all_of(bytes, bytes + kBlockSize,
+            [](uint8_t byte) { return byte == NVMem::kFillByte; }))
+        {
+            return BLOCK_BLANK;
+        }
+
+        return IsValid(block_) ? BLOCK_VALID : BLOCK_INVALID;
+    }
+
+    bool Newer(uint32_t sn, uint32_t than)
+    {
+        return ((sn > than) && (sn - than < kNumBlocks)) ||
+               ((sn < than) && (than - sn >= kNumBlocks));
+    }
+
+    // Finds the freshest block with a binary search, relying on the order
+    // Save() writes in: pages in turn round the region, and the blocks of
+    // each from the first. A page's first block is its header, with the
+    // sequence number the page started at, and the pages started since page
+    // 0 was last erased come before the rest. Whatever else doesn't fit that
+    // order, beyond a cut-short last write, falls back to reading every
+    // block.
     int32_t FindFreshestBlock(void)
+    {
+        // Page 0 is blank only if nothing has been saved, or if it was
+        // erased for the next save and not written yet
+        uint32_t first_page = 0;
+        BlockState state = ReadBlock(0);
+
+        if (state == BLOCK_BLANK && kNumPages > 1)
+        {
+            first_page = 1;
+            state = ReadBlock(kBlocksPerPage);
+        }
+
+        if (state == BLOCK_BLANK)
+        {
+            return -1;
+        }
+        else if (state == BLOCK_INVALID)
+        {
+            return ScanForFreshestBlock();
+        }
+
+        // The last page started at or after the first
+        uint32_t first_sn = block_.sequence_num;
+        uint32_t lo = first_page;
+        uint32_t hi = kNumPages - 1;
+
+        while (lo < hi)
+        {
+            uint32_t mid = (lo + hi + 1) / 2;
+            state = ReadBlock(mid * kBlocksPerPage);
+
+            if (state == BLOCK_INVALID)
+            {
+                return ScanForFreshestBlock();
+            }
+
+            if (state == BLOCK_VALID && !Newer(first_sn, block_.sequence_num))
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+
+        uint32_t page = lo;
+
+        // The page after it must be blank or from the lap before
+        if (page + 1 < kNumPages)
+        {
+            state = ReadBlock((page + 1) * kBlocksPerPage);
+
+            if (state == BLOCK_INVALID ||
+                (state == BLOCK_VALID && !Newer(first_sn, block_.sequence_num)))
+            {
+                return ScanForFreshestBlock();
+            }
+        }
+
+        // The last block written in the page
+        lo = 0;
+        hi = kBlocksPerPage - 1;
+
+        while (lo < hi)
+        {
+            uint32_t mid = (lo + hi + 1) / 2;
+            if (ReadBlock(page * kBlocksPerPage + mid) != BLOCK_BLANK)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid - 1;
+            }
+        }
+
+        uint32_t block = page * kBlocksPerPage + lo;
+
+        // Only the newest write can have been cut short, leaving the one
+        // before it the freshest
+        if (ReadBlock(block) != BLOCK_VALID &&
+            (lo == 0 || ReadBlock(--block) != BLOCK_VALID))
+        {
+            return ScanForFreshestBlock();
+        }
+
+        sequence_ = block_.sequence_num;
+        return block;
+    }
+
+    int32_t ScanForFreshestBlock(void)
     {
         int32_t block = -1;
 
@@ -210,9 +341,7 @@ protected:
             {
                 uint32_t sn = block_.sequence_num;
 
-                if ((block == -1) ||
-                    ((sn > sequence_) && (sn - sequence_ < kNumBlocks)) ||
-                    ((sn < sequence_) && (sequence_ - sn >= kNumBlocks)))
+                if ((block == -1) || Newer(sn, sequence_))
                 {
                     block = i;
                     sequence_ = sn;
@@ -230,22 +359,32 @@ protected:
         return page_n * kPageSize + block_n * kBlockSize;
     }
 
+    // The next block in the current page, skipping any a cut-short write
+    // left unwritable, or the first of the next page if it's blank. -1 when
+    // the next page needs erasing first. Blocks are never written out of
+    // order, which FindFreshestBlock() relies on.
     int32_t NextWritableBlock(int32_t current_block_n)
     {
-        int32_t next_block_n = current_block_n;
+        uint32_t next_block_n = current_block_n + 1;
 
-        do
+        while (next_block_n % kBlocksPerPage)
         {
-            next_block_n = (next_block_n + 1) % kNumBlocks;
-
             if (nvmem_.Writable(BlockLocation(next_block_n), kBlockSize))
             {
-                break;
+                return next_block_n;
             }
+
+            next_block_n++;
+        }
+
+        next_block_n %= kNumBlocks;
+
+        if (nvmem_.Writable(BlockLocation(next_block_n), kBlockSize))
+        {
+            return next_block_n;
         }
-        while (next_block_n != current_block_n);
 
-        return (next_block_n == current_block_n) ? -1 : next_block_n;
+        return -1;
     }
 };
 
@@ -263,6 +263,12 @@ void Delay_ms(uint32_t ms)
     }
 }
 
+// Since Init()
+uint32_t Uptime_ms(void)
+{
+    return ticks_.load(std::memory_order_acquire) / 10;
+}
+
 uint32_t SerialBytesAvailable(void)
 {
     return serial_.BytesAvailable();
@@ -9,6 +9,7 @@ static constexpr uint32_t kSystemClock = 64000000;
 
 void Init(void);
 void Delay_ms(uint32_t ms);
+uint32_t Uptime_ms(void);
 
 uint32_t SerialBytesAvailable(void);
 uint8_t SerialGetByteBlocking(void);
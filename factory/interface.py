@@ -130,6 +130,7 @@ class Monitor(Interface):
     COMMAND_STANDBY = b's'
     COMMAND_ERASE = b'e'
     COMMAND_WATCHDOG = b'w'
+    COMMAND_PROFILE = b'z'
 
     def __init__(self, *args, **kwds):
         super().__init__(*args, **kwds)
@@ -140,6 +141,8 @@ class Monitor(Interface):
         with open(os.path.join(dirname, 'packet.yaml')) as file:
             structure = yaml.load(file, Loader=yaml.FullLoader)
             self._device_state = PacketStructure(structure['device_state'])
+            self._profile_zone = PacketStructure(structure['profile_zone'])
+            self._profile_names = structure['profiles']
 
     def _send_command(self, data):
         self._send_packet(data)
@@ -164,3 +167,24 @@ class Monitor(Interface):
 
     def watchdog(self):
         self._send_command(self.COMMAND_WATCHDOG)
+
+    def profile_zone(self, zone):
+        self._send_command(self.COMMAND_PROFILE + bytes([zone]))
+        data = self._get_packet()
+        self._profile_zone.parse(data)
+        return dict(self._profile_zone)
+
+    def profile_zones(self):
+        """Stats for every zone that has run, keyed by Profile name. Times
+        are in DWT cycles."""
+        zones = dict()
+        zone = self.profile_zone(0)
+        for i in range(zone['num_zones']):
+            if i > 0:
+                zone = self.profile_zone(i)
+            if zone['count'] > 0:
+                name = (self._profile_names[i]
+                    if i < len(self._profile_names) else str(i))
+                zone['mean'] = zone['total'] / zone['count']
+                zones[name] = zone
+        return zones
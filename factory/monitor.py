@@ -35,9 +35,15 @@ commands = {
     's': ('Standby', lambda: dut.standby()),
     'e': ('Erase', lambda: dut.erase()),
     'w': ('Watchdog', lambda: dut.watchdog()),
+    'z': ('Zones', lambda: log_zones()),
     'c': ('Clear log', lambda: line_history.clear()),
 }
 
+def log_zones():
+    for name, zone in dut.profile_zones().items():
+        line_history.insert(0, '{:<28s} n={:<10d} min={:<8d} mean={:<10.1f} max={:d}'
+            .format(name, zone['count'], zone['min'], zone['mean'], zone['max']))
+
 dirname = os.path.dirname(os.path.realpath(__file__))
 with open(os.path.join(dirname, 'ui.yaml')) as file:
     ui_structure = yaml.load(file, Loader=yaml.FullLoader)
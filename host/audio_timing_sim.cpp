@@ -0,0 +1,178 @@
+// Drives AudioTiming with a fake DMA position and clock through on-time,
+// late and overrunning callbacks, and checks the counts and histograms it
+// keeps.
+//
+//     make audio_timing_sim
+//     build/<variant>/artifact/audio_timing_sim
+//
+// The callback services the half the DMA has just left. It is on time if
+// the DMA is still in the other half when it enters and when it exits, late
+// if the DMA is back in its half when it enters, and overruns if the DMA is
+// back in its half when it exits.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/config.h"
+#include "drivers/audio_timing.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr uint32_t kBufferSize = 32;
+constexpr uint32_t kHalf = kBufferSize / 2;
+constexpr uint32_t kPeriod = 1000;
+
+class FakeClock
+{
+public:
+    static inline uint32_t now = 0;
+
+    static void Init(void) {}
+
+    static uint32_t Now(void)
+    {
+        return now;
+    }
+};
+
+class FakeDMA
+{
+public:
+    static inline uint32_t position = 0;
+
+    static uint32_t Get(void)
+    {
+        return position;
+    }
+};
+
+using Timing = AudioTiming<FakeDMA, FakeClock>;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// One callback for `half`, entered at `entry` with the DMA at `entry_position`
+// and left `execution` ticks later with the DMA at `exit_position`
+void Callback(Timing &timing, uint32_t half, uint32_t entry,
+    uint32_t entry_position, uint32_t execution, uint32_t exit_position)
+{
+    FakeClock::now = entry;
+    FakeDMA::position = entry_position;
+    timing.Enter(half);
+    FakeClock::now = entry + execution;
+    FakeDMA::position = exit_position;
+    timing.Exit();
+}
+
+using Histogram = uint32_t[AudioTimingStats::kNumBuckets];
+
+void CheckHistogram(const char *what, const Histogram &histogram,
+    const Histogram &expected)
+{
+    std::printf("%-10s", what);
+    bool match = true;
+
+    for (uint32_t i = 0; i < AudioTimingStats::kNumBuckets; i++)
+    {
+        std::printf(" %3u", histogram[i]);
+        match &= (histogram[i] == expected[i]);
+    }
+
+    std::printf("\n");
+    Check(match, what);
+}
+
+void CheckBuckets(void)
+{
+    const struct
+    {
+        uint32_t ticks;
+        uint32_t bucket;
+    }
+    kBuckets[] =
+    {
+        {0, 0}, {3, 0}, {4, 1}, {15, 1}, {16, 2}, {255, 3}, {256, 4},
+        {16383, 6}, {16384, 7}, {UINT32_MAX, 7},
+    };
+
+    for (const auto &b : kBuckets)
+    {
+        Check(AudioTimingStats::Bucket(b.ticks) == b.bucket, "bucket edges");
+    }
+}
+
+void CheckCallbacks(void)
+{
+    Timing timing;
+    timing.Init(kBufferSize, kPeriod);
+
+    // On time: the first callback's jitter isn't counted
+    Callback(timing, 0, 0, kHalf + 1, 100, kHalf + 2);
+    Callback(timing, 1, 1000, 1, 10, 2);
+
+    // Entered 300 ticks late, after the DMA had wrapped back into half 0,
+    // and still there on exit
+    Callback(timing, 0, 2300, 2, 50, 3);
+
+    // Entered on time, but ran until the DMA was back in half 1
+    Callback(timing, 1, 3000, 2, 900, kHalf + 1);
+
+    // After a restart the gap isn't jitter
+    timing.Restart();
+    Callback(timing, 0, 100000, kHalf, 5000, kBufferSize - 2);
+    Callback(timing, 1, 101000, 0, 70000, kHalf - 1);
+
+    const AudioTimingStats &stats = timing.stats();
+    std::printf("callbacks %u, late %u, overruns %u, max jitter %u, "
+        "max execution %u\n", stats.callbacks, stats.late, stats.overruns,
+        stats.max_jitter, stats.max_execution);
+    Check(stats.callbacks == 6, "callbacks");
+    Check(stats.late == 1, "late");
+    Check(stats.overruns == 2, "overruns");
+    Check(stats.max_jitter == 300, "max jitter");
+    Check(stats.max_execution == 70000, "max execution");
+
+    CheckHistogram("jitter", stats.jitter, {2, 0, 0, 0, 2, 0, 0, 0});
+    CheckHistogram("execution", stats.execution, {0, 1, 1, 1, 1, 0, 1, 1});
+}
+
+void CheckWrap(void)
+{
+    Timing timing;
+    timing.Init(kBufferSize, kPeriod);
+
+    // Both the execution time and the interval span the clock's wrap
+    uint32_t entry = UINT32_MAX - 255;
+    Callback(timing, 0, entry, kHalf, 512, kHalf + 4);
+    Callback(timing, 1, entry + kPeriod, 0, 20, 4);
+
+    const AudioTimingStats &stats = timing.stats();
+    Check(stats.max_execution == 512, "execution across the wrap");
+    Check(stats.max_jitter == 0 && stats.jitter[0] == 1,
+        "interval across the wrap");
+    Check(stats.late == 0 && stats.overruns == 0, "on time across the wrap");
+}
+
+}
+
+int main(void)
+{
+    CheckBuckets();
+    CheckCallbacks();
+    CheckWrap();
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
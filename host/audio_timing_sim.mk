@@ -0,0 +1,15 @@
+TARGET := audio_timing_sim
+SOURCES := audio_timing_sim.cpp
+
+TGT_CXX := $(HOST_CXX)
+TGT_LINKER := $(HOST_CXX)
+
+TGT_CXXFLAGS := -O3 -std=gnu++2a \
+	-Wall \
+	-Wextra \
+	-Wno-undef \
+	-Wdouble-promotion \
+	-ffast-math \
+	-fsingle-precision-constant
+
+TGT_LDLIBS := -lm
@@ -0,0 +1,1043 @@
+// Per-engine micro-benchmarks. Times each engine class on its own, and the
+// whole SynthEngine chain, over white noise, and estimates how much of the
+// device's cycle budget each one takes.
+//
+//     make bench
+//     build/<variant>/artifact/bench [options] [name ...]
+//
+// The budget estimate scales host time to Cortex-M7 cycles with a fixed
+// factor (--host-ghz * --cycle-ratio), so it is only a guide for comparing
+// stages; the profiling pins on the device are the real measurement.
+//
+// The engines' ProcessBlock() is timed at 1, 8 and 32 samples per call, as
+// SynthEngine/8 and so on, to show what the per-block control work costs.
+//
+// fastmath::Sin and so on time the approximations in util/fastmath.h against
+// libm's std::sin, std::exp2 and std::log2, over the same inputs. The host's
+// libm is about as fast as they are; newlib's, on the device, is not.
+//
+// Random times NextBipolar() against StdRand, libc's rand() scaled to the
+// same range, which the noise sources used before they had their own
+// generators.
+//
+// CallbackCopy and CallbackView time the audio callback's I/O on its own:
+// converting through intermediate arrays, as it used to, against converting
+// the DMA buffers in place and handing them to the engine as views.
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "drivers/system.h"
+#include "util/random.h"
+#include "util/fastmath.h"
+#include "util/buffer_chain.h"
+#include "util/interpolator.h"
+#include "common/io.h"
+#include "drivers/audio_block.h"
+#include "app/engine/aafilter.h"
+#include "app/engine/sos.h"
+#include "app/engine/formant_filter.h"
+#include "app/engine/formant_bank.h"
+#include "app/engine/pulse_generator.h"
+#include "app/engine/delay_engine.h"
+#include "app/engine/compressor.h"
+#include "app/engine/cyclops_compressor.h"
+#include "app/engine/vibrato.h"
+#include "app/engine/one_pole.h"
+#include "app/engine/one_pole_highpass.h"
+#include "app/engine/envelope_follower.h"
+#include "app/engine/sample_player.h"
+#include "app/engine/resampler.h"
+#include "app/engine/sinc_resampler.h"
+#include "app/engine/upsampler.h"
+#include "app/engine/synth_engine.h"
+#include "app/engine/playback_engine.h"
+#include "app/engine/recording_engine.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr uint32_t kCyclesPerSample = system::kSystemClock / kAudioSampleRateHz;
+constexpr size_t kInputSize = 4096;
+
+// Processes `frames` samples of input, returning something that depends on
+// every output so the work can't be optimized away
+using Kernel = std::function<float(const float *in, size_t frames)>;
+
+struct Benchmark
+{
+    const char *name;
+    float calls_per_sample; // How often the stage runs per base-rate sample
+    std::function<Kernel(void)> make;
+};
+
+struct Result
+{
+    const char *name;
+    float calls_per_sample;
+    double ns_per_call;
+};
+
+struct Options
+{
+    std::vector<std::string> names;
+    uint32_t samples = 1 << 20;
+    uint32_t runs = 5;
+    double host_ghz = 3.0;
+    double cycle_ratio = 2.0;
+    bool json = false;
+};
+
+// Sample memory for SamplePlayer, split into links in the same proportions
+// as the device's SRAM banks and filled with noise
+struct HostMemory
+{
+    using Cursor = BufferChain<float>::Cursor;
+
+    static constexpr uint32_t kLink1Length = 256 * 1024;
+    static constexpr uint32_t kLink2Length = 144 * 1024;
+    static constexpr uint32_t kLink3Length = 63 * 512;
+
+    std::vector<float> data;
+    BufferChain<float>::Link links[3];
+    BufferChain<float> chain;
+
+    HostMemory() : data(kLink1Length + kLink2Length + kLink3Length)
+    {
+        Random random;
+
+        for (float &sample : data)
+        {
+            sample = random.NextBipolar();
+        }
+
+        links[0] = {&data[0], kLink1Length, 0};
+        links[1] = {&data[kLink1Length], kLink2Length, 0};
+        links[2] = {&data[kLink1Length + kLink2Length], kLink3Length, 0};
+        chain.Init(links);
+    }
+
+    float &operator[](size_t index)
+    {
+        return chain[index];
+    }
+
+    Cursor cursor(void)
+    {
+        return chain.cursor();
+    }
+
+    uint32_t length(void)
+    {
+        return chain.length();
+    }
+};
+
+// Two sections of a 4th-order lowpass, for a generic SOSFilter
+constexpr SOSCoefficients kSOSCoeffs[2] =
+{
+    { {4.16599204e-04, 8.33198409e-04, 4.16599204e-04}, {-1.47967422e+00, 5.55821543e-01} },
+    { {1.00000000e+00, 2.00000000e+00, 1.00000000e+00}, {-1.70096433e+00, 7.88499740e-01} },
+};
+
+// The audio callback path from the ADC DMA to the DAC DMA, with a
+// pass-through engine so only the I/O is timed. The DMAs are stood in for by
+// copying codes into the input half before each callback.
+struct CallbackPath
+{
+    static constexpr uint32_t kInputSize = NUM_AUDIO_INS * kAudioOSBlockSize;
+
+    uint32_t codes[kInputSize];
+    uint32_t adc_buffer[kInputSize * 2];
+    uint32_t dac_buffer[kAudioOSBlockSize * 2];
+    uint32_t read_index = 0;
+    uint32_t write_index = 0;
+    Interpolator pot_filter[NUM_POTS];
+    PotInput pot;
+    PotInput io_pot;
+
+    CallbackPath()
+    {
+        Random random;
+
+        for (uint32_t &code : codes)
+        {
+            code = random.Next() & 0xFFFF;
+        }
+
+        for (Interpolator &filter : pot_filter)
+        {
+            filter.Init(NUM_POTS);
+            filter.Sample(0.5f);
+        }
+    }
+
+    void FillADC(void)
+    {
+        std::memcpy(&adc_buffer[read_index], codes, sizeof(codes));
+    }
+
+    // As it was: per-sample conversion into arrays on the stack, with the
+    // output returned by value and copied on to the DAC
+    using CopyInput = std::array<float[kAudioOSBlockSize], NUM_AUDIO_INS>;
+    using CopyOutput = std::array<float[kAudioOSBlockSize], NUM_AUDIO_OUTS>;
+
+    __attribute__((noinline))
+    const CopyOutput CopyProcess(const CopyInput &in, const PotInput &p)
+    {
+        io_pot = p;
+        CopyOutput out = {};
+        std::memcpy(out[AUDIO_OUT_LINE], in[AUDIO_IN_MIC], sizeof(out[0]));
+        return out;
+    }
+
+    float Copy(void)
+    {
+        FillADC();
+        PotInput p;
+        CopyInput audio;
+
+        for (uint32_t i = 0; i < NUM_POTS; i++)
+        {
+            p[i] = pot_filter[i].Next();
+        }
+
+        for (uint32_t idx = 0; idx < kAudioOSBlockSize; idx++)
+        {
+            for (uint32_t ch = 0; ch < NUM_AUDIO_INS; ch++)
+            {
+                float sample = adc_buffer[read_index];
+                read_index = (read_index + 1) % (kInputSize * 2);
+                audio[ch][idx] = (sample / 0xFFFF) * 2 - 1;
+            }
+        }
+
+        CopyOutput out;
+        out = CopyProcess(audio, p);
+
+        for (uint32_t i = 0; i < kAudioOSBlockSize; i++)
+        {
+            float sample = out[AUDIO_OUT_LINE][i];
+            sample = std::clamp<float>(0.5 * (sample + 1), 0, 1);
+            dac_buffer[write_index] = uint32_t(0.5f + 0xFFF * sample);
+            write_index = (write_index + 1) % (kAudioOSBlockSize * 2);
+        }
+
+        return dac_buffer[write_index];
+    }
+
+    // Views straight into the DMA buffers, converted in place
+    __attribute__((noinline))
+    void ViewProcess(const AudioInput &in, const AudioOutput &out, const PotInput &)
+    {
+        for (uint32_t i = 0; i < kAudioOSBlockSize; i++)
+        {
+            out[AUDIO_OUT_LINE][i] = in(AUDIO_IN_MIC, i);
+        }
+    }
+
+    float View(void)
+    {
+        FillADC();
+
+        for (uint32_t i = 0; i < NUM_POTS; i++)
+        {
+            pot[i] = pot_filter[i].Next();
+        }
+
+        uint32_t *block = &adc_buffer[read_index];
+        read_index = (read_index + kInputSize) % (kInputSize * 2);
+        ConvertADCBlock(block, kInputSize);
+        AudioInput in = {std::span<const float, kInputSize>(SampleView(block), kInputSize)};
+
+        uint32_t *dac_block = &dac_buffer[write_index];
+        AudioOutput out = {std::span<float, kAudioOSBlockSize>(
+            SampleView(dac_block), kAudioOSBlockSize)};
+        ViewProcess(in, out, pot);
+        ConvertDACBlock(dac_block, kAudioOSBlockSize);
+        write_index = (write_index + kAudioOSBlockSize) % (kAudioOSBlockSize * 2);
+
+        return dac_buffer[write_index];
+    }
+};
+
+template <typename T>
+std::shared_ptr<T> Make(void)
+{
+    // Some engines are too big for the stack
+    return std::make_shared<T>();
+}
+
+// The three formant biquads as FormantFilter ran them before FormantBank:
+// separate Direct Form I filters with their own state, mixed afterwards.
+// Only the audio-rate path is kept; the coefficients don't move.
+struct FormantBiquads
+{
+    struct Biquad
+    {
+        float b0, b1, b2, a1, a2;
+        float x1, x2, y1, y2;
+
+        float Process(float input)
+        {
+            float y0 = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+            x2 = x1;
+            x1 = input;
+            y2 = y1;
+            y1 = y0;
+            return y0;
+        }
+    };
+
+    Biquad filters[3];
+    float gains[3] = {1.0f, 0.3f, 0.3f};
+
+    FormantBiquads()
+    {
+        const float kFrequencies[3] = {730, 1090, 2440};
+        const float kQs[3] = {12.17f, 12.11f, 16.27f};
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            float omega = 2 * M_PI * kFrequencies[i] / kAudioSampleRate;
+            float alpha = std::sin(omega) / (2 * kQs[i]);
+            float a0 = 1 + alpha;
+            filters[i] = {alpha / a0, 0, -alpha / a0,
+                -2 * std::cos(omega) / a0, (1 - alpha) / a0, 0, 0, 0, 0};
+        }
+    }
+
+    float Process(float input)
+    {
+        float sum = 0;
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            sum += gains[i] * filters[i].Process(input);
+        }
+
+        return sum;
+    }
+};
+
+// A function of one float over the input, scaled and offset into its domain
+template <typename Function>
+Kernel MathKernel(Function function, float scale, float offset)
+{
+    return [=](const float *in, size_t frames)
+    {
+        float sum = 0;
+        for (size_t i = 0; i < frames; i++) sum += function(in[i] * scale + offset);
+        return sum;
+    };
+}
+
+// FormantBank with the first formants of /a/, and a 4th and 5th when asked
+template <uint32_t formants>
+Kernel FormantBankKernel(void)
+{
+    auto bank = Make<FormantBank<formants>>();
+    bank->Init(kAudioSampleRate);
+    const float kFrequencies[5] = {730, 1090, 2440, 3400, 4500};
+    const float kQs[5] = {12.17f, 12.11f, 16.27f, 18, 20};
+    const float kGains[5] = {1.0f, 0.3f, 0.3f, 0.2f, 0.1f};
+
+    for (uint32_t i = 0; i < formants; i++)
+    {
+        bank->SetParameters(i, kFrequencies[i], kQs[i]);
+        bank->SetGain(i, kGains[i]);
+    }
+
+    return [=](const float *in, size_t frames)
+    {
+        float sum = 0;
+        for (size_t i = 0; i < frames; i++) sum += bank->Process(in[i]);
+        return sum;
+    };
+}
+
+// FormantFilter with its coefficients updated every `period` samples
+template <uint32_t period>
+Kernel FormantKernel(void)
+{
+    auto filter = Make<FormantFilter>();
+    filter->Init(kAudioSampleRate);
+    filter->SetControlPeriod(period);
+    filter->SetFormantRate(0.005f);
+    return [=](const float *in, size_t frames)
+    {
+        float sum = 0;
+        for (size_t i = 0; i < frames; i++)
+        {
+            // Keep the formants gliding so the control path is timed too
+            if ((i & 1023) == 0)
+            {
+                filter->SetWahPosition(in[i] * 0.5f + 0.5f);
+            }
+
+            filter->UpdateParameters();
+            sum += filter->Process(in[i]);
+        }
+        return sum;
+    };
+}
+
+// The engines' ProcessBlock() with `block` samples per call, for the cost
+// of the per-call control work at each block size
+template <size_t block>
+Kernel SynthBlocks(void)
+{
+    auto engine = Make<SynthEngine<>>();
+    engine->Init();
+    return [=](const float *, size_t frames)
+    {
+        SynthEngine<>::ControlSnapshot controls =
+        {
+            .button_pressed = true,
+            .pot_value = 0.5f,
+            .hold = false,
+            .formant_pot_val = 0.3f,
+            .vibrato_pot_val = 0.3f,
+            .freq_select_button = false,
+        };
+
+        float sum = 0;
+        for (size_t i = 0; i < frames; i += block)
+        {
+            float out[block * kAudioOSFactor];
+            engine->ProcessBlock(out, std::min(block, frames - i), controls);
+            sum += out[0];
+        }
+        return sum;
+    };
+}
+
+template <size_t block>
+Kernel PlaybackBlocks(void)
+{
+    // The engine keeps a reference to its memory, so keep both alive
+    auto memory = Make<HostMemory>();
+    auto engine = std::make_shared<PlaybackEngine<HostMemory>>(*memory);
+    engine->Init();
+    engine->Play();
+    return [=](const float *, size_t frames)
+    {
+        PlaybackEngine<HostMemory>::ControlSnapshot controls =
+        {
+            .loop = true,
+            .reverse = false,
+            .pot = {},
+        };
+        controls.pot.fill(0.5f);
+
+        float sum = 0;
+        for (size_t i = 0; i < frames; i += block)
+        {
+            float out[block * kAudioOSFactor];
+            engine->ProcessBlock(out, std::min(block, frames - i), controls);
+            sum += out[0];
+        }
+        return sum;
+    };
+}
+
+// Takes what RecordingEngine appends
+struct RecordingSink
+{
+    float sum = 0;
+
+    void Append(std::span<const float> samples)
+    {
+        for (float sample : samples)
+        {
+            sum += sample;
+        }
+    }
+};
+
+template <size_t block>
+Kernel RecordingBlocks(void)
+{
+    auto sink = Make<RecordingSink>();
+    auto engine = std::make_shared<RecordingEngine<RecordingSink>>(*sink);
+    engine->Init();
+    return [=](const float *in, size_t frames)
+    {
+        float sum = 0;
+        for (size_t i = 0; i < frames; i += block)
+        {
+            // The oversampled input, from the noise at the base rate
+            float os[block * kAudioOSFactor];
+            size_t count = std::min(block, frames - i);
+            for (size_t j = 0; j < count * kAudioOSFactor; j++)
+            {
+                os[j] = in[i + j / kAudioOSFactor];
+            }
+            engine->ProcessBlock(os, count, {.pitch = 0.3f});
+        }
+        sum += sink->sum;
+        return sum;
+    };
+}
+
+const Benchmark kBenchmarks[] =
+{
+    {"AAFilter", kAudioOSFactor, []() -> Kernel
+    {
+        auto filter = Make<AAFilter<float>>();
+        filter->Init();
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += filter->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"SOSFilter", 1, []() -> Kernel
+    {
+        auto filter = Make<SOSFilter<float, 2>>();
+        filter->Init(2, kSOSCoeffs);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += filter->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"Upsampler", 1, []() -> Kernel
+    {
+        auto upsampler = Make<Upsampler<float>>();
+        upsampler->Init();
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++)
+            {
+                float out[kAudioOSFactor];
+                upsampler->Process(in[i], out);
+                sum += out[0];
+            }
+            return sum;
+        };
+    }},
+    {"FormantFilter/1", 1, FormantKernel<1>},
+    {"FormantFilter/16", 1, FormantKernel<16>},
+    {"FormantBiquads/3", 1, []() -> Kernel
+    {
+        auto filters = Make<FormantBiquads>();
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += filters->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"FormantBank/3", 1, FormantBankKernel<3>},
+    {"FormantBank/5", 1, FormantBankKernel<5>},
+    {"fastmath::Sin", 1, []() -> Kernel
+    {
+        return MathKernel([](float x) { return fastmath::Sin(x); }, 12, 0);
+    }},
+    {"std::sin", 1, []() -> Kernel
+    {
+        return MathKernel([](float x) { return std::sin(x); }, 12, 0);
+    }},
+    {"fastmath::Exp2", 1, []() -> Kernel
+    {
+        return MathKernel([](float x) { return fastmath::Exp2(x); }, 16, 0);
+    }},
+    {"std::exp2", 1, []() -> Kernel
+    {
+        return MathKernel([](float x) { return std::exp2(x); }, 16, 0);
+    }},
+    {"fastmath::Log2", 1, []() -> Kernel
+    {
+        return MathKernel([](float x) { return fastmath::Log2(x); }, 1, 1);
+    }},
+    {"std::log2", 1, []() -> Kernel
+    {
+        return MathKernel([](float x) { return std::log2(x); }, 1, 1);
+    }},
+    {"Random", 1, []() -> Kernel
+    {
+        auto random = Make<Random>();
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += random->NextBipolar();
+            return sum;
+        };
+    }},
+    {"StdRand", 1, []() -> Kernel
+    {
+        std::srand(Random::kDefaultSeed);
+        return [](const float *, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++)
+            {
+                sum += float(std::rand()) / RAND_MAX * 2 - 1;
+            }
+            return sum;
+        };
+    }},
+    {"PulseGenerator", 1, []() -> Kernel
+    {
+        auto pulse = Make<PulseGenerator>();
+        pulse->SetBaseDutyCycle(0.1f);
+        pulse->SetDutyCycleRandomization(0.5f);
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            float phase = 0;
+            float increment = 220.f / kAudioSampleRate;
+            for (size_t i = 0; i < frames; i++)
+            {
+                phase += increment;
+                phase -= (phase >= 1.f);
+                sum += pulse->GenerateSample(phase, increment);
+            }
+            return sum;
+        };
+    }},
+    {"DelayEngine", 1, []() -> Kernel
+    {
+        auto delay = Make<DelayEngine<>>();
+        delay->Init();
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += delay->Process(in[i], 0.3f, 0.4f);
+            return sum;
+        };
+    }},
+    {"Compressor", 1, []() -> Kernel
+    {
+        auto compressor = Make<Compressor>();
+        compressor->Init(1, 1.05f, 1, 5, 250, 100, kAudioSampleRate);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += compressor->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"CyclopsCompressor", 1, []() -> Kernel
+    {
+        auto compressor = Make<CyclopsCompressor>();
+        compressor->Init(17, 8, 5, 30, kAudioSampleRate);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += compressor->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"Vibrato", 1, []() -> Kernel
+    {
+        auto vibrato = Make<Vibrato<>>();
+        vibrato->Init();
+        vibrato->SetParameters(6, 0.12f, 1.8f);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += vibrato->Process(220 + in[i]);
+            return sum;
+        };
+    }},
+    {"OnePoleLowpass", 1, []() -> Kernel
+    {
+        auto filter = Make<OnePoleLowpass>();
+        filter->Init(1000, kAudioSampleRate);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += filter->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"OnePoleHighpass", 1, []() -> Kernel
+    {
+        auto filter = Make<OnePoleHighpass>();
+        filter->Init(120, kAudioSampleRate);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += filter->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"EnvelopeFollower", 1, []() -> Kernel
+    {
+        auto follower = Make<EnvelopeFollower>();
+        follower->Init(10, 250, 100, kAudioSampleRate);
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += follower->Process(in[i]);
+            return sum;
+        };
+    }},
+    {"SamplePlayer", 1, []() -> Kernel
+    {
+        // The player keeps a reference to its memory, so keep both alive
+        auto memory = Make<HostMemory>();
+        auto player = std::make_shared<SamplePlayer<HostMemory>>(*memory);
+        player->Init();
+        player->Play();
+        return [=](const float *, size_t frames)
+        {
+            (void)memory;
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++) sum += player->Process(1, true, false);
+            return sum;
+        };
+    }},
+    // BufferChain access as SamplePlayer does it, two reads per sample, in
+    // order and at random positions
+    {"ChainIndex", 1, []() -> Kernel
+    {
+        auto memory = Make<HostMemory>();
+        auto index = std::make_shared<uint32_t>(0);
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            uint32_t length = memory->length();
+            for (size_t i = 0; i < frames; i++)
+            {
+                *index = (*index + 1 < length) ? *index + 1 : 0;
+                sum += (*memory)[*index] + (*memory)[*index + 1];
+            }
+            return sum;
+        };
+    }},
+    {"ChainCursor", 1, []() -> Kernel
+    {
+        auto memory = Make<HostMemory>();
+        auto cursor = std::make_shared<HostMemory::Cursor>(memory->cursor());
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            uint32_t length = memory->length();
+            for (size_t i = 0; i < frames; i++)
+            {
+                uint32_t index = cursor->index();
+                cursor->Seek((index + 1 < length) ? index + 1 : 0);
+                sum += **cursor;
+                ++*cursor;
+                sum += **cursor;
+                --*cursor;
+            }
+            return sum;
+        };
+    }},
+    {"ChainIndexRandom", 1, []() -> Kernel
+    {
+        auto memory = Make<HostMemory>();
+        auto random = std::make_shared<Random>();
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            uint32_t length = memory->length();
+            for (size_t i = 0; i < frames; i++)
+            {
+                uint32_t index = random->NextBelow(length);
+                sum += (*memory)[index] + (*memory)[index + 1];
+            }
+            return sum;
+        };
+    }},
+    {"ChainCursorRandom", 1, []() -> Kernel
+    {
+        auto memory = Make<HostMemory>();
+        auto random = std::make_shared<Random>();
+        auto cursor = std::make_shared<HostMemory::Cursor>(memory->cursor());
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            uint32_t length = memory->length();
+            for (size_t i = 0; i < frames; i++)
+            {
+                cursor->Seek(random->NextBelow(length));
+                sum += **cursor;
+                ++*cursor;
+                sum += **cursor;
+            }
+            return sum;
+        };
+    }},
+    {"Resampler", 1, []() -> Kernel
+    {
+        auto resampler = Make<Resampler<16>>();
+        resampler->Init();
+        resampler->Reset();
+        return [=](const float *in, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i++)
+            {
+                float sample;
+                resampler->Push(in[i], 1.5f);
+                while (resampler->Pop(sample)) sum += sample;
+            }
+            return sum;
+        };
+    }},
+    {"SincResampler", 1, []() -> Kernel
+    {
+        auto resampler = Make<SincResampler<32, 32, 4>>();
+        resampler->Init();
+        return [=](const float *in, size_t frames)
+        {
+            float out[SincResampler<32, 32, 4>::MaxOutput(kAudioBlockSize)];
+            float sum = 0;
+            for (size_t i = 0; i < frames; i += kAudioBlockSize)
+            {
+                size_t count = std::min<size_t>(frames - i, kAudioBlockSize);
+                size_t written = resampler->Process(&in[i], count, 1.5f, out);
+                for (size_t j = 0; j < written; j++) sum += out[j];
+            }
+            return sum;
+        };
+    }},
+    {"SynthEngine/1", 1, SynthBlocks<1>},
+    {"SynthEngine/8", 1, SynthBlocks<8>},
+    {"SynthEngine/32", 1, SynthBlocks<32>},
+    {"PlaybackEngine/1", 1, PlaybackBlocks<1>},
+    {"PlaybackEngine/8", 1, PlaybackBlocks<8>},
+    {"PlaybackEngine/32", 1, PlaybackBlocks<32>},
+    {"RecordingEngine/1", 1, RecordingBlocks<1>},
+    {"RecordingEngine/8", 1, RecordingBlocks<8>},
+    {"RecordingEngine/32", 1, RecordingBlocks<32>},
+    {"CallbackCopy", 1, []() -> Kernel
+    {
+        auto path = Make<CallbackPath>();
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i += kAudioBlockSize) sum += path->Copy();
+            return sum;
+        };
+    }},
+    {"CallbackView", 1, []() -> Kernel
+    {
+        auto path = Make<CallbackPath>();
+        return [=](const float *, size_t frames)
+        {
+            float sum = 0;
+            for (size_t i = 0; i < frames; i += kAudioBlockSize) sum += path->View();
+            return sum;
+        };
+    }},
+};
+
+void Usage(const char *name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options] [name ...]\n"
+        "  --samples N      samples per timed run (default 1048576)\n"
+        "  --runs N         timed runs; the fastest is reported (default 5)\n"
+        "  --host-ghz X     host clock, for the cycle estimate (default 3.0)\n"
+        "  --cycle-ratio X  Cortex-M7 cycles per host cycle (default 2.0)\n"
+        "  --json           machine-readable output\n",
+        name);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--samples") && value)
+        {
+            options.samples = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--runs") && value)
+        {
+            options.runs = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--host-ghz") && value)
+        {
+            options.host_ghz = std::strtod(value, nullptr);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--cycle-ratio") && value)
+        {
+            options.cycle_ratio = std::strtod(value, nullptr);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--json"))
+        {
+            options.json = true;
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.names.push_back(arg);
+        }
+    }
+
+    return options.samples > 0 && options.runs > 0;
+}
+
+bool Selected(const Options &options, const char *name)
+{
+    if (options.names.empty())
+    {
+        return true;
+    }
+
+    for (const std::string &selected : options.names)
+    {
+        if (selected == name)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+double Time(const Benchmark &benchmark, const float *input, const Options &options)
+{
+    Kernel kernel = benchmark.make();
+    volatile float sink = 0;
+
+    // Warm up the caches and branch predictors
+    sink = sink + kernel(input, kInputSize);
+
+    double best = 0;
+
+    for (uint32_t run = 0; run < options.runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t done = 0; done < options.samples; done += kInputSize)
+        {
+            uint32_t frames = options.samples - done;
+            frames = (frames < kInputSize) ? frames : kInputSize;
+            sink = sink + kernel(input, frames);
+        }
+
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        double ns = elapsed.count() / options.samples;
+        best = (run == 0 || ns < best) ? ns : best;
+    }
+
+    return best;
+}
+
+void Report(const std::vector<Result> &results, const Options &options)
+{
+    double cycles_per_ns = options.host_ghz * options.cycle_ratio;
+
+    if (options.json)
+    {
+        std::printf("{\n"
+            "  \"system_clock\": %u,\n"
+            "  \"sample_rate\": %u,\n"
+            "  \"cycles_per_sample\": %u,\n"
+            "  \"host_ghz\": %g,\n"
+            "  \"cycle_ratio\": %g,\n"
+            "  \"benchmarks\": [\n",
+            system::kSystemClock, kAudioSampleRateHz, kCyclesPerSample,
+            options.host_ghz, options.cycle_ratio);
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &r = results[i];
+            double ns_per_sample = r.ns_per_call * double(r.calls_per_sample);
+            double cycles = ns_per_sample * cycles_per_ns;
+
+            std::printf("    {\"name\": \"%s\", \"ns_per_call\": %.3f, "
+                "\"calls_per_sample\": %g, \"ns_per_sample\": %.3f, "
+                "\"est_cycles_per_sample\": %.1f, \"budget_percent\": %.2f}%s\n",
+                r.name, r.ns_per_call, double(r.calls_per_sample), ns_per_sample,
+                cycles, 100 * cycles / kCyclesPerSample,
+                (i + 1 < results.size()) ? "," : "");
+        }
+
+        std::printf("  ]\n}\n");
+        return;
+    }
+
+    std::printf("Budget: %u cycles per sample (%u MHz / %u Hz), "
+        "estimating %.1f M7 cycles per host ns\n\n",
+        kCyclesPerSample, system::kSystemClock / 1000000, kAudioSampleRateHz,
+        cycles_per_ns);
+    std::printf("%-18s %9s %7s %10s %10s %8s\n",
+        "engine", "ns/call", "calls", "ns/sample", "cycles", "budget");
+
+    for (const Result &r : results)
+    {
+        double ns_per_sample = r.ns_per_call * double(r.calls_per_sample);
+        double cycles = ns_per_sample * cycles_per_ns;
+
+        std::printf("%-18s %9.2f %7g %10.2f %10.0f %7.1f%%\n",
+            r.name, r.ns_per_call, double(r.calls_per_sample), ns_per_sample,
+            cycles, 100 * cycles / kCyclesPerSample);
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> input(kInputSize);
+    Random random;
+
+    for (float &sample : input)
+    {
+        sample = 0.5f * random.NextBipolar();
+    }
+
+    std::vector<Result> results;
+
+    for (const Benchmark &benchmark : kBenchmarks)
+    {
+        if (Selected(options, benchmark.name))
+        {
+            results.push_back({benchmark.name, benchmark.calls_per_sample,
+                Time(benchmark, input.data(), options)});
+        }
+    }
+
+    if (results.empty())
+    {
+        std::fprintf(stderr, "No benchmarks selected\n");
+        return EXIT_FAILURE;
+    }
+
+    Report(results, options);
+    return EXIT_SUCCESS;
+}
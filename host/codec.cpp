@@ -0,0 +1,315 @@
+// Storage codec benchmarks. Records test material through CodedMemory with
+// each codec and plays it back through the decoding cursor, reporting the
+// SNR of the round trip and the encode and decode throughput.
+//
+//     make codec
+//     build/<variant>/artifact/codec [options] [file.wav ...]
+//
+// Without files, the golden references in host/golden are used along with a
+// sine sweep and white noise. Run it from the top of the tree.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "util/buffer_chain.h"
+#include "util/random.h"
+#include "app/engine/sample_codec.h"
+#include "app/engine/coded_memory.h"
+#include "host/wav_file.h"
+
+using namespace recorder;
+
+namespace
+{
+
+// The device's sample memory size
+constexpr uint32_t kMemorySize = (512 + 288 + 63) * 1024;
+
+struct Material
+{
+    std::string name;
+    std::vector<float> samples;
+};
+
+struct Options
+{
+    std::vector<std::string> files;
+    uint32_t runs = 5;
+};
+
+// Stands in for SampleMemory: the recording and reading interface, over one
+// link of host memory
+template <typename T>
+class HostSampleMemory
+{
+public:
+    using Cursor = BufferChain<T>::Cursor;
+
+    HostSampleMemory() : data_(kMemorySize / sizeof(T))
+    {
+        link_[0] = {data_.data(), uint32_t(data_.size()), 0};
+        chain_.Init(link_);
+    }
+
+    void StartRecording(void)
+    {
+        length_ = 0;
+        write_cursor_.Seek(0);
+    }
+
+    template <typename U>
+    void Append(std::span<U> items)
+    {
+        length_ += write_cursor_.Write(items);
+    }
+
+    void StopRecording(void) {}
+
+    uint32_t length(void)
+    {
+        return length_;
+    }
+
+    Cursor cursor(void)
+    {
+        return chain_.cursor();
+    }
+
+protected:
+    std::vector<T> data_;
+    typename BufferChain<T>::Link link_[1];
+    BufferChain<T> chain_;
+    Cursor write_cursor_{&chain_};
+    uint32_t length_ = 0;
+};
+
+struct Result
+{
+    double snr;
+    double encode_msps;
+    double decode_msps;
+    bool fits;
+};
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <typename Codec>
+Result Measure(const std::vector<float> &samples, const Options &options)
+{
+    using Memory = HostSampleMemory<typename Codec::Word>;
+    auto memory = std::make_unique<Memory>();
+    auto coded = std::make_unique<CodedMemory<Codec, Memory>>(*memory);
+
+    // Only as much as fits in the device's memory is recorded
+    uint32_t capacity = kMemorySize / sizeof(typename Codec::Word) /
+        Codec::kFrameWords * Codec::kFrameLength;
+    uint32_t length = std::min<size_t>(samples.size(), capacity);
+    Result result = {0, 0, 0, samples.size() <= capacity};
+
+    double encode = 0;
+    double decode = 0;
+    double signal = 0;
+    double noise = 0;
+
+    for (uint32_t run = 0; run < options.runs; run++)
+    {
+        // Appended in callback-sized blocks, as RecordingEngine does
+        auto start = std::chrono::steady_clock::now();
+        coded->StartRecording();
+
+        for (uint32_t i = 0; i < length; i += kAudioBlockSize)
+        {
+            uint32_t count = std::min(kAudioBlockSize, length - i);
+            coded->Append(std::span<const float>(&samples[i], count));
+        }
+
+        coded->StopRecording();
+        double seconds = Seconds(start);
+        encode = (run == 0 || seconds < encode) ? seconds : encode;
+
+        start = std::chrono::steady_clock::now();
+        auto cursor = coded->cursor();
+        signal = noise = 0;
+
+        for (uint32_t i = 0; i < length; i++)
+        {
+            cursor.Seek(i);
+            double error = double(*cursor) - double(samples[i]);
+            signal += double(samples[i]) * double(samples[i]);
+            noise += error * error;
+        }
+
+        seconds = Seconds(start);
+        decode = (run == 0 || seconds < decode) ? seconds : decode;
+    }
+
+    result.snr = (noise > 0) ? 10 * std::log10(signal / noise) : double(INFINITY);
+    result.encode_msps = length / encode / double(1e6);
+    result.decode_msps = length / decode / double(1e6);
+    return result;
+}
+
+std::vector<Material> MakeMaterial(void)
+{
+    std::vector<Material> material;
+    uint32_t length = kAudioSampleRateHz * 4;
+
+    // Exponential sweep from 50 Hz to 7 kHz at -6 dBFS
+    Material sweep = {"sweep", std::vector<float>(length)};
+    double phase = 0;
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        double freq = 50 * std::pow(140.0, double(i) / length);
+        phase += 2 * double(M_PI) * freq / kAudioSampleRateHz;
+        sweep.samples[i] = 0.5f * float(std::sin(phase));
+    }
+
+    material.push_back(std::move(sweep));
+
+    Material noise = {"noise", std::vector<float>(length)};
+    Random random;
+
+    for (float &sample : noise.samples)
+    {
+        sample = 0.25f * random.NextBipolar();
+    }
+
+    material.push_back(std::move(noise));
+    return material;
+}
+
+bool Load(const std::string &path, std::vector<Material> &material)
+{
+    WavReader reader;
+
+    if (!reader.Open(path.c_str()))
+    {
+        std::fprintf(stderr, "%s: can't read\n", path.c_str());
+        return false;
+    }
+
+    if (reader.sample_rate() != kAudioSampleRateHz)
+    {
+        std::fprintf(stderr, "%s: sample rate is %u, not %u\n", path.c_str(),
+            reader.sample_rate(), kAudioSampleRateHz);
+        return false;
+    }
+
+    Material item = {std::filesystem::path(path).stem(),
+        std::vector<float>(reader.frames())};
+    item.samples.resize(reader.Read(item.samples.data(), item.samples.size()));
+    material.push_back(std::move(item));
+    return true;
+}
+
+void Usage(const char *name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options] [file.wav ...]\n"
+        "  --runs N    timed runs; the fastest is reported (default 5)\n",
+        name);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--runs") && value)
+        {
+            options.runs = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.files.push_back(arg);
+        }
+    }
+
+    return options.runs > 0;
+}
+
+template <typename Codec>
+void Report(const char *codec, const std::vector<Material> &material,
+            const Options &options)
+{
+    double bits = 8.0 * sizeof(typename Codec::Word) * Codec::kFrameWords /
+        Codec::kFrameLength;
+    double seconds = kMemorySize * 8 / bits / kAudioSampleRateHz;
+    std::printf("%s: %.3g bits/sample, %.0f s in %u KB\n", codec, bits,
+        seconds, kMemorySize / 1024);
+
+    for (const Material &item : material)
+    {
+        Result result = Measure<Codec>(item.samples, options);
+        std::printf("  %-16s SNR %6.1f dB  encode %7.1f Msps  decode %7.1f Msps%s\n",
+            item.name.c_str(), result.snr, result.encode_msps,
+            result.decode_msps, result.fits ? "" : "  (truncated)");
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Material> material;
+
+    if (options.files.empty())
+    {
+        material = MakeMaterial();
+        std::vector<std::string> goldens;
+
+        for (auto &entry : std::filesystem::directory_iterator("host/golden"))
+        {
+            if (entry.path().extension() == ".wav")
+            {
+                goldens.push_back(entry.path());
+            }
+        }
+
+        std::sort(goldens.begin(), goldens.end());
+        options.files = goldens;
+    }
+
+    for (const std::string &file : options.files)
+    {
+        if (!Load(file, material))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    Report<Fp16Codec>("fp16", material, options);
+    Report<MuLawCodec>("mu-law", material, options);
+    Report<AdpcmCodec>("IMA-ADPCM", material, options);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "util/random.h"
+
+namespace recorder
+{
+
+// A timeline of control changes for offline renders. The text format is one
+// statement per line, with '#' starting a comment:
+//
+//     seed 1234          PRNG seed for the engine (default Random::kDefaultSeed)
+//     length 4.5         Seconds to render (default: last event + 1 s)
+//     0.25 pot1 0.8      At 0.25 s, set POT_1 to 0.8
+//     0.50 play 1        At 0.5 s, press the play button
+//
+// Controls are pot1, pot2 and pot3 (0 to 1) and the switches play, tune and
+// loop (0 or 1). Everything starts at zero. Events may be listed in any
+// order; events with the same time apply in file order.
+class ControlScript
+{
+public:
+    enum Control
+    {
+        CONTROL_POT_1,
+        CONTROL_POT_2,
+        CONTROL_POT_3,
+        CONTROL_PLAY,
+        CONTROL_TUNE,
+        CONTROL_LOOP,
+        NUM_CONTROLS,
+    };
+
+    struct Event
+    {
+        float time;
+        Control control;
+        float value;
+    };
+
+    // Current value of every control, updated by Apply()
+    struct State
+    {
+        float value[NUM_CONTROLS];
+
+        bool pressed(Control control) const
+        {
+            return value[control] >= 0.5f;
+        }
+    };
+
+    bool Load(const char *path)
+    {
+        FILE *file = std::fopen(path, "r");
+        if (!file)
+        {
+            std::fprintf(stderr, "%s: can't open\n", path);
+            return false;
+        }
+
+        events_.clear();
+        seed_ = Random::kDefaultSeed;
+        length_ = -1;
+
+        char line[256];
+        bool ok = true;
+
+        for (uint32_t number = 1; ok && std::fgets(line, sizeof(line), file); number++)
+        {
+            ok = ParseLine(line);
+            if (!ok)
+            {
+                std::fprintf(stderr, "%s:%u: syntax error\n", path, number);
+            }
+        }
+
+        std::fclose(file);
+
+        std::stable_sort(events_.begin(), events_.end(),
+            [](const Event &a, const Event &b) { return a.time < b.time; });
+
+        if (length_ < 0)
+        {
+            length_ = (events_.empty() ? 0 : events_.back().time) + 1;
+        }
+
+        return ok;
+    }
+
+    const std::vector<Event> &events(void) const
+    {
+        return events_;
+    }
+
+    uint32_t seed(void) const
+    {
+        return seed_;
+    }
+
+    float length(void) const
+    {
+        return length_;
+    }
+
+    static void Apply(const Event &event, State &state)
+    {
+        state.value[event.control] = event.value;
+    }
+
+protected:
+    bool ParseLine(char *line)
+    {
+        if (char *comment = std::strchr(line, '#'))
+        {
+            *comment = '\0';
+        }
+
+        char *tokens[3];
+        uint32_t count = 0;
+
+        for (char *token = std::strtok(line, " \t\r\n"); token;
+             token = std::strtok(nullptr, " \t\r\n"))
+        {
+            if (count == 3)
+            {
+                return false;
+            }
+
+            tokens[count++] = token;
+        }
+
+        if (count == 0)
+        {
+            return true;
+        }
+        else if (count == 2 && !std::strcmp(tokens[0], "seed"))
+        {
+            return ParseSeed(tokens[1], seed_);
+        }
+        else if (count == 2 && !std::strcmp(tokens[0], "length"))
+        {
+            return ParseNumber(tokens[1], length_) && length_ >= 0;
+        }
+        else if (count == 3)
+        {
+            Event event;
+            if (ParseNumber(tokens[0], event.time) && event.time >= 0 &&
+                ParseControl(tokens[1], event.control) &&
+                ParseNumber(tokens[2], event.value))
+            {
+                events_.push_back(event);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool ParseNumber(const char *token, float &value)
+    {
+        char *end;
+        value = std::strtof(token, &end);
+        return *end == '\0';
+    }
+
+    static bool ParseSeed(const char *token, uint32_t &value)
+    {
+        char *end;
+        value = std::strtoul(token, &end, 0);
+        return *end == '\0';
+    }
+
+    static bool ParseControl(const char *token, Control &control)
+    {
+        static const char *const kNames[NUM_CONTROLS] =
+        {
+            "pot1", "pot2", "pot3", "play", "tune", "loop",
+        };
+
+        for (uint32_t i = 0; i < NUM_CONTROLS; i++)
+        {
+            if (!std::strcmp(token, kNames[i]))
+            {
+                control = static_cast<Control>(i);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    std::vector<Event> events_;
+    uint32_t seed_;
+    float length_;
+};
+
+}
@@ -0,0 +1,152 @@
+// Simulates the ADC and DAC ping-pong DMA for every supported audio block
+// size and checks that a pass-through callback delivers input samples to the
+// output in order, with the expected latency of two blocks.
+//
+//     make dma_sim
+//
+// Both DMAs are clocked by the same timer at the oversampled rate. The ADC
+// DMA writes NUM_AUDIO_INS words per tick into a circular buffer of two
+// blocks and raises an interrupt at each half; the callback reads that
+// block the way Adc::PerformCallback() does and writes it the way
+// Dac::Process() does. The DAC DMA reads one word per tick from its own
+// two-block buffer. Each callback's reads and writes happen when it returns,
+// which is the worst case for a given execution time.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "common/config.h"
+#include "common/io.h"
+
+using namespace recorder;
+
+namespace
+{
+
+struct Result
+{
+    bool ordered;
+    uint32_t latency;
+};
+
+// `execution` is the callback's run time in oversampled ticks
+Result Simulate(uint32_t block_size, uint32_t execution, uint32_t ticks)
+{
+    const uint32_t os_block = block_size * kAudioOSFactor;
+    const uint32_t adc_size = NUM_AUDIO_INS * os_block * 2;
+    const uint32_t dac_size = os_block * 2;
+
+    std::vector<int32_t> adc_buffer(adc_size, -1);
+    std::vector<int32_t> dac_buffer(dac_size, -1);
+    uint32_t adc_position = 0;
+    uint32_t dac_position = 0;
+    uint32_t read_index = 0;
+    uint32_t write_index = 0;
+
+    // Completion times of callbacks in flight
+    std::vector<uint32_t> pending;
+    std::vector<int32_t> output;
+
+    for (uint32_t t = 0; t < ticks; t++)
+    {
+        for (size_t i = 0; i < pending.size();)
+        {
+            if (pending[i] > t)
+            {
+                i++;
+                continue;
+            }
+
+            pending.erase(pending.begin() + i);
+
+            for (uint32_t n = 0; n < os_block; n++)
+            {
+                int32_t sample = adc_buffer[read_index];
+                read_index = (read_index + NUM_AUDIO_INS) % adc_size;
+                dac_buffer[write_index] = sample;
+                write_index = (write_index + 1) % dac_size;
+            }
+        }
+
+        output.push_back(dac_buffer[dac_position]);
+        dac_position = (dac_position + 1) % dac_size;
+
+        // Channel 0 carries the tick number, the others are ignored
+        for (uint32_t ch = 0; ch < NUM_AUDIO_INS; ch++)
+        {
+            adc_buffer[adc_position++] = ch ? -2 : t;
+        }
+
+        if (adc_position % (adc_size / 2) == 0)
+        {
+            pending.push_back(t + 1 + execution);
+            adc_position %= adc_size;
+        }
+    }
+
+    // Find the first sample that made it through, then check that every
+    // later one follows it in order
+    Result result = {false, 0};
+
+    for (uint32_t t = 0; t < output.size(); t++)
+    {
+        if (output[t] >= 0)
+        {
+            result.latency = t - output[t];
+            result.ordered = true;
+
+            for (uint32_t u = t; u < output.size(); u++)
+            {
+                result.ordered &= (output[u] == int32_t(u - result.latency));
+            }
+
+            break;
+        }
+    }
+
+    return result;
+}
+
+}
+
+int main(void)
+{
+    static const uint32_t kBlockSizes[] = {1, 2, 4, 8, 16, 32, 64};
+    bool ok = true;
+
+    std::printf("%6s %10s %10s %12s  %s\n",
+        "block", "irq/s", "latency", "latency ms", "deadline");
+
+    for (uint32_t block_size : kBlockSizes)
+    {
+        uint32_t os_block = block_size * kAudioOSFactor;
+        uint32_t ticks = os_block * 64;
+
+        // Any callback that returns within its block must give an ordered
+        // stream with exactly two blocks of latency
+        bool meets = true;
+        uint32_t latency = 0;
+
+        for (uint32_t execution = 0; execution < os_block; execution++)
+        {
+            Result result = Simulate(block_size, execution, ticks);
+            meets &= result.ordered && result.latency == 2 * os_block;
+            latency = result.latency;
+        }
+
+        // ...and one that runs half a block over must be caught
+        Result late = Simulate(block_size, os_block + os_block / 2, ticks);
+        bool detected = !late.ordered || late.latency != 2 * os_block;
+
+        ok &= meets && detected;
+
+        std::printf("%6u %10.0f %10u %12.3f  %s\n",
+            block_size, double(kAudioSampleRate) / block_size, latency,
+            latency / double(kAudioOSRate) * 1000,
+            (meets && detected) ? "ok" : "FAIL");
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Host stand-in for drivers/crc.h: the same CRC-32 as the STM32 CRC unit set
+// up by Crc::Init() (polynomial 0x04C11DB7, no reflection, words fed most
+// significant bit first), in software. Each word or byte fed costs
+// `kAccessCycles` on the QUADSPI fake's clock, so host tools that time the
+// flash also see the CPU time the CRC takes.
+
+#include <cstdint>
+#include <cstring>
+
+#include "drivers/qspi.h"
+
+namespace recorder
+{
+
+class Crc
+{
+public:
+    void Init(void)
+    {
+        Seed(0);
+    }
+
+    void Seed(uint32_t value)
+    {
+        crc_ = ~value;
+    }
+
+    uint32_t Process(const uint8_t* data, uint32_t size)
+    {
+        while (size >= 4)
+        {
+            uint32_t word;
+            std::memcpy(&word, data, 4);
+            Feed(word, 32);
+            size -= 4;
+            data += 4;
+        }
+
+        while (size--)
+        {
+            Feed(*data++, 8);
+        }
+
+        return value();
+    }
+
+    template <typename T>
+    uint32_t Process(const T* data, uint32_t size)
+    {
+        return Process(reinterpret_cast<const uint8_t*>(data), size);
+    }
+
+    uint32_t value(void) const
+    {
+        return ~crc_;
+    }
+
+protected:
+    static constexpr uint32_t kPolynomial = 0x04C11DB7;
+
+    uint32_t crc_ = 0xFFFFFFFF;
+
+    void Feed(uint32_t data, uint32_t bits)
+    {
+        using qspi::FakeQuadSPI;
+        qspi::fake.Advance(FakeQuadSPI::kAccessCycles / FakeQuadSPI::kKernelClock_MHz);
+        crc_ ^= data << (32 - bits);
+
+        for (uint32_t i = 0; i < bits; i++)
+        {
+            crc_ = (crc_ & 0x80000000) ? (crc_ << 1) ^ kPolynomial : (crc_ << 1);
+        }
+    }
+};
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Host stand-in for drivers/profiling.h, for drivers built against fakes.
+// The pins do nothing.
+
+#include "drivers/profiles.h"
+
+namespace recorder
+{
+
+template <Profile profile>
+class ProfilingPin
+{
+public:
+    static void Set(void) {}
+    static void Clear(void) {}
+    static void Write(bool) {}
+    static void Toggle(void) {}
+
+    static constexpr bool active(void)
+    {
+        return false;
+    }
+};
+
+template <Profile profile>
+class ScopedProfilingPin
+{
+public:
+    ScopedProfilingPin() {}
+    ~ScopedProfilingPin() {}
+};
+
+}
@@ -0,0 +1,984 @@
+#pragma once
+
+// Host stand-in for drivers/qspi.h: a register-level fake of the QUADSPI
+// peripheral and its MDMA channel, with a serial NOR flash behind it. Host
+// tools put host/fake ahead of the top of the tree on the include path, so
+// drivers/flash.h builds against this unchanged.
+//
+// The fake checks the command sequences as they happen and records every
+// command, protocol errors and a simulated time. The time model assumes a
+// 64 MHz kernel clock, and `kAccessCycles` CPU or MDMA cycles for each access
+// to the data register or the memory-mapped window. Transfers are limited by
+// whichever of the bus and the accesses is slower.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// The register and bit definitions drivers/flash.h uses, from RM0433 and the
+// HAL QSPI driver
+
+#define QUADSPI_CR_EN               (1u << 0)
+#define QUADSPI_CR_ABORT            (1u << 1)
+#define QUADSPI_CR_FTHRES_Pos       8
+#define QUADSPI_CR_PRESCALER_Pos    24
+#define QUADSPI_DCR_FSIZE_Pos       16
+#define QUADSPI_SR_TCF              (1u << 1)
+#define QUADSPI_SR_FTF              (1u << 2)
+#define QUADSPI_SR_BUSY             (1u << 5)
+#define QUADSPI_SR_FLEVEL           (0x3Fu << 8)
+#define QUADSPI_FCR_CTCF            (1u << 1)
+#define QUADSPI_CCR_DCYC_Pos        18
+#define QUADSPI_CCR_FMODE_0         (1u << 26)
+#define QUADSPI_CCR_FMODE_1         (1u << 27)
+
+#define QSPI_INSTRUCTION_1_LINE     (1u << 8)
+#define QSPI_INSTRUCTION_4_LINES    (3u << 8)
+#define QSPI_ADDRESS_1_LINE         (1u << 10)
+#define QSPI_ADDRESS_4_LINES        (3u << 10)
+#define QSPI_ADDRESS_24_BITS        (2u << 12)
+#define QSPI_DATA_1_LINE            (1u << 24)
+#define QSPI_DATA_4_LINES           (3u << 24)
+#define QSPI_FLASH_ID_1             0u
+#define QSPI_DUALFLASH_DISABLE      0u
+#define QSPI_SAMPLE_SHIFTING_NONE   0u
+#define QSPI_CS_HIGH_TIME_2_CYCLE   (1u << 8)
+#define QSPI_CLOCK_MODE_0           0u
+
+#define POSITION_VAL(value)         (__builtin_ctz(value))
+
+struct GPIO_TypeDef;
+
+namespace recorder::qspi
+{
+
+enum RegisterID
+{
+    REG_CR, REG_DCR, REG_SR, REG_FCR, REG_DLR, REG_CCR, REG_AR, REG_DR,
+};
+
+uint32_t ReadRegister(RegisterID id);
+void WriteRegister(RegisterID id, uint32_t value);
+
+template <RegisterID id>
+struct Register
+{
+    operator uint32_t() const
+    {
+        return ReadRegister(id);
+    }
+
+    Register& operator=(uint32_t value)
+    {
+        WriteRegister(id, value);
+        return *this;
+    }
+
+    Register& operator|=(uint32_t value)
+    {
+        return *this = (uint32_t(*this) | value);
+    }
+
+    Register& operator&=(uint32_t value)
+    {
+        return *this = (uint32_t(*this) & value);
+    }
+};
+
+struct Registers
+{
+    Register<REG_CR> CR;
+    Register<REG_DCR> DCR;
+    Register<REG_SR> SR;
+    Register<REG_FCR> FCR;
+    Register<REG_DLR> DLR;
+    Register<REG_CCR> CCR;
+    Register<REG_AR> AR;
+    Register<REG_DR> DR;
+};
+
+inline Registers registers;
+
+}
+
+#define QUADSPI (&recorder::qspi::registers)
+
+namespace recorder::qspi
+{
+
+// One command as the flash saw it
+struct Command
+{
+    enum Mode {INDIRECT_WRITE, INDIRECT_READ, MEMORY_MAPPED};
+
+    uint8_t instruction;
+    Mode mode;
+    uint8_t address_lines;      // 0 when there's no address phase
+    uint8_t data_lines;         // 0 when there's no data phase
+    uint8_t dummy_cycles;
+    uint32_t address;
+    uint32_t length;            // Data bytes, as far as they were transferred
+};
+
+struct Counters
+{
+    uint32_t commands;
+    uint32_t aborts;
+    uint32_t reads8;            // CPU data register accesses
+    uint32_t reads32;
+    uint32_t writes8;
+    uint32_t writes32;
+    uint32_t dma_beats;
+    uint32_t mapped_reads;
+};
+
+class FakeQuadSPI
+{
+public:
+    static constexpr uint32_t kSize = 8 * 1024 * 1024;
+    static constexpr uint32_t kPageSize = 256;
+    static constexpr double kKernelClock_MHz = 64;
+    static constexpr double kAccessCycles = 6;
+
+    // Typical program and erase times
+    static constexpr double kPageProgram_us = 200;
+    static constexpr double kWriteStatus_us = 2000;
+    static constexpr double kSectorErase_us = 45000;
+    static constexpr double kBlock32Erase_us = 100000;
+    static constexpr double kBlock64Erase_us = 150000;
+    static constexpr double kChipErase_us = 10000000;
+
+    enum Status
+    {
+        STATUS_WIP = 0x01,
+        STATUS_WEL = 0x02,
+        STATUS_QE = 0x40,
+    };
+
+    std::vector<uint8_t> memory = std::vector<uint8_t>(kSize, 0xFF);
+    uint8_t status = 0;
+    bool powered_down = true;
+    double now_us = 0;
+    std::vector<Command> log;
+    std::vector<std::string> errors;
+    Counters counters = {};
+
+    // Clears the log, errors and counters, leaving the flash contents
+    void ClearLog(void)
+    {
+        log.clear();
+        errors.clear();
+        counters = {};
+    }
+
+    void Advance(double us)
+    {
+        now_us += us;
+    }
+
+    uint32_t Read(RegisterID id)
+    {
+        switch (id)
+        {
+            case REG_CR:  return cr_;
+            case REG_DCR: return dcr_;
+            case REG_DLR: return dlr_;
+            case REG_CCR: return ccr_;
+            case REG_AR:  return ar_;
+            case REG_SR:  return ReadSR();
+            case REG_DR:  return Pop(4);
+            default:      return 0;
+        }
+    }
+
+    void Write(RegisterID id, uint32_t value)
+    {
+        switch (id)
+        {
+            case REG_CR:
+                cr_ = value & ~QUADSPI_CR_ABORT;
+
+                if (value & QUADSPI_CR_ABORT)
+                {
+                    Abort();
+                }
+                break;
+
+            case REG_DCR:
+                dcr_ = value;
+                break;
+
+            case REG_FCR:
+                if (value & QUADSPI_FCR_CTCF)
+                {
+                    tcf_ = false;
+                }
+                break;
+
+            case REG_DLR:
+                if (busy())
+                {
+                    Error("DLR written while busy");
+                }
+                dlr_ = value;
+                break;
+
+            case REG_CCR:
+                WriteCCR(value);
+                break;
+
+            case REG_AR:
+                WriteAR(value);
+                break;
+
+            case REG_DR:
+                Push(value, 4);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    uint32_t Pop(uint32_t width)
+    {
+        Access();
+        counters.reads32 += (width == 4);
+        counters.reads8 += (width == 1);
+
+        if (!active_ || command_.mode != Command::INDIRECT_READ)
+        {
+            Error("data register read outside an indirect read");
+            return 0;
+        }
+
+        if (consumed_ + width > command_.length)
+        {
+            Error("data register read past the end of the transfer");
+            return 0;
+        }
+
+        uint32_t value = 0;
+
+        for (uint32_t i = 0; i < width; i++)
+        {
+            value |= uint32_t(data_[consumed_++]) << (8 * i);
+        }
+
+        now_us = std::max(now_us, ByteTime(consumed_));
+        Update();
+        return value;
+    }
+
+    void Push(uint32_t value, uint32_t width)
+    {
+        Access();
+        counters.writes32 += (width == 4);
+        counters.writes8 += (width == 1);
+
+        if (!active_ && waiting_ == WAIT_DATA)
+        {
+            Start();
+        }
+
+        if (!active_ || command_.mode != Command::INDIRECT_WRITE ||
+            !command_.data_lines)
+        {
+            Error("data register written outside an indirect write");
+            return;
+        }
+
+        for (uint32_t i = 0; i < width && data_.size() < command_.length; i++)
+        {
+            data_.push_back(value >> (8 * i));
+        }
+
+        if (data_.size() == command_.length)
+        {
+            now_us = std::max(now_us, ByteTime(command_.length));
+            Complete();
+        }
+    }
+
+    void StartReadDMA(void* dst, uint32_t length, uint32_t width)
+    {
+        if (width == 4 && ((reinterpret_cast<uintptr_t>(dst) & 3) || (length & 3)))
+        {
+            Error("unaligned word DMA");
+        }
+
+        dma_ = {dst, length, width, true};
+    }
+
+    // The MDMA fills the FIFO a beat at a time for a write that has already
+    // started. The CPU may write the rest.
+    void StartWriteDMA(const void* src, uint32_t length, uint32_t width)
+    {
+        if (width == 4 && ((reinterpret_cast<uintptr_t>(src) & 3) || (length & 3)))
+        {
+            Error("unaligned word DMA");
+        }
+
+        if (!active_ || command_.mode != Command::INDIRECT_WRITE ||
+            !command_.data_lines)
+        {
+            Error("write DMA started outside an indirect write");
+            return;
+        }
+
+        if (data_.size() + length > command_.length)
+        {
+            Error("write DMA longer than the write");
+            return;
+        }
+
+        auto bytes = reinterpret_cast<const uint8_t*>(src);
+        data_.insert(data_.end(), bytes, bytes + length);
+        now_us += (length / width) * kAccessCycles / kKernelClock_MHz;
+        counters.dma_beats += length / width;
+
+        if (data_.size() == command_.length)
+        {
+            now_us = std::max(now_us, ByteTime(command_.length));
+            Complete();
+        }
+    }
+
+    void FinishDMA(void)
+    {
+        if (dma_.armed)
+        {
+            Error("DMA finished before its read started");
+            dma_.armed = false;
+        }
+    }
+
+    uint32_t ReadMapped(uint32_t offset)
+    {
+        Access();
+        counters.mapped_reads++;
+
+        if (!active_ || command_.mode != Command::MEMORY_MAPPED)
+        {
+            Error("memory-mapped read outside memory-mapped mode");
+            return 0;
+        }
+
+        if (offset & 3 || offset + 4 > kSize)
+        {
+            Error("bad memory-mapped read");
+            return 0;
+        }
+
+        // A new access sequence unless it follows on from the last
+        if (offset != mapped_next_)
+        {
+            command_.address = offset;
+            command_.length = 0;
+            log.push_back(command_);
+            counters.commands++;
+            start_us_ = now_us;
+            mapped_next_ = offset;
+        }
+
+        command_.length += 4;
+        log.back().length += 4;
+        mapped_next_ += 4;
+        now_us = std::max(now_us, ByteTime(command_.length));
+
+        uint32_t value;
+        std::memcpy(&value, &memory[offset], 4);
+        return value;
+    }
+
+    bool mapped(void) const
+    {
+        return active_ && command_.mode == Command::MEMORY_MAPPED;
+    }
+
+protected:
+    enum Waiting
+    {
+        WAIT_NONE,
+        WAIT_ADDRESS,
+        WAIT_DATA,
+    };
+
+    struct DMA
+    {
+        void* dst;
+        uint32_t length;
+        uint32_t width;
+        bool armed;
+    };
+
+    uint32_t cr_ = 0;
+    uint32_t dcr_ = 0;
+    uint32_t dlr_ = 0;
+    uint32_t ccr_ = 0;
+    uint32_t ar_ = 0;
+    bool tcf_ = false;
+    bool active_ = false;
+    Waiting waiting_ = WAIT_NONE;
+    Command command_ = {};
+    std::vector<uint8_t> data_;
+    uint32_t consumed_ = 0;
+    double start_us_ = 0;
+    double end_us_ = 0;
+    uint8_t last_instruction_ = 0;
+    double busy_until_us_ = 0;
+    uint32_t mapped_next_ = 0;
+    DMA dma_ = {};
+
+    static uint32_t Lines(uint32_t mode)
+    {
+        return (mode == 3) ? 4 : mode;
+    }
+
+    double clock_MHz(void) const
+    {
+        return kKernelClock_MHz / ((cr_ >> QUADSPI_CR_PRESCALER_Pos) + 1);
+    }
+
+    void Access(void)
+    {
+        now_us += kAccessCycles / kKernelClock_MHz;
+    }
+
+    // When the bus has transferred `bytes` of the current command's data
+    double ByteTime(uint32_t bytes) const
+    {
+        double cycles = 8 + 2;  // Instruction and chip select high time
+
+        if (command_.address_lines)
+        {
+            cycles += 24 / command_.address_lines;
+        }
+
+        cycles += command_.dummy_cycles;
+
+        if (command_.data_lines)
+        {
+            cycles += bytes * double(8) / command_.data_lines;
+        }
+
+        return start_us_ + cycles / clock_MHz();
+    }
+
+    bool busy(void) const
+    {
+        return active_ || waiting_ != WAIT_NONE;
+    }
+
+    uint32_t ReadSR(void)
+    {
+        Access();
+        uint32_t sr = 0;
+
+        // BUSY stays set in memory-mapped mode until it's aborted, so the
+        // driver would wait forever
+        if (mapped())
+        {
+            std::fprintf(stderr, "QUADSPI status polled in memory-mapped mode\n");
+            std::exit(EXIT_FAILURE);
+        }
+
+        if (active_ && command_.mode == Command::INDIRECT_READ &&
+            consumed_ == command_.length && now_us >= end_us_)
+        {
+            Finish();
+        }
+
+        if (busy())
+        {
+            sr |= QUADSPI_SR_BUSY;
+        }
+
+        if (tcf_)
+        {
+            sr |= QUADSPI_SR_TCF;
+        }
+
+        if (active_ && command_.mode == Command::INDIRECT_READ)
+        {
+            if (now_us >= end_us_)
+            {
+                sr |= QUADSPI_SR_TCF;
+            }
+
+            // Bytes the bus has delivered that haven't been read yet
+            uint32_t arrived = consumed_;
+
+            while (arrived < command_.length && ByteTime(arrived + 1) <= now_us)
+            {
+                arrived++;
+            }
+
+            uint32_t level = std::min<uint32_t>(arrived - consumed_, 32);
+            uint32_t threshold = ((cr_ >> QUADSPI_CR_FTHRES_Pos) & 0x1F) + 1;
+            sr |= level << 8;
+
+            if (level >= threshold || (level && arrived == command_.length))
+            {
+                sr |= QUADSPI_SR_FTF;
+            }
+        }
+        else if (waiting_ == WAIT_DATA ||
+                 (active_ && command_.mode == Command::INDIRECT_WRITE))
+        {
+            sr |= QUADSPI_SR_FTF;
+        }
+
+        return sr;
+    }
+
+    void WriteCCR(uint32_t value)
+    {
+        if (busy())
+        {
+            Error("CCR written while busy");
+        }
+
+        ccr_ = value;
+        uint32_t fmode = (value >> 26) & 3;
+
+        command_ =
+        {
+            .instruction = uint8_t(value),
+            .mode = (fmode == 0) ? Command::INDIRECT_WRITE :
+                    (fmode == 1) ? Command::INDIRECT_READ :
+                    Command::MEMORY_MAPPED,
+            .address_lines = uint8_t(Lines((value >> 10) & 3)),
+            .data_lines = uint8_t(Lines((value >> 24) & 3)),
+            .dummy_cycles = uint8_t((value >> QUADSPI_CCR_DCYC_Pos) & 0x1F),
+            .address = 0,
+            .length = 0,
+        };
+
+        if (((value >> 8) & 3) != 1)
+        {
+            Error("instruction not on one line");
+        }
+
+        if (command_.address_lines && ((value >> 12) & 3) != 2)
+        {
+            Error("address not 24 bits");
+        }
+
+        if (fmode == 2)
+        {
+            Error("automatic polling mode isn't modelled");
+        }
+
+        if (command_.mode == Command::MEMORY_MAPPED)
+        {
+            Start();
+        }
+        else if (command_.address_lines)
+        {
+            waiting_ = WAIT_ADDRESS;
+        }
+        else if (command_.mode == Command::INDIRECT_WRITE && command_.data_lines)
+        {
+            waiting_ = WAIT_DATA;
+        }
+        else
+        {
+            Start();
+        }
+    }
+
+    void WriteAR(uint32_t value)
+    {
+        ar_ = value;
+
+        if (waiting_ != WAIT_ADDRESS)
+        {
+            Error("AR written with no command waiting for it");
+            return;
+        }
+
+        command_.address = value;
+        Start();
+    }
+
+    void Start(void)
+    {
+        waiting_ = WAIT_NONE;
+        active_ = true;
+        start_us_ = now_us;
+        data_.clear();
+        consumed_ = 0;
+        counters.commands++;
+        CheckCommand();
+
+        if (command_.mode == Command::MEMORY_MAPPED)
+        {
+            mapped_next_ = UINT32_MAX;
+            counters.commands--;    // Counted per access sequence
+            return;
+        }
+
+        bool has_data = command_.data_lines;
+        command_.length = has_data ? dlr_ + 1 : 0;
+
+        if (command_.mode == Command::INDIRECT_READ)
+        {
+            data_.resize(command_.length);
+            Respond();
+            end_us_ = ByteTime(command_.length);
+
+            if (dma_.armed)
+            {
+                RunDMA();
+            }
+        }
+        else if (!has_data)
+        {
+            now_us = std::max(now_us, ByteTime(0));
+            Complete();
+        }
+    }
+
+    // The MDMA empties the FIFO a beat at a time as the bus fills it
+    void RunDMA(void)
+    {
+        dma_.armed = false;
+
+        if (dma_.length != command_.length)
+        {
+            Error("DMA length doesn't match the read");
+            return;
+        }
+
+        auto dst = reinterpret_cast<uint8_t*>(dma_.dst);
+
+        for (uint32_t i = 0; i < dma_.length; i += dma_.width)
+        {
+            now_us += kAccessCycles / kKernelClock_MHz;
+            now_us = std::max(now_us, ByteTime(i + dma_.width));
+            counters.dma_beats++;
+        }
+
+        std::memcpy(dst, data_.data(), dma_.length);
+        consumed_ = dma_.length;
+        Update();
+    }
+
+    void Complete(void)
+    {
+        Execute();
+        Finish();
+    }
+
+    void Finish(void)
+    {
+        if (active_)
+        {
+            log.push_back(command_);
+        }
+
+        active_ = false;
+        tcf_ = true;
+        last_instruction_ = command_.instruction;
+    }
+
+    void Abort(void)
+    {
+        counters.aborts++;
+        active_ = false;
+        waiting_ = WAIT_NONE;
+        dma_.armed = false;
+    }
+
+    void Error(const std::string &message)
+    {
+        char prefix[32];
+        std::snprintf(prefix, sizeof(prefix), "0x%02X: ", command_.instruction);
+        errors.push_back(prefix + message);
+    }
+
+    bool write_in_progress(void)
+    {
+        if ((status & STATUS_WIP) && now_us >= busy_until_us_)
+        {
+            status &= ~(STATUS_WIP | STATUS_WEL);
+        }
+
+        return status & STATUS_WIP;
+    }
+
+    void Expect(bool condition, const char *message)
+    {
+        if (!condition)
+        {
+            Error(message);
+        }
+    }
+
+    // Checks the command's form and the state of the flash as it starts
+    void CheckCommand(void)
+    {
+        uint8_t instruction = command_.instruction;
+        const Command &c = command_;
+
+        if (powered_down && instruction != 0xAB)
+        {
+            Error("command while powered down");
+        }
+
+        if (write_in_progress() && instruction != 0x05)
+        {
+            Error("command while a write is in progress");
+        }
+
+        switch (instruction)
+        {
+            case 0x6B:
+                Expect(status & STATUS_QE, "quad read without QE set");
+                Expect(c.address_lines == 1 && c.data_lines == 4 &&
+                    c.dummy_cycles == 8, "quad read needs 1-1-4 with 8 dummy cycles");
+                Expect(c.mode != Command::INDIRECT_WRITE, "quad read as a write");
+                break;
+
+            case 0x0B:
+                Expect(c.address_lines == 1 && c.data_lines == 1 &&
+                    c.dummy_cycles == 8, "fast read needs 1-1-1 with 8 dummy cycles");
+                break;
+
+            case 0x03:
+                Expect(c.address_lines == 1 && c.data_lines == 1 &&
+                    c.dummy_cycles == 0, "read needs 1-1-1 with no dummy cycles");
+                break;
+
+            case 0x05:
+                Expect(c.mode == Command::INDIRECT_READ && c.data_lines == 1 &&
+                    !c.address_lines, "bad read status");
+                break;
+
+            case 0x02:
+            case 0x32:
+                Expect(c.mode == Command::INDIRECT_WRITE && c.address_lines == 1,
+                    "bad page program");
+                Expect(c.data_lines == ((instruction == 0x32) ? 4 : 1),
+                    "page program on the wrong number of lines");
+                Expect(instruction != 0x32 || (status & STATUS_QE),
+                    "quad page program without QE set");
+                Expect(status & STATUS_WEL, "page program without write enable");
+                break;
+
+            case 0x01:
+                Expect(c.mode == Command::INDIRECT_WRITE && c.data_lines == 1 &&
+                    !c.address_lines, "bad write status");
+                Expect(status & STATUS_WEL, "write status without write enable");
+                break;
+
+            case 0x20:
+            case 0xD7:
+            case 0x52:
+            case 0xD8:
+                Expect(c.mode == Command::INDIRECT_WRITE && c.address_lines == 1 &&
+                    !c.data_lines, "bad erase");
+                Expect(status & STATUS_WEL, "erase without write enable");
+                break;
+
+            case 0xC7:
+                Expect(status & STATUS_WEL, "chip erase without write enable");
+                break;
+
+            case 0x99:
+                Expect(last_instruction_ == 0x66, "reset without reset enable");
+                break;
+
+            case 0x06:
+            case 0x66:
+            case 0xAB:
+            case 0xB9:
+                Expect(!c.address_lines && !c.data_lines, "bad command");
+                break;
+
+            default:
+                Error("unexpected instruction");
+                break;
+        }
+
+        if (c.mode == Command::MEMORY_MAPPED)
+        {
+            Expect(instruction == 0x6B, "memory-mapped mode without quad read");
+        }
+    }
+
+    // Fills the data a read command returns
+    void Respond(void)
+    {
+        if (command_.instruction == 0x05)
+        {
+            write_in_progress();
+            std::fill(data_.begin(), data_.end(), status);
+        }
+        else if (command_.address + command_.length > kSize)
+        {
+            Error("read past the end of the flash");
+        }
+        else
+        {
+            std::copy_n(&memory[command_.address], command_.length, data_.begin());
+        }
+    }
+
+    // Carries out a write command once its data is in
+    void Execute(void)
+    {
+        uint32_t address = command_.address;
+        bool enabled = status & STATUS_WEL;
+
+        switch (command_.instruction)
+        {
+            case 0x06:
+                status |= STATUS_WEL;
+                return;
+
+            case 0xAB:
+                powered_down = false;
+                return;
+
+            case 0xB9:
+                powered_down = true;
+                return;
+
+            case 0x99:
+                status &= ~STATUS_WEL;
+                return;
+
+            case 0x01:
+                if (enabled && !data_.empty())
+                {
+                    status = (status & STATUS_WEL) | (data_[0] & 0xFC);
+                    Busy(kWriteStatus_us);
+                }
+                return;
+
+            case 0x02:
+            case 0x32:
+                if (address % kPageSize + command_.length > kPageSize)
+                {
+                    Error("page program crosses a page");
+                }
+                else if (enabled)
+                {
+                    for (uint32_t i = 0; i < command_.length; i++)
+                    {
+                        memory[address + i] &= data_[i];
+                    }
+
+                    Busy(kPageProgram_us);
+                }
+                return;
+
+            case 0x20:
+            case 0xD7:
+                Erase(address, 4096, kSectorErase_us, enabled);
+                return;
+
+            case 0x52:
+                Erase(address, 32768, kBlock32Erase_us, enabled);
+                return;
+
+            case 0xD8:
+                Erase(address, 65536, kBlock64Erase_us, enabled);
+                return;
+
+            case 0xC7:
+                Erase(0, kSize, kChipErase_us, enabled);
+                return;
+
+            default:
+                return;
+        }
+    }
+
+    void Erase(uint32_t address, uint32_t size, double time_us, bool enabled)
+    {
+        if (address % size)
+        {
+            Error("unaligned erase");
+        }
+        else if (enabled)
+        {
+            std::fill_n(&memory[address], size, 0xFF);
+            Busy(time_us);
+        }
+    }
+
+    void Busy(double time_us)
+    {
+        status |= STATUS_WIP;
+        busy_until_us_ = now_us + time_us;
+    }
+
+    void Update(void)
+    {
+        if (consumed_ == command_.length && now_us >= end_us_)
+        {
+            Finish();
+        }
+    }
+};
+
+inline FakeQuadSPI fake;
+
+inline uint32_t ReadRegister(RegisterID id)
+{
+    return fake.Read(id);
+}
+
+inline void WriteRegister(RegisterID id, uint32_t value)
+{
+    fake.Write(id, value);
+}
+
+inline uint8_t Read8(void)
+{
+    return fake.Pop(1);
+}
+
+inline uint32_t Read32(void)
+{
+    return fake.Pop(4);
+}
+
+inline void Write8(uint8_t byte)
+{
+    fake.Push(byte, 1);
+}
+
+inline void Write32(uint32_t word)
+{
+    fake.Push(word, 4);
+}
+
+inline uint32_t ReadMapped32(uint32_t offset)
+{
+    return fake.ReadMapped(offset);
+}
+
+inline void StartReadDMA(void* dst, uint32_t length, uint32_t width)
+{
+    fake.StartReadDMA(dst, length, width);
+}
+
+inline void StartWriteDMA(const void* src, uint32_t length, uint32_t width)
+{
+    fake.StartWriteDMA(src, length, width);
+}
+
+inline void FinishDMA(void)
+{
+    fake.FinishDMA();
+}
+
+}
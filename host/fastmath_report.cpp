@@ -0,0 +1,149 @@
+// Checks the approximations in util/fastmath.h against the error bounds
+// their comments state, measured against double-precision libm.
+//
+//     make fastmath_report
+//     build/<variant>/artifact/fastmath_report
+//
+// Each domain is swept through its floats in order, every one of them where
+// there are few enough and evenly spaced ones otherwise, so every exponent
+// in the domain is covered. The largest error over each domain has to stay
+// within the stated bound.
+
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <numbers>
+
+#include "util/fastmath.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr uint32_t kMaxPoints = 1 << 24;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Floats as integers that order the same way, so stepping the integer steps
+// through consecutive floats
+int64_t Key(float x)
+{
+    int32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits < 0) ? -int64_t(bits & 0x7FFFFFFF) : bits;
+}
+
+float FromKey(int64_t key)
+{
+    int32_t bits = (key < 0) ? int32_t(-key) | INT32_MIN : int32_t(key);
+    float x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+enum Error
+{
+    ABSOLUTE,
+    RELATIVE,
+};
+
+struct Bound
+{
+    const char *name;
+    float lowest;
+    float highest;
+    Error error;
+    double bound;
+    std::function<float(float)> approximation;
+    std::function<double(double)> reference;
+};
+
+const Bound kBounds[] =
+{
+    {"Sin, |x| <= 2 pi", -2 * std::numbers::pi_v<float>,
+        2 * std::numbers::pi_v<float>, ABSOLUTE, 1.5e-6,
+        fastmath::Sin, [](double x) { return std::sin(x); }},
+    {"Sin, |x| <= 1000", -1000, 1000, ABSOLUTE, 1.1e-4,
+        fastmath::Sin, [](double x) { return std::sin(x); }},
+    {"Cos, |x| <= 2 pi", -2 * std::numbers::pi_v<float>,
+        2 * std::numbers::pi_v<float>, ABSOLUTE, 1.5e-6,
+        fastmath::Cos, [](double x) { return std::cos(x); }},
+    {"Exp2", -126, 127.99f, RELATIVE, 2.3e-7,
+        fastmath::Exp2, [](double x) { return std::exp2(x); }},
+    {"Log2, [2^-24, 2^8]", 0x1p-24f, 0x1p8f, ABSOLUTE, 3.2e-6,
+        fastmath::Log2, [](double x) { return std::log2(x); }},
+    {"Log2, normal", 0x1p-126f, 0x1.fffffep127f, ABSOLUTE, 6e-6,
+        fastmath::Log2, [](double x) { return std::log2(x); }},
+    {"DbToGain, [-120, 24]", -120, 24, RELATIVE, 1e-6,
+        fastmath::DbToGain, [](double x) { return std::pow(10, x / 20); }},
+    {"DbToGain, [-758, 770]", -758, 770, RELATIVE, 3.2e-6,
+        fastmath::DbToGain, [](double x) { return std::pow(10, x / 20); }},
+    {"GainToDb", 0x1p-24f, 0x1p8f, ABSOLUTE, 3e-5,
+        fastmath::GainToDb, [](double x) { return 20 * std::log10(x); }},
+};
+
+double MaxError(const Bound &bound)
+{
+    int64_t first = Key(bound.lowest);
+    int64_t last = Key(bound.highest);
+    int64_t step = std::max<int64_t>(1, (last - first) / kMaxPoints);
+    double worst = 0;
+
+    for (int64_t key = first; key <= last; key += step)
+    {
+        float x = FromKey(key);
+        double exact = bound.reference(double(x));
+        double error = std::fabs(double(bound.approximation(x)) - exact);
+
+        if (bound.error == RELATIVE)
+        {
+            error /= std::fabs(exact);
+        }
+
+        worst = std::max(worst, error);
+    }
+
+    return worst;
+}
+
+}
+
+int main(void)
+{
+    std::printf("%-24s %8s %10s %10s\n", "function", "error", "max", "bound");
+
+    for (const Bound &bound : kBounds)
+    {
+        double worst = MaxError(bound);
+        std::printf("%-24s %8s %10.2e %10.2e\n", bound.name,
+            (bound.error == RELATIVE) ? "relative" : "absolute", worst,
+            bound.bound);
+        Check(worst <= bound.bound, bound.name);
+    }
+
+    // Outside the domains, as the comments describe them
+    float log2_zero = fastmath::Log2(0);
+    float exp2_high = fastmath::Exp2(1000);
+    std::printf("\nLog2(0) = %g, Exp2(1000) = %g\n", double(log2_zero),
+        double(exp2_high));
+    Check(log2_zero == -127, "Log2(0)");
+    Check(fastmath::GainToDb(0) > -766, "GainToDb(0)");
+    Check(std::isfinite(exp2_high), "Exp2 clamps");
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
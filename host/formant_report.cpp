@@ -0,0 +1,381 @@
+// Checks the formant path's shortcuts against the exact computation they
+// stand in for.
+//
+//     make formant_report
+//     build/<variant>/artifact/formant_report
+//
+// Control rate: FormantFilter with its coefficients ramped over
+// kFormantControlPeriod samples is run beside the per-sample path over the
+// same noise, through wah sweeps and vowel changes. The short-time spectra
+// of the two outputs are compared frame by frame, as the RMS difference in
+// dB over the bins within kFloor_dB of the frame's peak, and the worst frame
+// has to stay within kMaxDeviation_dB.
+//
+// Coefficient table: FormantTable::Lookup() is compared with the exact RBJ
+// design at random points between the grid's, over the whole grid and over
+// the formants SynthEngine asks for, reporting the largest and RMS
+// coefficient errors. The largest has to stay within
+// kFormantTableTolerance. Noise is also filtered through every formant of
+// every vowel at the ends of SynthEngine's frequency range, designed both
+// ways, and the SNR of the table's output against the exact design's has to
+// stay above kMinTableSNR_dB.
+
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <numbers>
+#include <vector>
+
+#include "common/config.h"
+#include "util/random.h"
+#include "app/engine/formant_filter.h"
+#include "app/engine/formant_table.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr size_t kFrameSize = 512;
+constexpr size_t kHopSize = 256;
+constexpr double kFloor_dB = 50;
+constexpr double kLowest_Hz = 100;
+constexpr double kHighest_Hz = 7000;
+constexpr double kMaxDeviation_dB = 1;
+constexpr uint32_t kTablePoints = 100000;
+constexpr size_t kTableRenderLength = 16000;
+constexpr double kMinTableSNR_dB = 40;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Power spectra of Hann-windowed frames, up to Nyquist
+class Spectrogram
+{
+public:
+    Spectrogram()
+    {
+        for (size_t n = 0; n < kFrameSize; n++)
+        {
+            double phase = 2 * std::numbers::pi * double(n) / kFrameSize;
+            window_[n] = double(0.5) - double(0.5) * std::cos(phase);
+            twiddle_[n] = std::polar(double(1), -phase);
+        }
+    }
+
+    std::vector<std::vector<double>> operator()(const std::vector<float> &x) const
+    {
+        std::vector<std::vector<double>> frames;
+
+        for (size_t start = 0; start + kFrameSize <= x.size(); start += kHopSize)
+        {
+            std::vector<double> power(kFrameSize / 2 + 1);
+
+            for (size_t k = 0; k < power.size(); k++)
+            {
+                std::complex<double> sum = 0;
+
+                for (size_t n = 0; n < kFrameSize; n++)
+                {
+                    sum += window_[n] * double(x[start + n]) *
+                        twiddle_[n * k % kFrameSize];
+                }
+
+                power[k] = std::norm(sum);
+            }
+
+            frames.push_back(power);
+        }
+
+        return frames;
+    }
+
+protected:
+    double window_[kFrameSize];
+    std::complex<double> twiddle_[kFrameSize];
+};
+
+// The worst and mean over frames of the RMS difference in dB
+struct Deviation
+{
+    double max_dB;
+    double mean_dB;
+};
+
+Deviation Compare(const std::vector<float> &reference,
+    const std::vector<float> &test)
+{
+    static const Spectrogram spectrogram;
+    auto a = spectrogram(reference);
+    auto b = spectrogram(test);
+    size_t lowest = kLowest_Hz * kFrameSize / kAudioSampleRateHz;
+    size_t highest = kHighest_Hz * kFrameSize / kAudioSampleRateHz;
+    Deviation deviation = {0, 0};
+
+    for (size_t f = 0; f < a.size(); f++)
+    {
+        double peak = *std::max_element(a[f].begin(), a[f].end());
+        double floor = peak * std::pow(10, -kFloor_dB / 10);
+        double sum = 0;
+        size_t bins = 0;
+
+        for (size_t k = lowest; k <= highest; k++)
+        {
+            if (a[f][k] > floor)
+            {
+                double d = 10 * std::log10(b[f][k] / a[f][k]);
+                sum += d * d;
+                bins++;
+            }
+        }
+
+        double rms = bins ? std::sqrt(sum / double(bins)) : 0;
+        deviation.max_dB = std::max(deviation.max_dB, rms);
+        deviation.mean_dB += rms / double(a.size());
+    }
+
+    return deviation;
+}
+
+// Moves the filter's controls for sample n of a scenario
+using Controls = std::function<void(FormantFilter &filter, size_t n)>;
+
+struct Scenario
+{
+    const char *name;
+    float rate;
+    size_t length;
+    Controls controls;
+};
+
+// A triangle from 0 to 1 and back every `period` samples
+float Triangle(size_t n, size_t period)
+{
+    float phase = float(n % period) / period;
+    return (phase < 0.5f) ? 2 * phase : 2 - 2 * phase;
+}
+
+const Scenario kScenarios[] =
+{
+    {"wah, slow", 0.005f, 32000, [](FormantFilter &filter, size_t n)
+    {
+        filter.SetMode(FormantFilter::FILTER_MODE_WAH);
+        filter.SetWahPosition(Triangle(n, 16000));
+    }},
+    {"wah, fast", 0.005f, 32000, [](FormantFilter &filter, size_t n)
+    {
+        filter.SetMode(FormantFilter::FILTER_MODE_WAH);
+        filter.SetWahPosition(Triangle(n, 2000));
+    }},
+    {"vowel steps", 0.005f, 32000, [](FormantFilter &filter, size_t n)
+    {
+        static const FormantFilter::Vowel kVowels[] =
+        {
+            FormantFilter::VOWEL_I, FormantFilter::VOWEL_E,
+            FormantFilter::VOWEL_A, FormantFilter::VOWEL_O,
+            FormantFilter::VOWEL_U, FormantFilter::VOWEL_OU,
+        };
+
+        filter.SetVowel(kVowels[n / 4000 % 6]);
+    }},
+    {"vowel steps, glide", 0.002f, 32000, [](FormantFilter &filter, size_t n)
+    {
+        filter.SetVowel((n / 8000 % 2) ? FormantFilter::VOWEL_I :
+            FormantFilter::VOWEL_U);
+        filter.setFreqMult(0.7f + 1.3f * Triangle(n, 32000));
+    }},
+};
+
+std::vector<float> Render(const Scenario &scenario, uint32_t period)
+{
+    FormantFilter filter;
+    filter.Init(kAudioSampleRate);
+    filter.SetControlPeriod(period);
+    filter.SetFormantRate(scenario.rate);
+
+    Random random;
+    std::vector<float> out(scenario.length);
+
+    for (size_t n = 0; n < out.size(); n++)
+    {
+        scenario.controls(filter, n);
+        filter.UpdateParameters();
+        out[n] = filter.Process(0.5f * random.NextBipolar());
+    }
+
+    return out;
+}
+
+void CheckControlRate(void)
+{
+    std::printf("Control period %u against 1, spectral deviation in dB\n",
+        kFormantControlPeriod);
+    std::printf("%-20s %8s %8s\n", "scenario", "max", "mean");
+
+    for (const Scenario &scenario : kScenarios)
+    {
+        Deviation deviation = Compare(Render(scenario, 1),
+            Render(scenario, kFormantControlPeriod));
+        std::printf("%-20s %8.3f %8.3f\n", scenario.name, deviation.max_dB,
+            deviation.mean_dB);
+        Check(deviation.max_dB < kMaxDeviation_dB, scenario.name);
+    }
+}
+
+struct TableError
+{
+    double max;
+    double sum_squares;
+    uint32_t count;
+
+    void Add(const FormantTable::Coefficients &table,
+        const FormantTable::Coefficients &exact)
+    {
+        for (double e : {double(table.b0 - exact.b0),
+            double(table.a1 - exact.a1), double(table.a2 - exact.a2)})
+        {
+            max = std::max(max, std::fabs(e));
+            sum_squares += e * e;
+            count++;
+        }
+    }
+
+    double rms(void) const
+    {
+        return std::sqrt(sum_squares / count);
+    }
+};
+
+FormantTable::Coefficients Exact(float frequency, float Q)
+{
+    return FormantTable::Exact(std::log2(double(frequency)), 1 / double(Q));
+}
+
+// SynthEngine's range of formant frequency multipliers, and its Q multiplier
+constexpr float kMinFreqMult = 0.7f;
+constexpr float kMaxFreqMult = 2.0f;
+constexpr float kQMult = 1.3f;
+
+// The SNR of noise through the table's bandpass against the exact one's
+double RenderSNR(const FormantTable::Coefficients &table,
+    const FormantTable::Coefficients &exact)
+{
+    const FormantTable::Coefficients *coefficients[2] = {&table, &exact};
+    double y[2][2] = {};
+    double x1 = 0, x2 = 0;
+    double signal = 0, noise = 0;
+    Random random;
+
+    for (size_t n = 0; n < kTableRenderLength; n++)
+    {
+        double x = random.NextBipolar();
+        double out[2];
+
+        for (int k = 0; k < 2; k++)
+        {
+            const FormantTable::Coefficients &c = *coefficients[k];
+            out[k] = double(c.b0) * (x - x2) - double(c.a1) * y[k][0] -
+                double(c.a2) * y[k][1];
+            y[k][1] = y[k][0];
+            y[k][0] = out[k];
+        }
+
+        x2 = x1;
+        x1 = x;
+        signal += out[1] * out[1];
+        noise += (out[0] - out[1]) * (out[0] - out[1]);
+    }
+
+    return 10 * std::log10(signal / noise);
+}
+
+void CheckTable(void)
+{
+    std::printf("\nFormant table, %u x %u, against the exact design\n",
+        FormantTable::kFreqSize, FormantTable::kQSize);
+    std::printf("%-20s %10s %10s\n", "points", "max", "rms");
+
+    Random random;
+    TableError grid = {};
+    TableError formants = {};
+
+    for (uint32_t n = 0; n < kTablePoints; n++)
+    {
+        // Anywhere on the grid short of Nyquist
+        float log2_freq = FormantTable::kMinLog2Freq + random.NextFloat() *
+            (FormantTable::kMaxLog2Freq - 0.05f - FormantTable::kMinLog2Freq);
+        float inv_Q = FormantTable::kMinInvQ + random.NextFloat() *
+            (FormantTable::kMaxInvQ - FormantTable::kMinInvQ);
+        float frequency = std::exp2(log2_freq);
+        grid.Add(FormantTable::Lookup(frequency, 1 / inv_Q),
+            FormantTable::Exact(log2_freq, inv_Q));
+
+        // A formant of a vowel, scaled as SynthEngine scales them
+        const auto &vowel = FormantFilter::vowelData[0][random.NextBelow(6)];
+        uint32_t i = random.NextBelow(3);
+        float mult = kMinFreqMult + random.NextFloat() *
+            (kMaxFreqMult - kMinFreqMult);
+        float Q = (&vowel.Q1)[i] * kQMult;
+        frequency = (&vowel.F1)[i] * mult / kAudioSampleRate;
+
+        if (frequency < 0.45f)
+        {
+            formants.Add(FormantTable::Lookup(frequency, Q),
+                Exact(frequency, Q));
+        }
+    }
+
+    std::printf("%-20s %10.2e %10.2e\n", "whole grid", grid.max, grid.rms());
+    std::printf("%-20s %10.2e %10.2e\n", "formants", formants.max,
+        formants.rms());
+    Check(grid.max < double(kFormantTableTolerance), "table tolerance");
+
+    double worst_snr = 1000;
+
+    for (uint32_t v = FormantFilter::VOWEL_I; v <= FormantFilter::VOWEL_OU; v++)
+    {
+        const auto &vowel = FormantFilter::vowelData[0][v];
+
+        for (float mult : {kMinFreqMult, 1.f, kMaxFreqMult})
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                float frequency = (&vowel.F1)[i] * mult / kAudioSampleRate;
+                float Q = (&vowel.Q1)[i] * kQMult;
+
+                if (frequency < 0.45f)
+                {
+                    worst_snr = std::min(worst_snr, RenderSNR(
+                        FormantTable::Lookup(frequency, Q),
+                        Exact(frequency, Q)));
+                }
+            }
+        }
+    }
+
+    std::printf("%-20s %10.1f dB\n", "worst render SNR", worst_snr);
+    Check(worst_snr > kMinTableSNR_dB, "table render SNR");
+}
+
+}
+
+int main(void)
+{
+    CheckControlRate();
+    CheckTable();
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
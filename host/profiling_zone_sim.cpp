@@ -0,0 +1,123 @@
+// Drives profiling::Zones and ScopedProfilingZone with a fake clock and
+// checks the count, min, max and mean each zone keeps.
+//
+//     make profiling_zone_sim
+//     build/<variant>/artifact/profiling_zone_sim
+//
+// The clock only moves when the simulation moves it, so every zone's length
+// is known exactly, including across the 32-bit wrap.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+
+#include "common/config.h"
+#include "drivers/profiling_zone.h"
+
+using namespace recorder;
+
+namespace
+{
+
+class FakeClock
+{
+public:
+    static inline uint32_t now = 0;
+
+    static void Init(void) {}
+
+    static uint32_t Now(void)
+    {
+        return now;
+    }
+};
+
+using Zones = profiling::Zones<FakeClock>;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Runs one zone `ticks` long
+template <Profile profile>
+void Run(uint32_t ticks)
+{
+    ScopedProfilingZone<profile, FakeClock> zone;
+    FakeClock::now += ticks;
+}
+
+void CheckStats(const char *what, Profile profile, uint32_t count,
+    uint32_t min, uint32_t max, uint32_t mean)
+{
+    const profiling::ZoneStats &stats = Zones::stats(profile);
+    std::printf("%-24s count %u min %u max %u mean %u\n", what, stats.count,
+        stats.min, stats.max, stats.mean());
+    Check(stats.count == count && stats.min == min && stats.max == max &&
+        stats.mean() == mean, what);
+}
+
+}
+
+int main(void)
+{
+    Zones::Init();
+    CheckStats("after init", PROFILE_PROCESS, 0, UINT32_MAX, 0, 0);
+
+    if (!kEnableProfilingZones)
+    {
+        // The zones compile to nothing, so nothing is recorded
+        Run<PROFILE_PROCESS>(10);
+        CheckStats("disabled", PROFILE_PROCESS, 0, UINT32_MAX, 0, 0);
+        std::printf("%u failed\n", failures);
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    for (uint32_t ticks : {5, 1, 100, 30})
+    {
+        FakeClock::now += 7;    // Time between zones isn't counted
+        Run<PROFILE_PROCESS>(ticks);
+    }
+
+    CheckStats("four zones", PROFILE_PROCESS, 4, 1, 100, 34);
+    CheckStats("other zones untouched", PROFILE_TICK, 0, UINT32_MAX, 0, 0);
+
+    // The mean rounds down
+    Run<PROFILE_TICK>(1);
+    Run<PROFILE_TICK>(2);
+    CheckStats("mean rounds down", PROFILE_TICK, 2, 1, 2, 1);
+
+    // A zone spanning the wrap is timed by the unsigned difference
+    Zones::Reset();
+    FakeClock::now = UINT32_MAX - 15;
+    Run<PROFILE_PROCESS>(40);
+    CheckStats("across the wrap", PROFILE_PROCESS, 1, 40, 40, 40);
+
+    // The total outgrows 32 bits long before the count does
+    Zones::Reset();
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        Run<PROFILE_PROCESS>(0xF0000000);
+    }
+
+    CheckStats("64-bit total", PROFILE_PROCESS, 3, 0xF0000000, 0xF0000000,
+        0xF0000000);
+
+    // Zones::Add() is what the scoped zone uses, and can be called directly
+    Zones::Reset();
+    Zones::Add(PROFILE_SLEEP, 12);
+    Zones::Add(PROFILE_SLEEP, 4);
+    CheckStats("Add()", PROFILE_SLEEP, 2, 4, 12, 8);
+    CheckStats("reset", PROFILE_PROCESS, 0, UINT32_MAX, 0, 0);
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
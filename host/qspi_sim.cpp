@@ -0,0 +1,722 @@
+// Runs the Flash driver against a register-level fake of the QUADSPI
+// peripheral (host/fake/drivers/qspi.h). Checks the command sequences for
+// init, program, erase, indirect reads and memory-mapped reads, checks the
+// data that comes back, and reports simulated throughput for the boot-time
+// load of a recording and for blank checks. Then EraseAhead erases a range
+// the way the main loop would service it, and SampleMemory saves full
+// recordings with and without their space erased ahead, reporting the time
+// from the end of each recording to its save being committed. Last, a fresh
+// SampleMemory boots on what was saved and plays it back through
+// CodedMemory and SamplePlayer, streamed from flash when
+// kEnableFlashStreaming is set and loaded into RAM otherwise.
+//
+//     make qspi_sim
+//
+// Times come from the fake's model of the bus and of data register accesses,
+// not from the host; they compare the read paths rather than predict the
+// device exactly.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "drivers/flash.h"
+#include "drivers/sample_memory.h"
+#include "util/random.h"
+#include "app/engine/sample_codec.h"
+#include "app/engine/coded_memory.h"
+#include "app/engine/sample_player.h"
+
+using namespace recorder;
+
+namespace recorder
+{
+
+void Flash::InitPeripheral(void)
+{
+}
+
+namespace system
+{
+
+void Delay_ms(uint32_t ms)
+{
+    qspi::fake.Advance(ms * 1000);
+}
+
+uint32_t Uptime_ms(void)
+{
+    return qspi::fake.now_us / 1000;
+}
+
+void ReloadWatchdog(void)
+{
+}
+
+}
+
+}
+
+namespace
+{
+
+using qspi::fake;
+using qspi::Command;
+
+// The device's sample memory
+constexpr uint32_t kLoadSize = (512 + 288 + 63) * 1024;
+constexpr uint32_t kLoadChunk = 16 * 1024;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+void CheckErrors(const char *what)
+{
+    for (const std::string &error : fake.errors)
+    {
+        std::printf("  FAIL: %s: %s\n", what, error.c_str());
+        failures++;
+    }
+
+    fake.errors.clear();
+}
+
+std::vector<uint8_t> Instructions(void)
+{
+    std::vector<uint8_t> instructions;
+
+    for (const Command &command : fake.log)
+    {
+        // Status polls vary with timing, so only the first of a run counts
+        if (command.instruction == 0x05 && !instructions.empty() &&
+            instructions.back() == 0x05)
+        {
+            continue;
+        }
+
+        instructions.push_back(command.instruction);
+    }
+
+    return instructions;
+}
+
+std::string Format(const std::vector<uint8_t> &instructions)
+{
+    std::string text;
+
+    for (uint8_t instruction : instructions)
+    {
+        char hex[8];
+        std::snprintf(hex, sizeof(hex), "%s%02X", text.empty() ? "" : " ",
+            instruction);
+        text += hex;
+    }
+
+    return text;
+}
+
+void CheckSequence(const char *what, const std::vector<uint8_t> &expected)
+{
+    std::vector<uint8_t> actual = Instructions();
+    bool match = (actual == expected);
+    std::printf("  %-24s %s%s\n", what, Format(actual).c_str(),
+        match ? "" : "  (unexpected)");
+    Check(match, what);
+    CheckErrors(what);
+    fake.ClearLog();
+}
+
+// Every indirect or memory-mapped read is a 1-1-4 quad output read
+void CheckReads(const char *what)
+{
+    for (const Command &command : fake.log)
+    {
+        if (command.mode != Command::INDIRECT_WRITE &&
+            command.instruction != 0x05)
+        {
+            Check(command.instruction == 0x6B && command.data_lines == 4 &&
+                command.dummy_cycles == 8, what);
+        }
+    }
+}
+
+void TestSequences(Flash &flash)
+{
+    std::printf("Command sequences:\n");
+
+    flash.Init();
+    CheckSequence("init, blank status", {0xAB, 0x66, 0x99, 0x05, 0x06, 0x01, 0x05});
+    Check(fake.status & 0x40, "QE set by init");
+
+    flash.Init();
+    CheckSequence("init, QE already set", {0xAB, 0x66, 0x99, 0x05});
+
+    const uint32_t base = 0x10000;
+    flash.Erase(base, Flash::kEraseGranularity);
+    CheckSequence("sector erase", {0x05, 0x06, 0xD7});
+
+    std::vector<uint8_t> data(4096);
+    Random random;
+
+    for (uint8_t &byte : data)
+    {
+        byte = random.Next();
+    }
+
+    // Starts mid-page so the first and last programs are partial
+    flash.Write(base + 100, data.data(), 600);
+    CheckSequence("program 600 bytes", {0x05, 0x06, 0x32, 0x05, 0x06, 0x32,
+        0x05, 0x06, 0x32});
+    Check(!std::memcmp(&fake.memory[base + 100], data.data(), 600),
+        "programmed data");
+
+    struct
+    {
+        const char *name;
+        uint32_t offset;    // Into the data, for alignment
+        uint32_t address;
+        uint32_t length;
+    }
+    programs[] =
+    {
+        {"word MDMA program", 0, base + 2048, 130},    // Words, then 2 bytes
+        {"byte MDMA program", 1, base + 2304, 200},
+        {"polled program", 0, base + 2560, 23},
+    };
+
+    for (auto &program : programs)
+    {
+        flash.Write(program.address, &data[program.offset], program.length);
+        Check(!std::memcmp(&fake.memory[program.address], &data[program.offset],
+            program.length), program.name);
+        Check((fake.counters.dma_beats > 0) == (program.length >= 64),
+            "only short programs are polled");
+        CheckSequence(program.name, {0x05, 0x06, 0x32});
+    }
+
+    std::vector<uint8_t> buffer(1024 + 4);
+    struct
+    {
+        const char *name;
+        uint32_t offset;    // Into the buffer, for alignment
+        uint32_t length;
+        uint32_t commands;
+    }
+    reads[] =
+    {
+        {"word MDMA read", 0, 512, 1},
+        {"byte MDMA read", 1, 512, 1},
+        {"odd length read", 0, 301, 2},     // Words, then the last byte
+        {"polled read", 0, 23, 1},
+        {"polled word read", 0, 32, 1},
+    };
+
+    for (auto &read : reads)
+    {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        flash.Read(&buffer[read.offset], base + 100, read.length);
+        Check(!std::memcmp(&buffer[read.offset], data.data(), read.length),
+            read.name);
+        CheckReads(read.name);
+        Check((fake.counters.dma_beats > 0) == (read.length >= 64),
+            "only short reads are polled");
+        std::vector<uint8_t> expected = {0x05};
+
+        for (uint32_t i = 0; i < read.commands; i++)
+        {
+            expected.push_back(0x6B);
+        }
+
+        CheckSequence(read.name, expected);
+    }
+
+    std::fill(buffer.begin(), buffer.end(), 0);
+    flash.ReadMapped(&buffer[3], base + 101, 517);
+    Check(!std::memcmp(&buffer[3], &data[1], 517), "memory-mapped read data");
+    CheckReads("memory-mapped read");
+    CheckSequence("memory-mapped read", {0x05, 0x6B});
+
+    // The next indirect command has to abort memory-mapped mode first
+    flash.Read(buffer.data(), base, 16);
+    Check(fake.counters.aborts == 1, "memory-mapped mode aborted");
+    CheckSequence("read after mapped", {0x05, 0x6B});
+
+    Check(flash.Writable(base + 1024, 1024), "erased range is writable");
+    Check(flash.Writable(base + 701, 17), "unaligned erased range is writable");
+    Check(!flash.Writable(base, 1024), "programmed range isn't writable");
+    Check(!flash.Writable(base + 699, 1), "last programmed byte isn't writable");
+    CheckErrors("blank checks");
+    fake.ClearLog();
+
+    flash.PowerDown();
+    CheckSequence("power down", {0x05, 0xB9});
+    flash.Init();
+    fake.ClearLog();
+}
+
+struct Throughput
+{
+    double mb_per_s;
+    uint32_t commands;
+};
+
+template <typename Operation>
+Throughput Measure(uint32_t bytes, Operation operation)
+{
+    fake.ClearLog();
+    double start = fake.now_us;
+    operation();
+    CheckErrors("throughput");
+    double elapsed = fake.now_us - start;
+    return {bytes / elapsed, fake.counters.commands};
+}
+
+// Writable() before memory-mapped mode: reads of 1 KB into a buffer through
+// byte-wide MDMA, then a check of each byte
+bool LegacyWritable(Flash &flash, uint32_t location, uint32_t length)
+{
+    uint8_t buffer[1024 + 1];
+
+    while (length)
+    {
+        uint32_t len = std::min<uint32_t>(1024, length);
+        flash.Read(buffer + 1, location, len);
+
+        for (uint32_t i = 0; i < len; i++)
+        {
+            if (buffer[1 + i] != Flash::kFillByte)
+            {
+                return false;
+            }
+        }
+
+        location += len;
+        length -= len;
+    }
+
+    return true;
+}
+
+void TestThroughput(Flash &flash)
+{
+    std::printf("Throughput (simulated):\n");
+
+    // The saved recording, loaded a chunk at a time as SampleMemory does
+    const uint32_t address = 0x20000;
+    auto load = std::make_unique<uint32_t[]>(kLoadSize / 4 + 1);
+    auto bytes = reinterpret_cast<uint8_t*>(load.get());
+    Random random;
+
+    for (uint32_t i = 0; i < kLoadSize; i++)
+    {
+        fake.memory[address + i] = random.Next();
+    }
+
+    auto load_with = [&](auto read, uint32_t offset)
+    {
+        return Measure(kLoadSize, [&]()
+        {
+            for (uint32_t i = 0; i < kLoadSize; i += kLoadChunk)
+            {
+                uint32_t size = std::min(kLoadChunk, kLoadSize - i);
+                (flash.*read)(bytes + offset + i, address + i, size);
+            }
+        });
+    };
+
+    struct
+    {
+        const char *name;
+        Throughput result;
+        uint32_t offset;
+    }
+    loads[] =
+    {
+        {"word MDMA", load_with(&Flash::Read, 0), 0},
+        {"byte MDMA (unaligned)", load_with(&Flash::Read, 1), 1},
+        {"memory-mapped copy", load_with(&Flash::ReadMapped, 0), 0},
+    };
+
+    for (auto &load : loads)
+    {
+        std::printf("  boot load %-22s %6.2f MB/s  %5.1f ms for %u KB\n",
+            load.name, load.result.mb_per_s,
+            kLoadSize / load.result.mb_per_s / 1000, kLoadSize / 1024);
+    }
+
+    Check(!std::memcmp(bytes, &fake.memory[address], kLoadSize),
+        "loaded data");
+
+    for (uint32_t size : {4096u, 65536u})
+    {
+        const uint32_t blank = 0x400000;
+        bool legacy_ok = false;
+        bool mapped_ok = false;
+        Throughput legacy = Measure(size, [&]()
+        {
+            legacy_ok = LegacyWritable(flash, blank, size);
+        });
+        Throughput mapped = Measure(size, [&]()
+        {
+            mapped_ok = flash.Writable(blank, size);
+        });
+        Check(legacy_ok && mapped_ok, "blank check");
+
+        std::printf("  blank check %2u KB: byte MDMA + copy %6.2f MB/s (%u commands), "
+            "memory-mapped %6.2f MB/s (%u commands)\n", size / 1024,
+            legacy.mb_per_s, legacy.commands, mapped.mb_per_s, mapped.commands);
+    }
+}
+
+void Pass(void)
+{
+    system::Delay_ms(1);
+}
+
+// Counts the erases in the log by size
+struct EraseCounts
+{
+    uint32_t block64;
+    uint32_t block32;
+    uint32_t sector;
+};
+
+EraseCounts CountErases(void)
+{
+    EraseCounts counts = {};
+
+    for (const Command &command : fake.log)
+    {
+        counts.block64 += (command.instruction == 0xD8);
+        counts.block32 += (command.instruction == 0x52);
+        counts.sector += (command.instruction == 0xD7);
+    }
+
+    return counts;
+}
+
+bool Blank(uint32_t location, uint32_t length)
+{
+    return std::all_of(&fake.memory[location], &fake.memory[location + length],
+        [](uint8_t byte) { return byte == 0xFF; });
+}
+
+// The scheduler on its own: a range that's partly blank, partly programmed,
+// and doesn't start on a block boundary, serviced once per 1 ms pass
+void TestEraseAhead(Flash &flash)
+{
+    std::printf("Erase ahead (simulated):\n");
+
+    const uint32_t location = 0x300000 - 3 * Flash::kEraseGranularity;
+    const uint32_t length = 512 * 1024;
+    Random random;
+
+    // An old recording over the first 200 KB, and another 4 KB further on
+    for (uint32_t i = 0; i < 200 * 1024; i++)
+    {
+        fake.memory[location + i] = random.Next();
+    }
+
+    fake.memory[location + 400 * 1024 + 17] = 0;
+
+    auto erase_ahead = std::make_unique<EraseAhead<Flash>>(flash);
+    erase_ahead->Init();
+
+    auto run = [&](const char *what)
+    {
+        fake.ClearLog();
+        double start = fake.now_us;
+        uint32_t passes = 0;
+
+        while (!erase_ahead->Service(location, length))
+        {
+            Pass();
+            passes++;
+        }
+
+        CheckErrors(what);
+        Check(Blank(location, length), what);
+        EraseCounts counts = CountErases();
+        std::printf("  %-24s %4u passes, %7.1f ms: %u x 64 KB, %u x 32 KB, "
+            "%u x 4 KB erases, %u checks\n", what, passes,
+            (fake.now_us - start) / 1000, counts.block64, counts.block32,
+            counts.sector, erase_ahead->stats().checks);
+        return counts;
+    };
+
+    EraseCounts cold = run("from boot");
+
+    // 3 sectors to the block boundary, 3 blocks for the old recording and
+    // one for the stray byte; blank blocks are only checked
+    Check(cold.sector == 3 && cold.block64 == 4 && cold.block32 == 0,
+        "largest blocks, and only where needed");
+    Check(erase_ahead->erased_bytes(location, length) == length, "all known erased");
+
+    // Once known, a range needs no more checks or erases
+    uint32_t checks = erase_ahead->stats().checks;
+    EraseCounts again = run("known erased");
+    Check(again.sector + again.block32 + again.block64 == 0, "nothing erased again");
+    Check(erase_ahead->stats().checks == checks, "nothing checked again");
+
+    // A write makes its block need erasing again, and only that block
+    uint32_t address = location + 300 * 1024;
+    erase_ahead->Invalidate(address, 1000);
+    flash.Write(address, &fake.memory[0x10000], 1000);
+    EraseCounts rewritten = run("after a write");
+    Check(rewritten.block64 == 1 && rewritten.sector + rewritten.block32 == 0,
+        "only the written block erased");
+}
+
+struct SaveTimes
+{
+    double stop_ms;
+    double erase_ms;
+    double write_ms;
+    double commit_ms;
+    double total_ms;
+};
+
+// Records a full recording into SampleMemory, gives the main loop
+// `idle_passes` passes of ServiceErase() while recording, then saves it one
+// step per pass as the main loop's save states take them, and checks what
+// was saved
+SaveTimes Save(SampleMemory<uint8_t> &memory, uint32_t idle_passes)
+{
+    memory.StartRecording();
+
+    std::vector<uint8_t> recording(kLoadSize);
+    Random random;
+
+    for (uint8_t &byte : recording)
+    {
+        byte = random.Next();
+        memory.Append(byte);
+    }
+
+    for (uint32_t i = 0; i < idle_passes; i++)
+    {
+        memory.ServiceErase();
+        Pass();
+    }
+
+    fake.ClearLog();
+    double start = fake.now_us;
+    memory.StopRecording();
+    double stopped = fake.now_us;
+    Pass();
+
+    Check(memory.dirty() && memory.BeginErase(), "save started");
+    Pass();
+
+    while (!memory.FinishErase())
+    {
+        Pass();
+    }
+
+    double erased = fake.now_us;
+    Pass();
+
+    while (!memory.write_complete())
+    {
+        Check(memory.BeginWrite(), "link write started");
+        Pass();
+
+        while (!memory.FinishWrite())
+        {
+            Pass();
+        }
+
+        Pass();
+    }
+
+    double written = fake.now_us;
+    Check(memory.Commit(), "save committed");
+    double committed = fake.now_us;
+    CheckErrors("save");
+
+    for (const Command &command : fake.log)
+    {
+        Check(command.instruction != 0x02, "pages programmed on one line");
+    }
+
+    // As the next boot finds it
+    RecordingInfo info = {};
+    SampleMemory<uint8_t>::Store store{memory.flash()};
+    store.Init();
+    Crc crc;
+    crc.Init();
+    Check(store.Newest(info), "recording found");
+    Check(info.codec == kSampleCodec && info.sample_rate == kAudioSampleRateHz,
+        "recording format");
+    Check(info.size > 0 && info.size <= kLoadSize, "saved size");
+    Check(!std::memcmp(&fake.memory[info.address], recording.data(), info.size),
+        "saved recording");
+    Check(info.crc32 == crc.Process(recording.data(), info.size), "saved CRC");
+
+    const SampleSaveStats &stats = memory.save_stats();
+    Check(stats.stop_to_saved_ms == uint32_t(committed / 1000) - uint32_t(start / 1000),
+        "stop to saved metric");
+
+    return
+    {
+        .stop_ms = (stopped - start) / 1000,
+        .erase_ms = (erased - stopped) / 1000,
+        .write_ms = (written - erased) / 1000,
+        .commit_ms = (committed - written) / 1000,
+        .total_ms = (committed - start) / 1000,
+    };
+}
+
+// Full recordings saved through SampleMemory: the first with nothing erased
+// ahead, the next after the main loop has had time to erase its space
+void TestSave(void)
+{
+    std::printf("Save (simulated):\n");
+
+    auto memory = std::make_unique<SampleMemory<uint8_t>>();
+    memory->Init();
+
+    struct
+    {
+        const char *name;
+        uint32_t idle_passes;
+    }
+    saves[] =
+    {
+        {"nothing erased ahead", 0},
+        {"after 5 s idle", 5000},
+    };
+
+    for (auto &save : saves)
+    {
+        SaveTimes times = Save(*memory, save.idle_passes);
+        const SampleSaveStats &stats = memory->save_stats();
+        std::printf("  %-21s stop %.1f ms, erase %.1f ms, write %.1f ms, "
+            "commit %.1f ms: stop to saved %.1f ms (%u KB erased ahead)\n",
+            save.name, times.stop_ms, times.erase_ms, times.write_ms,
+            times.commit_ms, times.total_ms, stats.erased_ahead / 1024);
+    }
+
+    Check(memory->save_stats().saves == 2, "save count");
+    Check(memory->save_stats().erase_ms < 5, "erased ahead");
+    Check(memory->store().stats().recordings == 2, "both recordings kept");
+}
+
+// Boots on the recording TestSave() left, reads it back decoded, then plays
+// it through, servicing the memory once per simulated millisecond as the
+// main loop does
+void TestBoot(void)
+{
+    using Codec = SampleCodec<kSampleCodec>;
+    using Memory = SampleMemory<uint8_t>;
+
+    std::printf("Boot (simulated):\n");
+
+    auto memory = std::make_unique<Memory>();
+    memory->Init();
+    Check(memory->streaming() == kEnableFlashStreaming, "streamed at boot");
+
+    while (memory->loading())
+    {
+        memory->ServiceLoad();
+    }
+
+    RecordingInfo info = {};
+    Check(memory->store().Newest(info), "recording found");
+    Check(memory->length() == info.size, "length");
+
+    // What the saved words decode to
+    std::vector<uint8_t> words(kLoadSize);
+    Random random;
+
+    for (uint8_t &word : words)
+    {
+        word = random.Next();
+    }
+
+    uint32_t frames = info.size / Codec::kFrameWords;
+    std::vector<float> expected(frames * Codec::kFrameLength);
+
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        Codec::Decode(&words[f * Codec::kFrameWords],
+            &expected[f * Codec::kFrameLength]);
+    }
+
+    auto coded = std::make_unique<CodedMemory<Codec, Memory>>(*memory);
+    Check(coded->length() == expected.size(), "decoded length");
+
+    // Read forward at the playback rate
+    memory->StartPlayback(false);
+    auto cursor = coded->cursor();
+    uint32_t mismatches = 0;
+
+    for (uint32_t i = 0; i < expected.size(); i++)
+    {
+        if (i % kAudioBlockSize == 0)
+        {
+            memory->ServiceStream(false, 1);
+        }
+
+        cursor.Seek(i);
+        mismatches += (*cursor != expected[i]);
+    }
+
+    Check(mismatches == 0, "decoded recording");
+
+    // Played in reverse, as SamplePlayer drives the prefetch
+    SamplePlayer<CodedMemory<Codec, Memory>> player(*coded);
+    player.Init();
+    player.Play();
+    memory->StartPlayback(true);
+    uint32_t underruns = memory->stream_stats().underruns;
+    uint32_t samples = 0;
+
+    while (!player.ended())
+    {
+        if (samples++ % kAudioBlockSize == 0)
+        {
+            memory->ServiceStream(player.reverse(), player.speed());
+        }
+
+        player.Process(1, false, true);
+    }
+
+    underruns = memory->stream_stats().underruns - underruns;
+    std::printf("  %s, %u samples played in reverse, %u underruns\n",
+        memory->streaming() ? "streamed" : "loaded", samples, underruns);
+    Check(samples >= expected.size(), "played to the start");
+    Check(underruns == 0, "no underruns");
+}
+
+}
+
+int main(void)
+{
+    auto flash = std::make_unique<Flash>();
+
+    TestSequences(*flash);
+    TestThroughput(*flash);
+    TestEraseAhead(*flash);
+
+    // SampleMemory has a Flash of its own, so this one lets go of the
+    // peripheral first
+    flash->PowerDown();
+    TestSave();
+    TestBoot();
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
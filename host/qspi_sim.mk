@@ -0,0 +1,18 @@
+TARGET := qspi_sim
+SOURCES := qspi_sim.cpp
+
+TGT_CXX := $(HOST_CXX)
+TGT_LINKER := $(HOST_CXX)
+
+# The fakes in host/fake stand in for the drivers' hardware headers, so they
+# have to come before the top of the tree
+TGT_CXXFLAGS := -O3 -std=gnu++2a \
+	-Ihost/fake \
+	-Wall \
+	-Wextra \
+	-Wno-undef \
+	-Wdouble-promotion \
+	-ffast-math \
+	-fsingle-precision-constant
+
+TGT_LDLIBS := -lm
@@ -0,0 +1,513 @@
+// Checks RecordingStore on simulated NVM, driven the way SampleMemory drives
+// it: space erased ahead by EraseAhead, audio programmed before the commit,
+// and compaction run from the main loop while there's nothing to save.
+//
+//     make recording_store_sim
+//     build/<variant>/artifact/recording_store_sim
+//
+// Power loss: a session of saves, deletes and idle time on a 1 MB part is
+// run once to learn which recordings the store holds after each step, then
+// again with power lost during each program and erase in turn. After each
+// cut the device boots on what was left; it has to find the recordings from
+// before the step or those from after it, with their audio intact, and take
+// a new save.
+//
+// Wear: a longer session over the 8 MB part, with SampleMemory's sizes,
+// reports how evenly the sectors were erased, what compaction added to the
+// programming, and what a commit cost as the store filled.
+
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "drivers/erase_ahead.h"
+#include "drivers/recording_store.h"
+#include "host/simulated_nvm.h"
+#include "util/random.h"
+
+using namespace recorder;
+
+namespace
+{
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Recordings by id, and the seed of the audio in each
+using Recordings = std::vector<std::pair<uint32_t, uint32_t>>;
+
+void Fill(std::vector<uint8_t> &audio, uint32_t seed)
+{
+    Random random;
+    random.Seed(seed);
+
+    for (uint32_t i = 0; i < audio.size(); i += 4)
+    {
+        uint32_t word = random.Next();
+        std::memcpy(&audio[i], &word, std::min<size_t>(4, audio.size() - i));
+    }
+}
+
+template <typename NVM, uint32_t max_size, uint32_t alignment>
+class Device
+{
+public:
+    using Store = RecordingStore<NVM, max_size, alignment>;
+
+    NVM &nvm;
+    Store store{nvm};
+    EraseAhead<NVM> erase_ahead{nvm};
+
+    // Bytes of audio programmed by saves
+    uint64_t saved_bytes = 0;
+
+    // Of the last Append()
+    uint32_t commit_events = 0;
+    uint32_t commit_reads = 0;
+
+    bool compact = true;
+
+    Device(NVM &nvm) : nvm{nvm} {}
+
+    void Boot(void)
+    {
+        erase_ahead.Init();
+        store.Init();
+    }
+
+    // SampleMemory::ServiceErase()
+    void Idle(void)
+    {
+        if (!store.moving() &&
+            !erase_ahead.Service(store.head(), Store::kMaxSlotSize))
+        {
+            return;
+        }
+
+        if (!compact)
+        {
+            return;
+        }
+
+        uint32_t head = store.head();
+        bool moving = store.moving();
+        store.ServiceCompaction();
+
+        if (!moving && store.moving())
+        {
+            erase_ahead.Invalidate(head, store.move_length());
+        }
+    }
+
+    // As SampleMemory saves a recording, with the seed of its audio kept
+    // where the CRC would be
+    bool Save(uint32_t seed, uint32_t size)
+    {
+        store.AbortCompaction();
+        uint32_t slot = store.head();
+
+        while (!erase_ahead.Service(slot, Store::kHeaderSize + size))
+        {
+            if (!nvm.powered())
+            {
+                return false;
+            }
+        }
+
+        std::vector<uint8_t> audio(size);
+        Fill(audio, seed);
+        uint32_t address = slot + Store::kHeaderSize;
+        erase_ahead.Invalidate(address, size);
+
+        for (uint32_t offset = 0; offset < size; offset += kChunkSize)
+        {
+            uint32_t length = std::min(kChunkSize, size - offset);
+
+            if (!nvm.Write(address + offset, &audio[offset], length))
+            {
+                return false;
+            }
+        }
+
+        saved_bytes += size;
+        erase_ahead.Invalidate(slot, Store::kHeaderSize);
+
+        RecordingInfo info =
+        {
+            .address = 0,
+            .size = size,
+            .crc32 = seed,
+            .id = 0,
+            .sample_rate = 16000,
+            .codec = 0,
+            .word_size = 1,
+        };
+
+        uint32_t events = nvm.events;
+        uint32_t reads = nvm.cost.reads;
+        bool ok = store.Append(info);
+        commit_events = nvm.events - events;
+        commit_reads = nvm.cost.reads - reads;
+        return ok;
+    }
+
+    // The live recordings, checking the audio of each against its seed
+    Recordings Live(void)
+    {
+        Recordings recordings;
+
+        store.ForEach([&](const RecordingInfo &info)
+        {
+            std::vector<uint8_t> audio(info.size);
+            std::vector<uint8_t> expected(info.size);
+            Fill(expected, info.crc32);
+            nvm.Read(audio.data(), info.address, info.size);
+            Check(audio == expected, "recording audio intact");
+            recordings.push_back({info.id, info.crc32});
+        });
+
+        std::sort(recordings.begin(), recordings.end());
+        return recordings;
+    }
+
+protected:
+    static constexpr uint32_t kChunkSize = 4 * 1024;
+};
+
+// A step of a session, chosen from the state of the store, so a replay makes
+// the same choices up to where it's cut
+template <typename Device>
+void Step(Device &device, Random &random, uint32_t step, uint32_t max_size,
+    uint32_t idle_passes)
+{
+    uint32_t choice = random.Next() % 8;
+
+    if (choice < 4)
+    {
+        uint32_t size = 1024 + random.Next() % (max_size - 1024 + 1);
+        device.Save(step + 1, size);
+    }
+    else if (choice < 6)
+    {
+        std::vector<uint32_t> ids;
+
+        device.store.ForEach([&](const RecordingInfo &info)
+        {
+            ids.push_back(info.id);
+        });
+
+        if (!ids.empty())
+        {
+            device.store.Delete(ids[random.Next() % ids.size()]);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < idle_passes && device.nvm.powered(); i++)
+        {
+            device.Idle();
+        }
+    }
+}
+
+constexpr uint32_t kCutSize = 1024 * 1024;
+constexpr uint32_t kCutMaxRecording = 160 * 1024;
+constexpr uint32_t kCutAlignment = 16 * 1024;
+constexpr uint32_t kCutSteps = 160;
+constexpr uint32_t kCutIdlePasses = 300;
+constexpr uint32_t kSessionSeed = 7;
+constexpr uint32_t kAudioCutStride = 16;
+
+using CutNVM = SimulatedNVM<kCutSize>;
+using CutDevice = Device<CutNVM, kCutMaxRecording, kCutAlignment>;
+
+// Runs the session until power is lost, returning the step it was lost in.
+// Without a cut, fills in the recordings after each step and the store's
+// stats at the end.
+uint32_t RunSession(CutNVM &nvm, std::vector<Recordings> *states,
+    RecordingStoreStats *stats)
+{
+    auto device = std::make_unique<CutDevice>(nvm);
+    device->Boot();
+    Random random;
+    random.Seed(kSessionSeed);
+
+    for (uint32_t step = 0; step < kCutSteps; step++)
+    {
+        Step(*device, random, step, kCutMaxRecording, kCutIdlePasses);
+
+        if (!nvm.powered())
+        {
+            return step;
+        }
+
+        if (states)
+        {
+            states->push_back(device->Live());
+            Check(device->store.stats().recordings == states->back().size(),
+                "recording count");
+        }
+    }
+
+    if (stats)
+    {
+        *stats = device->store.stats();
+    }
+
+    return kCutSteps;
+}
+
+void TestPowerLoss(void)
+{
+    std::printf("Power loss (%u KB part, recordings up to %u KB):\n",
+        kCutSize / 1024, kCutMaxRecording / 1024);
+
+    // The store's contents after each step, from none before the first
+    std::vector<Recordings> states = {{}};
+    auto reference = std::make_unique<CutNVM>();
+    RecordingStoreStats stats = {};
+    RunSession(*reference, &states, &stats);
+    uint32_t events = reference->events;
+
+    uint32_t cuts = 0;
+    uint32_t before = 0;
+    uint32_t after = 0;
+    uint32_t rolled_forward = 0;
+    uint32_t start_failures = failures;
+
+    for (uint32_t event = 0; event < events; event++)
+    {
+        // Cut during every header, directory block, delete and erase, and
+        // a sample of the audio programs between them
+        const NVMEvent &logged = reference->event_log[event];
+
+        if (!logged.erase && logged.length >= 1024 && event % kAudioCutStride)
+        {
+            continue;
+        }
+
+        auto nvm = std::make_unique<CutNVM>();
+        nvm->CutPowerAt(event, event);
+        uint32_t step = RunSession(*nvm, nullptr, nullptr);
+        nvm->Restore();
+        cuts++;
+
+        auto device = std::make_unique<CutDevice>(*nvm);
+        device->Boot();
+        Recordings found = device->Live();
+        rolled_forward += device->store.stats().rolled_forward;
+
+        if (found == states[step])
+        {
+            before++;
+        }
+        else if (found == states[step + 1])
+        {
+            after++;
+        }
+        else
+        {
+            std::printf("  cut at event %u, in step %u: %zu recordings found, "
+                "%zu before, %zu after\n", event, step, found.size(),
+                states[step].size(), states[step + 1].size());
+            Check(false, "recordings from before or after the step");
+        }
+
+        Check(device->Save(0xC0FFEE, 10 * 1024), "save after the cut");
+
+        auto rebooted = std::make_unique<CutDevice>(*nvm);
+        rebooted->Boot();
+        RecordingInfo newest = {};
+        Check(rebooted->store.Newest(newest) && newest.crc32 == 0xC0FFEE,
+            "new save found");
+
+        if (failures - start_failures > 10)
+        {
+            break;
+        }
+    }
+
+    uint32_t erases = 0;
+    uint32_t small = 0;
+
+    for (const NVMEvent &event : reference->event_log)
+    {
+        erases += event.erase;
+        small += (!event.erase && event.length < 1024);
+    }
+
+    std::printf("  %u steps, %u evicted, %u moved by compaction\n", kCutSteps,
+        stats.evicted, stats.moved);
+    std::printf("  %u events: %u erases, %u audio programs, %u header and "
+        "directory programs; cut at %u\n", events, erases,
+        events - erases - small, small, cuts);
+    std::printf("  %u found the step undone, %u found it done (%u rolled "
+        "forward at boot)\n", before, after, rolled_forward);
+}
+
+// Saved recordings in a layout the store doesn't use are ignored
+void TestOtherLayout(void)
+{
+    std::printf("Other save data:\n");
+
+    struct AudioInfo
+    {
+        uint32_t address;
+        uint32_t size;
+        uint32_t crc32;
+    };
+
+    auto nvm = std::make_unique<CutNVM>();
+    SaveData<CutNVM, AudioInfo, CutNVM::kEraseGranularity * 2> legacy{*nvm};
+    legacy.Init();
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        legacy.Save({0x2000, 1000 + i, i});
+    }
+
+    auto device = std::make_unique<CutDevice>(*nvm);
+    device->Boot();
+    Check(device->store.stats().recordings == 0, "nothing found");
+    Check(device->Save(1, 1024), "saved");
+
+    auto rebooted = std::make_unique<CutDevice>(*nvm);
+    rebooted->Boot();
+    Recordings found = rebooted->Live();
+    Check(found == Recordings{{1, 1}}, "save found");
+    std::printf("  100 blocks of a single recording's save data: %zu "
+        "recordings found after a save\n", found.size());
+}
+
+// SampleMemory's
+constexpr uint32_t kWearSize = 8 * 1024 * 1024;
+constexpr uint32_t kWearMaxRecording = 863 * 1024;
+constexpr uint32_t kWearAlignment = 64 * 1024;
+constexpr uint32_t kWearSteps = 2000;
+constexpr uint32_t kWearIdlePasses = 2000;
+
+struct WearResults
+{
+    uint32_t saves;
+    RecordingStoreStats stats;
+    uint32_t most_erased;
+    double mean_erased;
+    double amplification;   // Bytes programmed per byte of audio saved
+    uint32_t commit_events;
+    uint32_t commit_reads;
+    uint32_t most_recordings;
+    double mean_recordings; // Live, after each step
+};
+
+WearResults RunWear(bool compact)
+{
+    using NVM = SimulatedNVM<kWearSize>;
+    using WearDevice = Device<NVM, kWearMaxRecording, kWearAlignment>;
+
+    auto nvm = std::make_unique<NVM>();
+    auto device = std::make_unique<WearDevice>(*nvm);
+    device->compact = compact;
+    device->Boot();
+    Random random;
+    random.Seed(kSessionSeed);
+    WearResults results = {};
+
+    for (uint32_t step = 0; step < kWearSteps; step++)
+    {
+        uint64_t saved = device->saved_bytes;
+        uint32_t recordings = device->store.stats().recordings;
+        Step(*device, random, step, kWearMaxRecording, kWearIdlePasses);
+
+        results.mean_recordings += device->store.stats().recordings;
+
+        if (device->saved_bytes != saved)
+        {
+            results.saves++;
+            results.commit_events =
+                std::max(results.commit_events, device->commit_events);
+            results.commit_reads =
+                std::max(results.commit_reads, device->commit_reads);
+            results.most_recordings =
+                std::max(results.most_recordings, recordings);
+        }
+    }
+
+    uint64_t programmed = 0;
+
+    for (const NVMEvent &event : nvm->event_log)
+    {
+        programmed += event.erase ? 0 : event.length;
+    }
+
+    // Over the sectors recordings go in
+    auto begin = nvm->erase_counts.begin() + kWearAlignment / NVM::kEraseGranularity;
+    auto end = nvm->erase_counts.end();
+    double total = 0;
+
+    for (auto it = begin; it != end; it++)
+    {
+        total += *it;
+    }
+
+    results.stats = device->store.stats();
+    results.most_erased = *std::max_element(begin, end);
+    results.mean_erased = total / (end - begin);
+    results.amplification = programmed / double(device->saved_bytes);
+    results.mean_recordings /= kWearSteps;
+    return results;
+}
+
+// The same session with and without compaction
+void TestWear(void)
+{
+    std::printf("Wear (%u MB part, recordings up to %u KB, %u steps):\n",
+        kWearSize / (1024 * 1024), kWearMaxRecording / 1024, kWearSteps);
+    std::printf("  %-13s %5s %7s %5s %4s  %17s  %10s\n", "", "saves",
+        "evicted", "moved", "live", "erases per sector", "programmed");
+
+    WearResults with = {};
+
+    for (bool compact : {false, true})
+    {
+        WearResults results = RunWear(compact);
+        std::printf("  %-13s %5u %7u %5u %4.1f  most %3u, mean %5.1f  "
+            "x%.2f audio\n", compact ? "compaction" : "no compaction",
+            results.saves, results.stats.evicted, results.stats.moved,
+            results.mean_recordings, results.most_erased, results.mean_erased,
+            results.amplification);
+        with = results;
+    }
+
+    std::printf("  commit: at most %u programs and erases and %u reads, with "
+        "up to %u recordings stored\n", with.commit_events, with.commit_reads,
+        with.most_recordings);
+
+    Check(with.most_erased < with.mean_erased * double(1.2),
+        "erases spread evenly");
+    Check(with.stats.moved > 0, "compaction ran");
+}
+
+}
+
+int main(void)
+{
+    TestPowerLoss();
+    TestOtherLayout();
+    TestWear();
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
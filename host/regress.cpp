@@ -0,0 +1,374 @@
+// Golden-audio regression harness. Renders every scenario script in
+// host/scenarios through SynthEngine and compares it with the reference WAV of
+// the same name in host/golden, either bit for bit or within a tolerance.
+//
+//     make regress
+//     build/<variant>/artifact/regress [options] [scenario ...]
+//
+// With --device the scenarios go through ProcessBlock() and the upsampler in
+// the device's blocks, as the DAC sees them, and are compared with the
+// references in host/golden/device. make regress runs both.
+//
+// Run it from the top of the tree. After an intentional change to the sound,
+// check the new output by ear and re-bless the references with --bless.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "common/config.h"
+#include "host/control_script.h"
+#include "host/script_renderer.h"
+#include "host/wav_file.h"
+
+using namespace recorder;
+
+namespace
+{
+
+struct Options
+{
+    std::string scenario_dir = "host/scenarios";
+    std::string golden_dir;
+    std::vector<std::string> names;
+    RenderSettings settings;
+    bool exact = false;
+    bool bless = false;
+    float max_abs = 1e-3;
+    float min_snr = 60;
+    uint32_t jobs = 0;
+};
+
+struct Result
+{
+    std::string name;
+    bool pass = false;
+    bool identical = true;
+    uint32_t frames = 0;
+    float max_abs = 0;
+    double signal = 0;
+    double noise = 0;
+    std::string message;
+
+    float snr(void) const
+    {
+        if (noise == 0)
+        {
+            return INFINITY;
+        }
+
+        return 10 * std::log10(signal / noise);
+    }
+};
+
+void Usage(const char *name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options] [scenario ...]\n"
+        "  --exact          require bit-identical output\n"
+        "  --max-abs X      largest allowed sample error (default 1e-3)\n"
+        "  --snr DB         smallest allowed SNR against the reference (default 60)\n"
+        "  --block N        frames per control update (default 1, or %u with\n"
+        "                   --device)\n"
+        "  --device         render at %u Hz through ProcessBlock() and the\n"
+        "                   upsampler, as the DAC sees it\n"
+        "  --bless          write the references instead of comparing\n"
+        "  --scenarios DIR  scenario scripts (default host/scenarios)\n"
+        "  --golden DIR     reference audio (default host/golden, or\n"
+        "                   host/golden/device with --device)\n"
+        "  -j N             parallel jobs (default: one per core)\n",
+        name, kAudioBlockSize, kAudioSampleRateHz * kAudioOSFactor);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    options.settings.block_size = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--exact"))
+        {
+            options.exact = true;
+        }
+        else if (!std::strcmp(arg, "--bless"))
+        {
+            options.bless = true;
+        }
+        else if (!std::strcmp(arg, "--device"))
+        {
+            options.settings.device = true;
+        }
+        else if (!std::strcmp(arg, "--max-abs") && value)
+        {
+            options.max_abs = std::strtof(value, nullptr);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--snr") && value)
+        {
+            options.min_snr = std::strtof(value, nullptr);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--block") && value)
+        {
+            options.settings.block_size = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--scenarios") && value)
+        {
+            options.scenario_dir = value;
+            i++;
+        }
+        else if (!std::strcmp(arg, "--golden") && value)
+        {
+            options.golden_dir = value;
+            i++;
+        }
+        else if (!std::strcmp(arg, "-j") && value)
+        {
+            options.jobs = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.names.push_back(arg);
+        }
+    }
+
+    if (options.settings.block_size == 0)
+    {
+        options.settings.block_size = options.settings.device ?
+            kAudioBlockSize : 1;
+    }
+
+    if (options.golden_dir.empty())
+    {
+        options.golden_dir = options.settings.device ? "host/golden/device" :
+            "host/golden";
+    }
+
+    if (options.settings.block_size < 1 ||
+        options.settings.block_size > RenderSettings::kMaxBlockSize)
+    {
+        std::fprintf(stderr, "Block size must be 1 to %zu\n", RenderSettings::kMaxBlockSize);
+        return false;
+    }
+
+    return true;
+}
+
+// Every *.txt in the scenario directory, by name
+std::vector<std::string> FindScenarios(const std::string &dir)
+{
+    std::vector<std::string> names;
+    std::error_code error;
+
+    for (const auto &entry : std::filesystem::directory_iterator(dir, error))
+    {
+        if (entry.path().extension() == ".txt")
+        {
+            names.push_back(entry.path().stem().string());
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+void Bless(const Options &options, const ControlScript &script, Result &result)
+{
+    std::string path = options.golden_dir + "/" + result.name + ".wav";
+    WavWriter wav;
+
+    uint32_t sample_rate = options.settings.output_rate(kAudioSampleRateHz);
+
+    if (!wav.Open(path.c_str(), sample_rate, WavWriter::FORMAT_FLOAT32))
+    {
+        result.message = "can't write " + path;
+        return;
+    }
+
+    bool ok = RenderScript<kAudioSampleRateHz>(script, options.settings,
+        [&](const float *samples, size_t count)
+        {
+            return wav.Write(samples, count);
+        });
+
+    if (!wav.Close() || !ok)
+    {
+        result.message = "can't write " + path;
+        return;
+    }
+
+    result.frames = wav.frames();
+    result.pass = true;
+    result.message = "blessed";
+}
+
+void Compare(const Options &options, const ControlScript &script, Result &result)
+{
+    std::string path = options.golden_dir + "/" + result.name + ".wav";
+    WavReader wav;
+
+    if (!wav.Open(path.c_str()))
+    {
+        result.message = "no reference at " + path;
+        return;
+    }
+
+    if (wav.sample_rate() != options.settings.output_rate(kAudioSampleRateHz))
+    {
+        result.message = "reference sample rate doesn't match";
+        return;
+    }
+
+    bool ok = RenderScript<kAudioSampleRateHz>(script, options.settings,
+        [&](const float *samples, size_t count)
+        {
+            float reference[RenderSettings::kMaxBlockSize * kAudioOSFactor];
+
+            if (wav.Read(reference, count) != count)
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                float error = samples[i] - reference[i];
+                result.identical &=
+                    !std::memcmp(&samples[i], &reference[i], sizeof(float));
+                result.max_abs = std::max(result.max_abs, std::fabs(error));
+                result.signal += double(reference[i]) * double(reference[i]);
+                result.noise += double(error) * double(error);
+            }
+
+            result.frames += count;
+            return true;
+        });
+
+    if (!ok || result.frames != wav.frames())
+    {
+        result.message = "length differs from the reference";
+        return;
+    }
+
+    if (options.exact)
+    {
+        result.pass = result.identical;
+    }
+    else
+    {
+        result.pass = result.max_abs <= options.max_abs &&
+                      (result.noise == 0 || result.snr() >= options.min_snr);
+    }
+}
+
+void Run(const Options &options, Result &result)
+{
+    std::string path = options.scenario_dir + "/" + result.name + ".txt";
+    ControlScript script;
+
+    if (!script.Load(path.c_str()))
+    {
+        result.message = "can't load " + path;
+    }
+    else if (options.bless)
+    {
+        Bless(options, script, result);
+    }
+    else
+    {
+        Compare(options, script, result);
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (options.names.empty())
+    {
+        options.names = FindScenarios(options.scenario_dir);
+    }
+
+    if (options.names.empty())
+    {
+        std::fprintf(stderr, "No scenarios in %s\n", options.scenario_dir.c_str());
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Result> results(options.names.size());
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        results[i].name = options.names[i];
+    }
+
+    // Scenarios are independent, so hand them out to one worker per core
+    uint32_t jobs = options.jobs ? options.jobs : std::thread::hardware_concurrency();
+    jobs = std::clamp<uint32_t>(jobs, 1, results.size());
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::thread> workers;
+
+    for (uint32_t i = 0; i < jobs; i++)
+    {
+        workers.emplace_back([&]()
+        {
+            for (size_t j; (j = next++) < results.size();)
+            {
+                Run(options, results[j]);
+            }
+        });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    uint32_t failures = 0;
+
+    for (const Result &result : results)
+    {
+        failures += !result.pass;
+
+        if (!result.message.empty())
+        {
+            std::printf("%-4s %-20s %s\n", result.pass ? "ok" : "FAIL",
+                result.name.c_str(), result.message.c_str());
+        }
+        else
+        {
+            std::printf("%-4s %-20s %8u frames  %s  max abs %.3g  SNR %.1f dB\n",
+                result.pass ? "ok" : "FAIL", result.name.c_str(), result.frames,
+                result.identical ? "identical" : "differs  ",
+                double(result.max_abs), double(result.snr()));
+        }
+    }
+
+    std::printf("%zu scenarios, %u failed\n", results.size(), failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+// Offline SynthEngine renderer. Plays a control script (see
+// host/control_script.h) through the engine and streams the result to a WAV
+// file, then reports how much faster than real time it ran.
+//
+//     make render
+//     build/<variant>/artifact/render [options] <script> <output.wav>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#include "common/config.h"
+#include "host/control_script.h"
+#include "host/script_renderer.h"
+#include "host/wav_file.h"
+
+using namespace recorder;
+
+namespace
+{
+
+struct Options
+{
+    const char *script_path = nullptr;
+    const char *output_path = nullptr;
+    uint32_t sample_rate = kAudioSampleRateHz;
+    RenderSettings settings;
+    WavWriter::Format format = WavWriter::FORMAT_FLOAT32;
+};
+
+void Usage(const char *name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options] <script> <output.wav>\n"
+        "  --rate HZ    engine sample rate: 16000 (default), 32000, 44100, 48000\n"
+        "  --block N    frames per control update, 1 to %zu (default 1)\n"
+        "  --device     render at %u Hz through ProcessBlock() and the\n"
+        "               upsampler, as the DAC sees it\n"
+        "  --seed N     override the script's seed\n"
+        "  --pcm16      write 16-bit PCM instead of 32-bit float\n",
+        name, RenderSettings::kMaxBlockSize, kAudioSampleRateHz * kAudioOSFactor);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--rate") && value)
+        {
+            options.sample_rate = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--block") && value)
+        {
+            options.settings.block_size = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--seed") && value)
+        {
+            options.settings.seed = std::strtoul(value, nullptr, 0);
+            options.settings.have_seed = true;
+            i++;
+        }
+        else if (!std::strcmp(arg, "--device"))
+        {
+            options.settings.device = true;
+        }
+        else if (!std::strcmp(arg, "--pcm16"))
+        {
+            options.format = WavWriter::FORMAT_PCM16;
+        }
+        else if (arg[0] == '-')
+        {
+            return false;
+        }
+        else if (!options.script_path)
+        {
+            options.script_path = arg;
+        }
+        else if (!options.output_path)
+        {
+            options.output_path = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (!IsRenderRate(options.sample_rate))
+    {
+        std::fprintf(stderr, "Unsupported sample rate %u\n", options.sample_rate);
+        return false;
+    }
+
+    if (options.settings.block_size < 1 ||
+        options.settings.block_size > RenderSettings::kMaxBlockSize)
+    {
+        std::fprintf(stderr, "Block size must be 1 to %zu\n", RenderSettings::kMaxBlockSize);
+        return false;
+    }
+
+    if (options.settings.device && options.sample_rate != kAudioSampleRateHz)
+    {
+        std::fprintf(stderr, "--device only works at %u Hz\n", kAudioSampleRateHz);
+        return false;
+    }
+
+    return options.script_path && options.output_path;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ControlScript script;
+
+    if (!script.Load(options.script_path))
+    {
+        return EXIT_FAILURE;
+    }
+
+    uint32_t output_rate = options.settings.output_rate(options.sample_rate);
+    WavWriter wav;
+
+    if (!wav.Open(options.output_path, output_rate, options.format))
+    {
+        std::fprintf(stderr, "%s: can't open\n", options.output_path);
+        return EXIT_FAILURE;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    bool ok = RenderScript(options.sample_rate, script, options.settings,
+        [&](const float *samples, size_t count)
+        {
+            return wav.Write(samples, count);
+        });
+
+    if (!wav.Close() || !ok)
+    {
+        std::fprintf(stderr, "%s: write failed\n", options.output_path);
+        return EXIT_FAILURE;
+    }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    double seconds = double(wav.frames()) / output_rate;
+
+    std::printf("%s: %.3f s at %u Hz in %.3f s, %.1fx real time\n",
+        options.output_path, seconds, output_rate,
+        elapsed.count(), seconds / elapsed.count());
+
+    return EXIT_SUCCESS;
+}
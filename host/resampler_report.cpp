@@ -0,0 +1,370 @@
+// Compares the linear-interpolating Resampler with SincResampler at a few
+// sizes: the distortion and aliasing each adds to test tones, and the time
+// each takes per output sample.
+//
+//     make resampler_report
+//     build/<variant>/artifact/resampler_report [options]
+//
+// THD+N is what is left of the output once the tone is fitted out of it,
+// relative to the tone, so it includes images and aliases. Rejection is the
+// output level of a tone above the output's Nyquist frequency, relative to
+// the input. SincResampler's stopband starts at the output's Nyquist
+// frequency below a ratio of 1, so every such tone has to come out below
+// kMaxRejection_dB; the linear resampler isn't held to that.
+//
+// The ratios have steps of a few bits, so the resamplers' phase sums are
+// exact and the output frequency is known.
+//
+// Cycles are estimated from host time with the same factors as bench, so
+// they only compare the resamplers with each other.
+
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "util/random.h"
+#include "app/engine/resampler.h"
+#include "app/engine/sinc_resampler.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr size_t kToneLength = 1 << 15;
+constexpr size_t kSettleLength = 1024;  // Outputs left out of the fit
+constexpr size_t kTimedLength = 1 << 20;
+constexpr double kMaxRejection_dB = -60;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+struct Options
+{
+    uint32_t runs = 5;
+    double host_ghz = 3.0;
+    double cycle_ratio = 2.0;
+};
+
+// Resamples `frames` inputs at `ratio` into `out`, returning the number
+// written
+using Process = std::function<size_t(const float *in, size_t frames,
+    float ratio, float *out)>;
+
+struct Contender
+{
+    const char *name;
+    bool band_limited;  // Rejects tones above the output's Nyquist frequency
+    std::function<Process(void)> make;
+};
+
+template <uint32_t taps, uint32_t phases>
+Process MakeSinc(void)
+{
+    auto resampler = std::make_shared<SincResampler<taps, phases, 4>>();
+    resampler->Init();
+    return [=](const float *in, size_t frames, float ratio, float *out)
+    {
+        return resampler->Process(in, frames, ratio, out);
+    };
+}
+
+const Contender kContenders[] =
+{
+    {"linear", false, []() -> Process
+    {
+        auto resampler = std::make_shared<Resampler<16>>();
+        resampler->Init();
+        resampler->Reset();
+        return [=](const float *in, size_t frames, float ratio, float *out)
+        {
+            float *start = out;
+            for (size_t i = 0; i < frames; i++)
+            {
+                resampler->Push(in[i], ratio);
+                while (resampler->Pop(*out)) out++;
+            }
+            return size_t(out - start);
+        };
+    }},
+    {"sinc 16x32", true, MakeSinc<16, 32>},
+    {"sinc 32x32", true, MakeSinc<32, 32>},
+    {"sinc 32x128", true, MakeSinc<32, 128>},
+    {"sinc 48x32", true, MakeSinc<48, 32>},
+};
+
+struct Tone
+{
+    const char *name;
+    float ratio;
+    float frequency;
+    bool rejected;  // Above the output's Nyquist frequency
+};
+
+const Tone kTones[] =
+{
+    {"1k x2",     2.0f,   1000, false},
+    {"5k x2",     2.0f,   5000, false},
+    {"3k x1.6",   1.6f,   3000, false},
+    {"5k x0.8",   0.8f,   5000, false},
+    {"1k x0.5",   0.5f,   1000, false},
+    {"3k x0.5",   0.5f,   3000, false},
+    {"7k x0.8",   0.8f,   7000, true},
+    {"6k x0.5",   0.5f,   6000, true},
+};
+
+const float kTimedRatios[] = {0.5f, 1.0f, 2.0f};
+
+double Decibels(double ratio)
+{
+    return 10 * std::log10(std::max(ratio, double(1e-20)));
+}
+
+// Runs the input through in the engine's blocks
+std::vector<float> Run(const Process &process, const std::vector<float> &in,
+    float ratio)
+{
+    std::vector<float> out(in.size() * 4 + kAudioBlockSize);
+    size_t written = 0;
+
+    for (size_t i = 0; i < in.size(); i += kAudioBlockSize)
+    {
+        size_t count = std::min<size_t>(in.size() - i, kAudioBlockSize);
+        written += process(&in[i], count, ratio, &out[written]);
+    }
+
+    out.resize(written);
+    return out;
+}
+
+// Either THD+N or rejection, in dB
+double Measure(const Contender &contender, const Tone &tone)
+{
+    double w = 2 * std::numbers::pi * double(tone.frequency) /
+        kAudioSampleRateHz;
+    std::vector<float> in(kToneLength);
+
+    for (size_t i = 0; i < in.size(); i++)
+    {
+        in[i] = float(double(0.5) * std::sin(w * double(i)));
+    }
+
+    std::vector<float> out = Run(contender.make(), in, tone.ratio);
+    size_t begin = kSettleLength;
+    size_t end = out.size() - kSettleLength;
+    double total = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        total += double(out[i]) * double(out[i]);
+    }
+
+    if (tone.rejected)
+    {
+        return Decibels(total / double(end - begin) / double(0.125));
+    }
+
+    // Least squares fit of a sine and cosine at the output's frequency
+    double w_out = w / double(tone.ratio);
+    double cc = 0, ss = 0, cs = 0, xc = 0, xs = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        double c = std::cos(w_out * double(i));
+        double s = std::sin(w_out * double(i));
+        cc += c * c;
+        ss += s * s;
+        cs += c * s;
+        xc += double(out[i]) * c;
+        xs += double(out[i]) * s;
+    }
+
+    double det = cc * ss - cs * cs;
+    double a = (xc * ss - xs * cs) / det;
+    double b = (xs * cc - xc * cs) / det;
+    double residual = 0;
+    double fitted = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        double y = a * std::cos(w_out * double(i)) +
+            b * std::sin(w_out * double(i));
+        residual += (double(out[i]) - y) * (double(out[i]) - y);
+        fitted += y * y;
+    }
+
+    return Decibels(residual / fitted);
+}
+
+// Fastest of the runs, in ns per output sample
+double Time(const Contender &contender, const std::vector<float> &in,
+    float ratio, const Options &options)
+{
+    Process process = contender.make();
+    std::vector<float> out(kAudioBlockSize * 4 + 1);
+    volatile float sink = 0;
+    double best = 0;
+
+    for (uint32_t run = 0; run < options.runs; run++)
+    {
+        size_t written = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t done = 0; done < kTimedLength; done += kAudioBlockSize)
+        {
+            size_t i = done % in.size();
+            size_t count = process(&in[i], kAudioBlockSize, ratio, out.data());
+            sink = sink + out[0];
+            written += count;
+        }
+
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        double ns = elapsed.count() / double(written);
+        best = (run == 0 || ns < best) ? ns : best;
+    }
+
+    return best;
+}
+
+void Usage(const char *name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --runs N         timed runs; the fastest is reported (default 5)\n"
+        "  --host-ghz X     host clock, for the cycle estimate (default 3.0)\n"
+        "  --cycle-ratio X  Cortex-M7 cycles per host cycle (default 2.0)\n",
+        name);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--runs") && value)
+        {
+            options.runs = std::strtoul(value, nullptr, 0);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--host-ghz") && value)
+        {
+            options.host_ghz = std::strtod(value, nullptr);
+            i++;
+        }
+        else if (!std::strcmp(arg, "--cycle-ratio") && value)
+        {
+            options.cycle_ratio = std::strtod(value, nullptr);
+            i++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.runs > 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::printf("THD+N and rejection, dB\n%-12s", "");
+
+    for (const Tone &tone : kTones)
+    {
+        std::printf(" %8s", tone.name);
+    }
+
+    std::printf("\n");
+
+    std::vector<std::string> unrejected;
+
+    for (const Contender &contender : kContenders)
+    {
+        std::printf("%-12s", contender.name);
+
+        for (const Tone &tone : kTones)
+        {
+            double level = Measure(contender, tone);
+            std::printf(" %8.1f", level);
+
+            if (contender.band_limited && tone.rejected &&
+                level > kMaxRejection_dB)
+            {
+                unrejected.push_back(std::string(contender.name) + ", " +
+                    tone.name + " rejected");
+            }
+        }
+
+        std::printf("\n");
+    }
+
+    for (const std::string &what : unrejected)
+    {
+        Check(false, what.c_str());
+    }
+
+    std::vector<float> noise(kToneLength);
+    Random random;
+
+    for (float &sample : noise)
+    {
+        sample = 0.5f * random.NextBipolar();
+    }
+
+    double cycles_per_ns = options.host_ghz * options.cycle_ratio;
+    std::printf("\nEstimated M7 cycles per output sample\n%-12s", "");
+
+    for (float ratio : kTimedRatios)
+    {
+        std::printf("     x%-3g", double(ratio));
+    }
+
+    std::printf("\n");
+
+    for (const Contender &contender : kContenders)
+    {
+        std::printf("%-12s", contender.name);
+
+        for (float ratio : kTimedRatios)
+        {
+            std::printf(" %8.0f",
+                Time(contender, noise, ratio, options) * cycles_per_ns);
+        }
+
+        std::printf("\n");
+    }
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
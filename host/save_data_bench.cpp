@@ -0,0 +1,196 @@
+// Compares the costs of finding the freshest SaveData block at boot and the
+// next block to write, on simulated NVM with regions from 8 KB to 1 MB: a
+// read of every block against the binary search over pages and blocks.
+//
+//     make save_data_bench
+//     build/<variant>/artifact/save_data_bench
+//
+// Each region is filled by Save() as the device would fill it, then both
+// searches run over it and have to agree. The last states of each have a
+// block corrupted: the newest, as by a save cut short, which the binary
+// search steps back from, and a page's first block, which it can only hand
+// to the full scan if it comes across it. Times come from a model of the
+// flash's quad reads (a command overhead, and the 32 MB/s qspi_sim measures
+// for MDMA reads), not from the host.
+
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "drivers/save_data.h"
+#include "host/simulated_nvm.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr double kCommand_us = 1;
+constexpr double kBytesPerUs = 32;
+
+double Time_us(const NVMCost &cost)
+{
+    return cost.reads * kCommand_us + cost.bytes / kBytesPerUs;
+}
+
+// Sized for 32-byte blocks, so a 1 MB region stays within SaveData's limit
+// on the number of blocks
+struct __attribute__ ((packed)) Record
+{
+    uint32_t count;
+    uint8_t payload[25];
+};
+
+template <uint32_t size>
+class BenchSaveData : public SaveData<SimulatedNVM<size>, Record, size>
+{
+public:
+    using Base = SaveData<SimulatedNVM<size>, Record, size>;
+    using Base::Base;
+    using Base::FindFreshestBlock;
+    using Base::ScanForFreshestBlock;
+    using Base::NextWritableBlock;
+    using Base::BlockLocation;
+    using Base::kNumBlocks;
+    using Base::kBlocksPerPage;
+    using Base::kBlockSize;
+
+    // NextWritableBlock() as it was: the first writable block anywhere after
+    // the current one
+    int32_t LegacyNextWritableBlock(int32_t current_block_n)
+    {
+        int32_t next_block_n = current_block_n;
+
+        do
+        {
+            next_block_n = (next_block_n + 1) % kNumBlocks;
+
+            if (this->nvmem_.Writable(BlockLocation(next_block_n), kBlockSize))
+            {
+                break;
+            }
+        }
+        while (next_block_n != current_block_n);
+
+        return (next_block_n == current_block_n) ? -1 : next_block_n;
+    }
+};
+
+enum Corruption
+{
+    CORRUPT_NONE,
+    CORRUPT_NEWEST,     // As by a save cut short
+    CORRUPT_HEADER,     // The first block of the middle page
+};
+
+struct State
+{
+    const char *name;
+    uint32_t laps_x4;       // Saves, in quarters of the number of blocks
+    Corruption corruption;
+};
+
+const State kStates[] =
+{
+    {"quarter lap",    1,  CORRUPT_NONE},
+    {"2.75 laps",      11, CORRUPT_NONE},
+    {"3 laps",         12, CORRUPT_NONE},
+    {"2.75, cut",      11, CORRUPT_NEWEST},
+    {"2.75, header",   11, CORRUPT_HEADER},
+};
+
+template <uint32_t size>
+bool Run(void)
+{
+    bool ok = true;
+
+    for (const State &state : kStates)
+    {
+        auto nvm = std::make_unique<SimulatedNVM<size>>();
+        auto save = std::make_unique<BenchSaveData<size>>(*nvm);
+        save->Init();
+
+        uint32_t num_blocks = BenchSaveData<size>::kNumBlocks;
+        uint32_t saves = num_blocks * state.laps_x4 / 4;
+        Record record = {};
+
+        for (uint32_t i = 0; i < saves; i++)
+        {
+            record.count = i;
+            save->Save(record);
+        }
+
+        uint32_t expected_count = saves - 1;
+        int32_t corrupt = -1;
+
+        if (state.corruption == CORRUPT_NEWEST)
+        {
+            corrupt = save->ScanForFreshestBlock();
+            expected_count--;
+        }
+        else if (state.corruption == CORRUPT_HEADER)
+        {
+            corrupt = num_blocks / 2 - num_blocks / 2 % BenchSaveData<size>::kBlocksPerPage;
+        }
+
+        if (corrupt >= 0)
+        {
+            // Clears the checksum
+            uint32_t location = save->BlockLocation(corrupt);
+            nvm->memory[location + BenchSaveData<size>::kBlockSize - 1] = 0;
+        }
+
+        nvm->cost = {};
+        int32_t scanned = save->ScanForFreshestBlock();
+        NVMCost scan = nvm->cost;
+
+        nvm->cost = {};
+        int32_t found = save->FindFreshestBlock();
+        NVMCost search = nvm->cost;
+
+        // Writing the next block from the newest
+        nvm->cost = {};
+        save->LegacyNextWritableBlock(found);
+        NVMCost legacy_next = nvm->cost;
+
+        nvm->cost = {};
+        save->NextWritableBlock(found);
+        NVMCost next = nvm->cost;
+
+        auto loaded = std::make_unique<BenchSaveData<size>>(*nvm);
+        Record data = {};
+        bool pass = (found == scanned) && loaded->Init(data) &&
+            (data.count == expected_count);
+        ok &= pass;
+
+        std::printf("%5u KB %6u  %-12s %6u %9.1f  %5u %7.1f  %9.1f %7.1f  %s\n",
+            size / 1024, num_blocks, state.name, scan.reads, Time_us(scan),
+            search.reads, Time_us(search), Time_us(legacy_next),
+            Time_us(next), pass ? "ok" : "FAIL");
+    }
+
+    return ok;
+}
+
+}
+
+int main(void)
+{
+    std::printf("%8s %6s  %-12s %16s  %13s  %17s\n", "", "", "",
+        "full scan", "search", "next writable us");
+    std::printf("%8s %6s  %-12s %6s %9s  %5s %7s  %9s %7s  %s\n", "region",
+        "blocks", "state", "reads", "us", "reads", "us", "before", "after",
+        "result");
+
+    bool ok = true;
+    ok &= Run<8 * 1024>();
+    ok &= Run<64 * 1024>();
+    ok &= Run<256 * 1024>();
+    ok &= Run<1024 * 1024>();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
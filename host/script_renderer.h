@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "app/engine/synth_engine.h"
+#include "host/control_script.h"
+
+namespace recorder
+{
+
+struct RenderSettings
+{
+    static constexpr size_t kMaxBlockSize = 256;
+
+    uint32_t block_size = 1;     // Frames per control update
+    bool device = false;         // ProcessBlock() and the upsampler
+    bool have_seed = false;      // Override the script's seed
+    uint32_t seed = 0;
+
+    uint32_t output_rate(uint32_t sample_rate) const
+    {
+        return device ? sample_rate * kAudioOSFactor : sample_rate;
+    }
+};
+
+// Play `script` through a fresh SynthEngine, handing the output to
+// `sink(const float *samples, size_t count)` one block at a time. Stops
+// early and returns false if the sink does.
+template <uint32_t sample_rate, typename Sink>
+bool RenderScript(const ControlScript &script, const RenderSettings &settings, Sink &&sink)
+{
+    using Engine = SynthEngine<sample_rate>;
+
+    // The delay line makes the engine too big for the stack
+    auto engine = std::make_unique<Engine>();
+    engine->Init();
+    engine->Seed(settings.have_seed ? settings.seed : script.seed());
+
+    auto frame_at = [](float time) -> uint32_t
+    {
+        return time * sample_rate + 0.5f;
+    };
+
+    uint32_t total_frames = frame_at(script.length());
+
+    ControlScript::State state = {};
+    auto event = script.events().begin();
+    auto end = script.events().end();
+
+    float buffer[RenderSettings::kMaxBlockSize * kAudioOSFactor];
+
+    for (uint32_t frame = 0; frame < total_frames;)
+    {
+        // Controls are sampled at the start of each block, so events land on
+        // the first block boundary at or after their timestamp
+        while (event != end && frame_at(event->time) <= frame)
+        {
+            ControlScript::Apply(*event++, state);
+        }
+
+        typename Engine::ControlSnapshot controls =
+        {
+            .button_pressed = state.pressed(ControlScript::CONTROL_PLAY),
+            .pot_value = state.value[ControlScript::CONTROL_POT_1],
+            .hold = state.pressed(ControlScript::CONTROL_LOOP),
+            .formant_pot_val = state.value[ControlScript::CONTROL_POT_2],
+            .vibrato_pot_val = state.value[ControlScript::CONTROL_POT_3],
+            .freq_select_button = state.pressed(ControlScript::CONTROL_TUNE),
+        };
+
+        uint32_t frames = total_frames - frame;
+        frames = (frames < settings.block_size) ? frames : settings.block_size;
+        uint32_t samples = frames;
+
+        if constexpr (sample_rate == kAudioSampleRateHz)
+        {
+            if (settings.device)
+            {
+                engine->ProcessBlock(buffer, frames, controls);
+                samples *= kAudioOSFactor;
+            }
+            else
+            {
+                engine->RenderBlock(buffer, frames, controls);
+            }
+        }
+        else
+        {
+            engine->RenderBlock(buffer, frames, controls);
+        }
+
+        if (!sink(static_cast<const float *>(buffer), samples))
+        {
+            return false;
+        }
+
+        frame += frames;
+    }
+
+    return true;
+}
+
+// Instantiates RenderScript() for the supported engine rates. Returns false
+// for any other rate.
+template <typename Sink>
+bool RenderScript(uint32_t sample_rate, const ControlScript &script,
+                  const RenderSettings &settings, Sink &&sink)
+{
+    switch (sample_rate)
+    {
+    case 16000: return RenderScript<16000>(script, settings, sink);
+    case 32000: return RenderScript<32000>(script, settings, sink);
+    case 44100: return RenderScript<44100>(script, settings, sink);
+    case 48000: return RenderScript<48000>(script, settings, sink);
+    }
+
+    return false;
+}
+
+constexpr bool IsRenderRate(uint32_t sample_rate)
+{
+    return sample_rate == 16000 || sample_rate == 32000 ||
+           sample_rate == 44100 || sample_rate == 48000;
+}
+
+}
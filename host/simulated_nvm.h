@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "util/random.h"
+
+namespace recorder
+{
+
+struct NVMCost
+{
+    uint32_t reads;
+    uint32_t bytes;
+};
+
+struct NVMEvent
+{
+    bool erase;
+    uint32_t length;
+};
+
+// NVM in RAM for host tools, with the Flash driver's interface: that of
+// NVMemInterface, and the erase calls EraseAhead uses, which erase at once.
+// Programming only clears bits, as on the flash. It counts what is read, and
+// how often each sector is erased.
+//
+// Power loss can be injected: arm it with a number of programs and erases,
+// and the last one is cut short, leaving a program partly done or the range
+// of an erase with random contents, and nothing after it changes memory.
+template <uint32_t size>
+class SimulatedNVM
+{
+public:
+    static constexpr uint32_t kSize = size;
+    static constexpr uint32_t kEraseGranularity = 4 * 1024;
+    static constexpr uint32_t kBlock32Size = 32 * 1024;
+    static constexpr uint32_t kBlock64Size = 64 * 1024;
+    static constexpr uint32_t kWriteGranularity = 1;
+    static constexpr uint8_t kFillByte = 0xFF;
+
+    std::vector<uint8_t> memory = std::vector<uint8_t>(size, kFillByte);
+    std::vector<uint32_t> erase_counts =
+        std::vector<uint32_t>(size / kEraseGranularity, 0);
+    NVMCost cost = {};
+
+    // Programs and erases so far, each one event
+    uint32_t events = 0;
+    std::vector<NVMEvent> event_log;
+
+    // Loses power during the event numbered `event`, from 0
+    void CutPowerAt(uint32_t event, uint32_t seed)
+    {
+        cut_event_ = event;
+        random_.Seed(seed);
+    }
+
+    bool powered(void) const
+    {
+        return events <= cut_event_;
+    }
+
+    // Power back on, with memory as it was left
+    void Restore(void)
+    {
+        cut_event_ = kNever;
+    }
+
+    bool Read(void* dst, uint32_t location, uint32_t length)
+    {
+        cost.reads++;
+        cost.bytes += length;
+        std::memcpy(dst, &memory[location], length);
+        return true;
+    }
+
+    bool Writable(uint32_t location, uint32_t length)
+    {
+        cost.reads++;
+        cost.bytes += length;
+        return std::all_of(&memory[location], &memory[location + length],
+            [](uint8_t byte) { return byte == kFillByte; });
+    }
+
+    bool Write(uint32_t location, const void* src, uint32_t length)
+    {
+        auto bytes = reinterpret_cast<const uint8_t*>(src);
+        uint32_t done = length;
+
+        if (!Event({false, length}))
+        {
+            return false;
+        }
+        else if (!powered())
+        {
+            done = random_.Next() % (length + 1);
+        }
+
+        for (uint32_t i = 0; i < done; i++)
+        {
+            memory[location + i] &= bytes[i];
+        }
+
+        return powered();
+    }
+
+    bool Erase(uint32_t location, uint32_t length)
+    {
+        if (!Event({true, length}))
+        {
+            return false;
+        }
+
+        if (powered())
+        {
+            std::fill_n(&memory[location], length, kFillByte);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < length; i++)
+            {
+                memory[location + i] = random_.Next();
+            }
+        }
+
+        for (uint32_t i = 0; i < length; i += kEraseGranularity)
+        {
+            erase_counts[(location + i) / kEraseGranularity]++;
+        }
+
+        return powered();
+    }
+
+    bool BeginErase(uint32_t location, uint32_t length)
+    {
+        return Erase(location, length);
+    }
+
+    bool FinishErase(void)
+    {
+        return true;
+    }
+
+    bool busy(void)
+    {
+        return false;
+    }
+
+protected:
+    static constexpr uint32_t kNever = 0xFFFFFFFF;
+
+    uint32_t cut_event_ = kNever;
+    Random random_;
+
+    // Counts an event, and returns false once power has been lost before it
+    bool Event(const NVMEvent& event)
+    {
+        if (!powered())
+        {
+            return false;
+        }
+
+        events++;
+        event_log.push_back(event);
+        return true;
+    }
+};
+
+}
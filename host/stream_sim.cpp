@@ -0,0 +1,288 @@
+// Simulates playing a recording from flash through FlashStream. A simulated
+// flash models read latency and throughput, the audio interrupt preempts the
+// main loop while it waits on a read, and SamplePlayer's output is checked
+// sample for sample against the same recording played from RAM.
+//
+//     make stream_sim
+//     build/<variant>/artifact/stream_sim [options]
+//
+// The player's direction and speed drive the prefetch, as they do on the
+// device, and one scenario reverses direction every half second.
+//
+// Each scenario reports the prefetch underruns seen by the audio path. The
+// last one uses a flash too slow for its speed and is expected to
+// underrun; the run fails if any other scenario does, or if the output
+// differs from the RAM reference.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+#include "util/buffer_chain.h"
+#include "util/random.h"
+#include "drivers/flash_stream.h"
+#include "app/engine/sample_player.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr uint32_t kRecordingLength = kAudioSampleRateHz * 10;
+constexpr double kCallbackPeriod_us = 1e6 * kAudioBlockSize / kAudioSampleRateHz;
+constexpr double kMainLoopPeriod_us = 1000;
+
+// Flash with a fixed command latency and a transfer rate. Time spent in a
+// read is handed to `wait` first, so audio callbacks can run meanwhile.
+class SimulatedFlash
+{
+public:
+    double latency_us = 2;
+    double bytes_per_us = 25;       // Quad output read at 50 MHz
+    std::function<void(double)> wait;
+    std::vector<uint8_t> data;
+    double busy_us = 0;
+    double longest_read_us = 0;
+
+    bool Read(void* dst, uint32_t location, uint32_t length)
+    {
+        double duration = latency_us + length / bytes_per_us;
+        busy_us += duration;
+        longest_read_us = std::max(longest_read_us, duration);
+        wait(duration);
+        std::memcpy(dst, &data[location], length);
+        return true;
+    }
+};
+
+// The same recording in RAM, for the reference player
+struct RamMemory
+{
+    using Cursor = BufferChain<float>::Cursor;
+
+    std::vector<float> data;
+    BufferChain<float>::Link link[1];
+    BufferChain<float> chain;
+
+    RamMemory(const std::vector<float>& samples) : data(samples)
+    {
+        link[0] = {data.data(), uint32_t(data.size()), 0};
+        chain.Init(link);
+    }
+
+    uint32_t length(void)
+    {
+        return chain.length();
+    }
+
+    Cursor cursor(void)
+    {
+        return chain.cursor();
+    }
+};
+
+struct Scenario
+{
+    const char *name;
+    float speed;
+    bool reverse;
+    bool loop;
+    double bytes_per_us;
+    double latency_us;
+    bool expect_underruns;
+    double flip_s = 0;      // Reverses the direction of play this often
+};
+
+const Scenario kScenarios[] =
+{
+    {"forward",        1, false, false, 25,    2, false},
+    {"reverse",        1, true,  false, 25,    2, false},
+    {"double speed",   2, false, true,  25,    2, false},
+    {"loop x4",        4, false, true,  25,    2, false},
+    {"reverse loop x4", 4, true, true,  25,    2, false},
+    {"flip every 0.5 s", 1, false, true, 25,   2, false, 0.5},
+    {"1-bit SPI",      1, false, true,  6.25,  2, false},
+    {"slow x4",        4, false, true,  0.05, 50, true},
+};
+
+struct Options
+{
+    double seconds = 20;
+};
+
+using Stream = FlashStream<float, SimulatedFlash>;
+
+struct Result
+{
+    FlashStreamStats stats;
+    uint32_t mismatches;
+    double longest_read_us;
+    double flash_load;
+};
+
+Result Run(const Scenario &scenario, const std::vector<float> &recording,
+           const Options &options)
+{
+    SimulatedFlash flash;
+    flash.latency_us = scenario.latency_us;
+    flash.bytes_per_us = scenario.bytes_per_us;
+    flash.data.resize(recording.size() * sizeof(float));
+    std::memcpy(flash.data.data(), recording.data(), flash.data.size());
+
+    auto stream = std::make_unique<Stream>(flash);
+    stream->Open(0, recording.size());
+    auto ram = std::make_unique<RamMemory>(recording);
+
+    SamplePlayer<Stream> player(*stream);
+    SamplePlayer<RamMemory> reference(*ram);
+    player.Init();
+    reference.Init();
+    player.Play();
+    reference.Play();
+
+    double now = 0;
+    double next_callback = kCallbackPeriod_us;
+    double end = options.seconds * double(1e6);
+    uint32_t mismatches = 0;
+    uint32_t underruns = 0;
+
+    // One block of audio from the interrupt. Samples that underran are
+    // silent by design, so only the rest are compared.
+    auto callback = [&]()
+    {
+        for (uint32_t i = 0; i < kAudioBlockSize; i++)
+        {
+            bool reverse = scenario.reverse;
+
+            if (scenario.flip_s > 0)
+            {
+                reverse ^= uint32_t(next_callback / (scenario.flip_s * double(1e6))) & 1;
+            }
+
+            float a = player.Process(scenario.speed, scenario.loop, reverse);
+            float b = reference.Process(scenario.speed, scenario.loop, reverse);
+            bool underran = stream->stats().underruns != underruns;
+            underruns = stream->stats().underruns;
+            mismatches += (a != b && !underran);
+        }
+    };
+
+    auto run_until = [&](double time)
+    {
+        while (next_callback <= time && next_callback <= end)
+        {
+            callback();
+            next_callback += kCallbackPeriod_us;
+        }
+
+        now = time;
+    };
+
+    flash.wait = [&](double duration)
+    {
+        run_until(now + duration);
+    };
+
+    // Let the first windows load before starting, as the device would
+    // before it starts the audio
+    uint32_t start = scenario.reverse ? recording.size() - 1 : 0;
+    stream->Cue(start);
+
+    for (uint32_t i = 0; i < Stream::kNumWindows; i++)
+    {
+        stream->Service(scenario.reverse, scenario.speed);
+    }
+
+    now = 0;
+    flash.busy_us = 0;
+
+    while (now < end && !player.ended())
+    {
+        stream->Service(player.reverse(), player.speed());
+        run_until(now + kMainLoopPeriod_us);
+    }
+
+    return
+    {
+        .stats = stream->stats(),
+        .mismatches = mismatches,
+        .longest_read_us = flash.longest_read_us,
+        .flash_load = flash.busy_us / now,
+    };
+}
+
+void Usage(const char *name)
+{
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --seconds S  simulated time per scenario (default 20)\n",
+        name);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (!std::strcmp(arg, "--seconds") && value)
+        {
+            options.seconds = std::strtod(value, nullptr);
+            i++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.seconds > 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> recording(kRecordingLength);
+    Random random;
+
+    for (float &sample : recording)
+    {
+        sample = random.NextBipolar();
+    }
+
+    bool ok = true;
+
+    std::printf("%-16s %6s %8s %10s %9s %9s %10s  %s\n", "scenario", "speed",
+        "refills", "underruns", "mismatch", "read us", "flash busy", "result");
+
+    for (const Scenario &scenario : kScenarios)
+    {
+        Result result = Run(scenario, recording, options);
+        bool underran = result.stats.underruns > 0;
+        bool pass = result.mismatches == 0 &&
+            underran == scenario.expect_underruns;
+        ok &= pass;
+
+        std::printf("%-16s %6.2f %8u %10u %9u %9.1f %9.1f%%  %s\n",
+            scenario.name, double(scenario.speed), result.stats.refills,
+            result.stats.underruns, result.mismatches, result.longest_read_us,
+            100 * result.flash_load, pass ? "ok" : "FAIL");
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
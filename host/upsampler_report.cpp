@@ -0,0 +1,172 @@
+// Compares the polyphase Upsampler with what it replaced: AAFilter run at the
+// oversampled rate over each input sample followed by kAudioOSFactor - 1
+// zeros.
+//
+//     make upsampler_report
+//     build/<variant>/artifact/upsampler_report
+//
+// Prints both magnitude responses, from their impulse responses, and their
+// difference. The difference has to stay within kMaxDifference_dB wherever
+// AAFilter's response is above kFloor_dB. Deeper in the stopband the two
+// differ by their coefficients' rounding, so there the Upsampler's highest
+// point only has to stay within kStopbandMargin_dB of AAFilter's. Noise is
+// then run through both, and the SNR of the Upsampler's output against
+// AAFilter's has to stay above kMinSNR_dB.
+
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <numbers>
+#include <vector>
+
+#include "common/config.h"
+#include "util/random.h"
+#include "app/engine/aafilter.h"
+#include "app/engine/upsampler.h"
+
+using namespace recorder;
+
+namespace
+{
+
+constexpr size_t kImpulseLength = 4096;     // Input samples
+constexpr size_t kNoiseLength = 1 << 16;
+constexpr double kStep_Hz = 500;
+constexpr double kFloor_dB = -60;
+constexpr double kMaxDifference_dB = 0.01;
+constexpr double kStopbandMargin_dB = 0.5;
+constexpr double kMinSNR_dB = 100;
+
+uint32_t failures = 0;
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("  FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Oversampled output for the input, both ways
+struct Outputs
+{
+    std::vector<float> aa_filter;
+    std::vector<float> upsampler;
+};
+
+Outputs Run(const std::vector<float> &in)
+{
+    AAFilter<float> aa_filter;
+    Upsampler<float> upsampler;
+    aa_filter.Init();
+    upsampler.Init();
+
+    Outputs out;
+
+    for (float sample : in)
+    {
+        for (uint32_t i = 0; i < kAudioOSFactor; i++)
+        {
+            out.aa_filter.push_back(aa_filter.Process((i == 0) ? sample : 0));
+        }
+
+        float block[kAudioOSFactor];
+        upsampler.Process(sample, block);
+        out.upsampler.insert(out.upsampler.end(), block, block + kAudioOSFactor);
+    }
+
+    return out;
+}
+
+// Magnitude of the impulse response's spectrum at `frequency`, in dB
+double Response_dB(const std::vector<float> &impulse, double frequency)
+{
+    double w = 2 * std::numbers::pi * frequency / double(kAudioOSRate);
+    std::complex<double> sum = 0;
+
+    for (size_t n = 0; n < impulse.size(); n++)
+    {
+        sum += double(impulse[n]) * std::polar(double(1), -w * double(n));
+    }
+
+    return 20 * std::log10(std::max(std::abs(sum), double(1e-20)));
+}
+
+void CheckResponse(void)
+{
+    std::vector<float> impulse(kImpulseLength, 0);
+    impulse[0] = 1;
+    Outputs out = Run(impulse);
+
+    std::printf("%8s %10s %10s %10s\n", "Hz", "AAFilter", "Upsampler",
+        "difference");
+
+    double worst = 0;
+    double stopband[2] = {-1000, -1000};
+
+    for (double f = 0; f <= double(kAudioOSRate) / 2; f += kStep_Hz)
+    {
+        double a = Response_dB(out.aa_filter, f);
+        double b = Response_dB(out.upsampler, f);
+        std::printf("%8.0f %10.3f %10.3f %10.4f\n", f, a, b, b - a);
+
+        if (a > kFloor_dB)
+        {
+            worst = std::max(worst, std::fabs(b - a));
+        }
+
+        if (f >= double(kAudioSampleRate) / 2)
+        {
+            stopband[0] = std::max(stopband[0], a);
+            stopband[1] = std::max(stopband[1], b);
+        }
+    }
+
+    std::printf("largest difference above %.0f dB: %.4f dB\n", kFloor_dB,
+        worst);
+    std::printf("stopband peak: AAFilter %.2f dB, Upsampler %.2f dB\n",
+        stopband[0], stopband[1]);
+    Check(worst < kMaxDifference_dB, "magnitude responses match");
+    Check(stopband[1] < stopband[0] + kStopbandMargin_dB, "stopband");
+}
+
+void CheckNoise(void)
+{
+    std::vector<float> noise(kNoiseLength);
+    Random random;
+
+    for (float &sample : noise)
+    {
+        sample = 0.5f * random.NextBipolar();
+    }
+
+    Outputs out = Run(noise);
+    double signal = 0;
+    double error = 0;
+
+    for (size_t n = 0; n < out.aa_filter.size(); n++)
+    {
+        double d = double(out.upsampler[n]) - double(out.aa_filter[n]);
+        signal += double(out.aa_filter[n]) * double(out.aa_filter[n]);
+        error += d * d;
+    }
+
+    double snr = 10 * std::log10(signal / error);
+    std::printf("noise SNR %.1f dB\n", snr);
+    Check(snr > kMinSNR_dB, "noise SNR");
+}
+
+}
+
+int main(void)
+{
+    CheckResponse();
+    CheckNoise();
+
+    std::printf("%u failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
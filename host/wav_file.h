@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace recorder
+{
+
+// Streaming mono WAV writer for host tools. Samples go straight to the file,
+// and the RIFF sizes are patched in when it is closed, so memory use doesn't
+// depend on the length of the render.
+class WavWriter
+{
+public:
+    enum Format
+    {
+        FORMAT_FLOAT32,
+        FORMAT_PCM16,
+    };
+
+    ~WavWriter()
+    {
+        Close();
+    }
+
+    bool Open(const char *path, uint32_t sample_rate, Format format)
+    {
+        Close();
+
+        file_ = std::fopen(path, "wb");
+        if (!file_)
+        {
+            return false;
+        }
+
+        format_ = format;
+        sample_rate_ = sample_rate;
+        frames_ = 0;
+        return WriteHeader();
+    }
+
+    bool Write(const float *samples, size_t count)
+    {
+        if (format_ == FORMAT_FLOAT32)
+        {
+            frames_ += count;
+            return std::fwrite(samples, sizeof(float), count, file_) == count;
+        }
+
+        int16_t pcm[256];
+
+        while (count)
+        {
+            size_t n = (count < 256) ? count : 256;
+
+            for (size_t i = 0; i < n; i++)
+            {
+                float s = samples[i] * 32768.f;
+                s = (s > 32767.f) ? 32767.f : ((s < -32768.f) ? -32768.f : s);
+                pcm[i] = s + ((s < 0) ? -0.5f : 0.5f);
+            }
+
+            if (std::fwrite(pcm, sizeof(int16_t), n, file_) != n)
+            {
+                return false;
+            }
+
+            frames_ += n;
+            samples += n;
+            count -= n;
+        }
+
+        return true;
+    }
+
+    bool Close(void)
+    {
+        if (!file_)
+        {
+            return true;
+        }
+
+        bool ok = !std::fseek(file_, 0, SEEK_SET) && WriteHeader();
+        ok = !std::fclose(file_) && ok;
+        file_ = nullptr;
+        return ok;
+    }
+
+    uint32_t frames(void) const
+    {
+        return frames_;
+    }
+
+protected:
+    bool WriteHeader(void)
+    {
+        uint16_t bits = (format_ == FORMAT_FLOAT32) ? 32 : 16;
+        uint16_t tag = (format_ == FORMAT_FLOAT32) ? 3 : 1;
+        uint16_t align = bits / 8;
+        uint32_t data_size = frames_ * align;
+
+        uint8_t header[44];
+        std::memcpy(&header[0], "RIFF", 4);
+        Put32(&header[4], 36 + data_size);
+        std::memcpy(&header[8], "WAVEfmt ", 8);
+        Put32(&header[16], 16);
+        Put16(&header[20], tag);
+        Put16(&header[22], 1);
+        Put32(&header[24], sample_rate_);
+        Put32(&header[28], sample_rate_ * align);
+        Put16(&header[32], align);
+        Put16(&header[34], bits);
+        std::memcpy(&header[36], "data", 4);
+        Put32(&header[40], data_size);
+
+        return std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+    }
+
+    static void Put16(uint8_t *p, uint16_t v)
+    {
+        p[0] = v;
+        p[1] = v >> 8;
+    }
+
+    static void Put32(uint8_t *p, uint32_t v)
+    {
+        Put16(p, v);
+        Put16(p + 2, v >> 16);
+    }
+
+    FILE *file_ = nullptr;
+    Format format_;
+    uint32_t sample_rate_;
+    uint32_t frames_;
+};
+
+// Streaming reader for the files WavWriter produces: mono, 32-bit float or
+// 16-bit PCM
+class WavReader
+{
+public:
+    ~WavReader()
+    {
+        Close();
+    }
+
+    bool Open(const char *path)
+    {
+        Close();
+
+        file_ = std::fopen(path, "rb");
+        if (!file_)
+        {
+            return false;
+        }
+
+        uint8_t riff[12];
+        if (std::fread(riff, 1, sizeof(riff), file_) != sizeof(riff) ||
+            std::memcmp(&riff[0], "RIFF", 4) || std::memcmp(&riff[8], "WAVE", 4))
+        {
+            return Fail();
+        }
+
+        bool have_format = false;
+
+        // Walk the chunks up to "data"
+        for (;;)
+        {
+            uint8_t chunk[8];
+            if (std::fread(chunk, 1, sizeof(chunk), file_) != sizeof(chunk))
+            {
+                return Fail();
+            }
+
+            uint32_t size = Get32(&chunk[4]);
+
+            if (!std::memcmp(chunk, "fmt ", 4) && size >= 16)
+            {
+                uint8_t fmt[16];
+                if (std::fread(fmt, 1, sizeof(fmt), file_) != sizeof(fmt))
+                {
+                    return Fail();
+                }
+
+                uint16_t tag = Get16(&fmt[0]);
+                uint16_t channels = Get16(&fmt[2]);
+                uint16_t bits = Get16(&fmt[14]);
+                sample_rate_ = Get32(&fmt[4]);
+
+                if (channels != 1 || !((tag == 3 && bits == 32) || (tag == 1 && bits == 16)))
+                {
+                    return Fail();
+                }
+
+                format_ = (tag == 3) ? WavWriter::FORMAT_FLOAT32 : WavWriter::FORMAT_PCM16;
+                have_format = true;
+                size -= 16;
+            }
+            else if (!std::memcmp(chunk, "data", 4) && have_format)
+            {
+                remaining_ = size / ((format_ == WavWriter::FORMAT_FLOAT32) ? 4 : 2);
+                frames_ = remaining_;
+                return true;
+            }
+
+            if (std::fseek(file_, size + (size & 1), SEEK_CUR))
+            {
+                return Fail();
+            }
+        }
+    }
+
+    // Returns the number of samples read, which is short only at the end of
+    // the file or on error
+    size_t Read(float *samples, size_t count)
+    {
+        count = (count < remaining_) ? count : remaining_;
+        size_t done = 0;
+
+        if (format_ == WavWriter::FORMAT_FLOAT32)
+        {
+            done = std::fread(samples, sizeof(float), count, file_);
+        }
+        else
+        {
+            int16_t pcm[256];
+
+            while (done < count)
+            {
+                size_t n = count - done;
+                n = (n < 256) ? n : 256;
+                n = std::fread(pcm, sizeof(int16_t), n, file_);
+                if (n == 0)
+                {
+                    break;
+                }
+
+                for (size_t i = 0; i < n; i++)
+                {
+                    samples[done + i] = pcm[i] * (1.f / 32768.f);
+                }
+
+                done += n;
+            }
+        }
+
+        remaining_ -= done;
+        return done;
+    }
+
+    void Close(void)
+    {
+        if (file_)
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    uint32_t sample_rate(void) const
+    {
+        return sample_rate_;
+    }
+
+    uint32_t frames(void) const
+    {
+        return frames_;
+    }
+
+protected:
+    bool Fail(void)
+    {
+        Close();
+        return false;
+    }
+
+    static uint16_t Get16(const uint8_t *p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    static uint32_t Get32(const uint8_t *p)
+    {
+        return Get16(p) | (static_cast<uint32_t>(Get16(p + 2)) << 16);
+    }
+
+    FILE *file_ = nullptr;
+    WavWriter::Format format_ = WavWriter::FORMAT_FLOAT32;
+    uint32_t sample_rate_ = 0;
+    uint32_t frames_ = 0;
+    uint32_t remaining_ = 0;
+};
+
+}
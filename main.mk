@@ -10,6 +10,8 @@ ARM_SIZE    := $(GCC_PATH)/arm-none-eabi-size
 ARM_NM      := $(GCC_PATH)/arm-none-eabi-nm
 ARM_GDB     := $(GCC_PATH)/arm-none-eabi-gdb
 
+HOST_CXX    ?= g++
+
 VARIANT_DELAY ?= 0
 VARIANT_LINE_IN ?= 0
 VARIANT_REVERSE ?= 0
@@ -36,7 +38,12 @@ DEFS := VARIANT_DELAY=$(VARIANT_DELAY) \
 	VARIANT_LINE_IN=$(VARIANT_LINE_IN) \
 	VARIANT_REVERSE=$(VARIANT_REVERSE)
 TARGET_DIR := $(BUILD_DIR)/artifact
-SUBMAKEFILES := app.mk
+SUBMAKEFILES := app.mk host/render.mk host/regress.mk \
+	host/bench.mk host/dma_sim.mk host/codec.mk \
+	host/stream_sim.mk host/qspi_sim.mk host/save_data_bench.mk \
+	host/recording_store_sim.mk host/resampler_report.mk \
+	host/formant_report.mk host/upsampler_report.mk host/fastmath_report.mk \
+	host/profiling_zone_sim.mk host/audio_timing_sim.mk
 INCDIRS := .
 
 APP_ELF := $(TARGET_DIR)/app.elf
@@ -55,6 +62,83 @@ APP_HEX := $(TARGET_DIR)/app.hex
 .PHONY: app
 app: $(APP_HEX)
 
+# Host tools
+RENDER := $(TARGET_DIR)/render
+REGRESS := $(TARGET_DIR)/regress
+BENCH := $(TARGET_DIR)/bench
+DMA_SIM := $(TARGET_DIR)/dma_sim
+CODEC := $(TARGET_DIR)/codec
+STREAM_SIM := $(TARGET_DIR)/stream_sim
+QSPI_SIM := $(TARGET_DIR)/qspi_sim
+SAVE_DATA_BENCH := $(TARGET_DIR)/save_data_bench
+RECORDING_STORE_SIM := $(TARGET_DIR)/recording_store_sim
+RESAMPLER_REPORT := $(TARGET_DIR)/resampler_report
+FORMANT_REPORT := $(TARGET_DIR)/formant_report
+UPSAMPLER_REPORT := $(TARGET_DIR)/upsampler_report
+FASTMATH_REPORT := $(TARGET_DIR)/fastmath_report
+PROFILING_ZONE_SIM := $(TARGET_DIR)/profiling_zone_sim
+AUDIO_TIMING_SIM := $(TARGET_DIR)/audio_timing_sim
+
+.PHONY: render
+render: $(RENDER)
+
+.PHONY: regress
+regress: $(REGRESS)
+	$(REGRESS)
+	$(REGRESS) --device
+
+.PHONY: bench
+bench: $(BENCH)
+	$(BENCH)
+
+.PHONY: dma_sim
+dma_sim: $(DMA_SIM)
+	$(DMA_SIM)
+
+.PHONY: codec
+codec: $(CODEC)
+	$(CODEC)
+
+.PHONY: stream_sim
+stream_sim: $(STREAM_SIM)
+	$(STREAM_SIM)
+
+.PHONY: qspi_sim
+qspi_sim: $(QSPI_SIM)
+	$(QSPI_SIM)
+
+.PHONY: save_data_bench
+save_data_bench: $(SAVE_DATA_BENCH)
+	$(SAVE_DATA_BENCH)
+
+.PHONY: recording_store_sim
+recording_store_sim: $(RECORDING_STORE_SIM)
+	$(RECORDING_STORE_SIM)
+
+.PHONY: resampler_report
+resampler_report: $(RESAMPLER_REPORT)
+	$(RESAMPLER_REPORT)
+
+.PHONY: formant_report
+formant_report: $(FORMANT_REPORT)
+	$(FORMANT_REPORT)
+
+.PHONY: upsampler_report
+upsampler_report: $(UPSAMPLER_REPORT)
+	$(UPSAMPLER_REPORT)
+
+.PHONY: fastmath_report
+fastmath_report: $(FASTMATH_REPORT)
+	$(FASTMATH_REPORT)
+
+.PHONY: profiling_zone_sim
+profiling_zone_sim: $(PROFILING_ZONE_SIM)
+	$(PROFILING_ZONE_SIM)
+
+.PHONY: audio_timing_sim
+audio_timing_sim: $(AUDIO_TIMING_SIM)
+	$(AUDIO_TIMING_SIM)
+
 .PHONY: sym
 sym: $(APP_ELF)
 	$(ARM_NM) -CnS $< | less
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <algorithm>
 #include <iterator>
+#include <span>
 
 namespace recorder
 {
@@ -81,6 +83,144 @@ public:
     iter begin() {return iter(chain_, 0);}
     iter end() {return iter(chain_, num_links_);}
 
+    // Sequential access without walking the chain from the start each time.
+    // The cursor caches the link it is in, so stepping forward or back, or
+    // jumping within the link, is O(1); only crossing into another link walks
+    // the chain, and then only from the current one. Indices past the end
+    // read and write a dummy item, like operator[].
+    class Cursor
+    {
+    public:
+        Cursor() {}
+
+        // Can be made before the chain's Init(), but must Seek() before the
+        // first access
+        Cursor(BufferChain* chain) : chain_(chain) {}
+
+        Cursor(BufferChain* chain, uint32_t index) : chain_(chain)
+        {
+            Seek(index);
+        }
+
+        void Seek(uint32_t index)
+        {
+            index_ = index;
+
+            if (index_ - start_ >= length_)
+            {
+                Find();
+            }
+        }
+
+        Cursor& operator++()
+        {
+            Seek(index_ + 1);
+            return *this;
+        }
+
+        Cursor& operator--()
+        {
+            Seek(index_ - 1);
+            return *this;
+        }
+
+        Cursor& operator+=(int32_t delta)
+        {
+            Seek(index_ + delta);
+            return *this;
+        }
+
+        T& operator*() const
+        {
+            return buffer_[index_ - start_];
+        }
+
+        uint32_t index(void) const
+        {
+            return index_;
+        }
+
+        // Block copies, split at the link boundaries. Both stop at the end of
+        // the chain, return the number of items copied, and leave the cursor
+        // after the last one.
+        template <typename U>
+        uint32_t Read(std::span<U> out)
+        {
+            return Copy(out, [](T* items, U* values, uint32_t count)
+                {std::copy_n(items, count, values);});
+        }
+
+        template <typename U>
+        uint32_t Write(std::span<U> in)
+        {
+            return Copy(in, [](T* items, U* values, uint32_t count)
+                {std::copy_n(values, count, items);});
+        }
+
+    protected:
+        BufferChain* chain_ = nullptr;
+        T* buffer_ = nullptr;       // Items [start_, start_ + length_)
+        uint32_t start_ = 0;
+        uint32_t length_ = 0;
+        uint32_t index_ = 0;
+        uint32_t link_ = 0;         // The link last found, and its start
+        uint32_t link_start_ = 0;
+
+        void Find(void)
+        {
+            const Link* links = chain_->chain_;
+            uint32_t num_links = chain_->num_links_;
+
+            while (index_ < link_start_ && link_ > 0)
+            {
+                link_start_ -= links[--link_].length;
+            }
+
+            while (index_ - link_start_ >= links[link_].length &&
+                   link_ + 1 < num_links)
+            {
+                link_start_ += links[link_++].length;
+            }
+
+            if (index_ - link_start_ < links[link_].length)
+            {
+                buffer_ = links[link_].buffer;
+                start_ = link_start_;
+                length_ = links[link_].length;
+            }
+            else
+            {
+                buffer_ = &chain_->dummy_;
+                start_ = index_;
+                length_ = 1;
+            }
+        }
+
+        template <typename U, typename Function>
+        uint32_t Copy(std::span<U> values, Function function)
+        {
+            uint32_t done = 0;
+            uint32_t total_length = chain_->length();
+
+            while (done < values.size() && index_ < total_length)
+            {
+                Seek(index_);
+                uint32_t count = std::min<uint32_t>(values.size() - done,
+                    start_ + length_ - index_);
+                function(&buffer_[index_ - start_], &values[done], count);
+                done += count;
+                index_ += count;
+            }
+
+            return done;
+        }
+    };
+
+    // Positioned at the start of the chain; see Cursor for when it is safe
+    // to make one before Init()
+    Cursor cursor(void) {return Cursor(this);}
+    Cursor cursor(uint32_t index) {return Cursor(this, index);}
+
 protected:
     uint32_t num_links_;
     Link* chain_;
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+#include "common/config.h"
+
+namespace recorder
+{
+
+// Polynomial approximations of the transcendental functions used on the
+// audio path. Coefficients are near-minimax fits over the reduced range;
+// the error bounds are measured over the whole stated domain in single
+// precision, so they include rounding.
+namespace fastmath
+{
+
+constexpr float kInvTwoPi = 0.159154943f;
+constexpr float kSqrt2 = 1.41421356f;
+
+union FloatBits
+{
+    float f;
+    uint32_t i;
+};
+
+// sin(2 * pi * t) for t in [-0.5, 0.5]
+inline float SinTurns(float t)
+{
+    // Fold into [-0.25, 0.25] using sin(pi - x) = sin(x)
+    if (t > 0.25f)
+    {
+        t = 0.5f - t;
+    }
+    else if (t < -0.25f)
+    {
+        t = -0.5f - t;
+    }
+
+    float t2 = t * t;
+    return t * (6.28316404f + t2 * (-41.3371423f + t2 *
+        (81.3407674f - 70.9934192f * t2)));
+}
+
+inline float WrapTurns(float t)
+{
+    int32_t n = t + ((t >= 0) ? 0.5f : -0.5f);
+    return t - n;
+}
+
+// Max absolute error 1.5e-6 for |x| <= 2 pi. The error grows with |x| as the
+// range reduction runs out of bits (1.1e-4 for |x| <= 1000), so keep phases
+// wrapped.
+inline float Sin(float x)
+{
+    return SinTurns(WrapTurns(x * kInvTwoPi));
+}
+
+// Same error as Sin()
+inline float Cos(float x)
+{
+    return SinTurns(WrapTurns(x * kInvTwoPi + 0.25f));
+}
+
+// Max relative error 2.3e-7 for x in [-126, 127.99]. Inputs outside that
+// range are clamped to it, so the result is always a finite normal float.
+inline float Exp2(float x)
+{
+    x = (x < -126.f) ? -126.f : ((x < 127.99f) ? x : 127.99f);
+
+    int32_t i = x;
+    i -= (x < i);
+    float f = x - i;
+
+    FloatBits u = {1.f + f * (0.693153073f + f * (0.24015362f + f *
+        (0.0558263096f + f * (0.00898935019f + f * 0.00187757249f))))};
+    u.i += static_cast<uint32_t>(i) << 23;
+    return u.f;
+}
+
+// Max absolute error 3.2e-6 for x in [2^-24, 2^8], 6e-6 for any positive
+// normal x. Nothing else is checked for: 0 gives -127 rather than -inf,
+// subnormals give -127 or a little more, and negative x gives Log2(-x).
+inline float Log2(float x)
+{
+    FloatBits u = {x};
+    int32_t exponent = static_cast<int32_t>((u.i >> 23) & 0xFF) - 127;
+    u.i = (u.i & 0x007FFFFF) | 0x3F800000;
+
+    // Centre the mantissa on 1 so the polynomial only spans
+    // [sqrt(2) / 2, sqrt(2))
+    if (u.f > kSqrt2)
+    {
+        u.f *= 0.5f;
+        exponent++;
+    }
+
+    float m = u.f - 1.f;
+    return exponent + m * (1.44271348f + m * (-0.721131773f + m *
+        (0.479348431f + m * (-0.367492242f + m * (0.322150605f -
+        0.206576339f * m)))));
+}
+
+// Max relative error 1e-6 for db in [-120, 24], 3.2e-6 for db in
+// [-758, 770]
+inline float DbToGain(float db)
+{
+    return Exp2(db * 0.166096405f); // log2(10) / 20
+}
+
+// Max absolute error 3e-5 dB for gain in [2^-24, 2^8]. Silence gives about
+// -765 dB, from Log2(0), rather than -inf.
+inline float GainToDb(float gain)
+{
+    return 6.02059991f * Log2(gain); // 20 * log10(2)
+}
+
+}
+
+// The functions used by the engines. kEnableFastMath picks between the
+// approximations above and libm. The two differ at 0: libm's Log2() and
+// GainToDb() give -inf there, the approximations a finite value.
+
+inline float Sin(float x)
+{
+    return kEnableFastMath ? fastmath::Sin(x) : std::sin(x);
+}
+
+inline float Cos(float x)
+{
+    return kEnableFastMath ? fastmath::Cos(x) : std::cos(x);
+}
+
+inline float Exp2(float x)
+{
+    return kEnableFastMath ? fastmath::Exp2(x) : std::exp2(x);
+}
+
+inline float Log2(float x)
+{
+    return kEnableFastMath ? fastmath::Log2(x) : std::log2(x);
+}
+
+inline float DbToGain(float db)
+{
+    return kEnableFastMath ? fastmath::DbToGain(db) : std::pow(10.f, db / 20);
+}
+
+inline float GainToDb(float gain)
+{
+    return kEnableFastMath ? fastmath::GainToDb(gain) : 20 * std::log10(gain);
+}
+
+}
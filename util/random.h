@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+namespace recorder
+{
+
+// Small xorshift32 generator. Each user keeps its own instance, so the audio
+// path never touches libc's global rand() state and a render is reproducible
+// from its seed.
+class Random
+{
+public:
+    static constexpr uint32_t kDefaultSeed = 0x2545F491;
+
+    Random()
+    {
+        Seed(kDefaultSeed);
+    }
+
+    void Seed(uint32_t seed)
+    {
+        // Hash the seed so that nearby seeds give unrelated sequences. The
+        // hash is a bijection, so only 0 maps to the all-zero state, which
+        // xorshift can never leave.
+        seed = (seed ^ (seed >> 16)) * 0x7FEB352D;
+        seed = (seed ^ (seed >> 15)) * 0x846CA68B;
+        seed ^= seed >> 16;
+        state_ = seed ? seed : kDefaultSeed;
+    }
+
+    uint32_t Next(void)
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+
+    // Uniform in [0, 1)
+    float NextFloat(void)
+    {
+        return (Next() >> 8) * (1.f / (1 << 24));
+    }
+
+    // Uniform in [-1, 1). The top 24 bits are taken, as NextFloat() takes
+    // them, so every value is exact in a float and none rounds up to 1.
+    float NextBipolar(void)
+    {
+        return (static_cast<int32_t>(Next()) >> 8) * (1.f / (1 << 23));
+    }
+
+    // Uniform in [0, n)
+    uint32_t NextBelow(uint32_t n)
+    {
+        return (static_cast<uint64_t>(Next()) * n) >> 32;
+    }
+
+protected:
+    uint32_t state_;
+};
+
+}